@@ -179,6 +179,25 @@ namespace Ashkal {
       dot(delta, -camera.get_direction()));
   }
 
+  /**
+   * Returns the matrix transforming points from the world space to a
+   * camera's space, equivalent to world_to_view.
+   */
+  inline Matrix make_view_transformation(const Camera& camera) {
+    auto transformation = Matrix::IDENTITY();
+    auto position = Vector(camera.get_position());
+    auto set_row = [&] (int y, const Vector& axis) {
+      transformation.set(0, y, axis.m_x);
+      transformation.set(1, y, axis.m_y);
+      transformation.set(2, y, axis.m_z);
+      transformation.set(3, y, -dot(position, axis));
+    };
+    set_row(0, camera.get_right());
+    set_row(1, camera.get_orientation());
+    set_row(2, -camera.get_direction());
+    return transformation;
+  }
+
   inline std::ostream& operator<<(std::ostream& out, const Camera& camera) {
     return out << "Camera(" << camera.get_position() << ", " <<
       camera.get_direction() << ", " << camera.get_orientation() << ", " <<
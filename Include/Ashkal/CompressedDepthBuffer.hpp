@@ -0,0 +1,439 @@
+#ifndef ASHKAL_COMPRESSED_DEPTH_BUFFER_HPP
+#define ASHKAL_COMPRESSED_DEPTH_BUFFER_HPP
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "Ashkal/Lanes.hpp"
+#include "Ashkal/Material.hpp"
+#include "Ashkal/Raster.hpp"
+#include "Ashkal/Rasterizer.hpp"
+
+namespace Ashkal {
+
+  /**
+   * A depth buffer divided into tiles, each of which is stored as one or two
+   * planes of reciprocal depth while few triangles are visible within it,
+   * and per pixel otherwise. Large surfaces such as floors and walls then
+   * write a single plane per tile rather than a depth per pixel, and depth
+   * tests against a tile stored as planes evaluate the planes rather than
+   * load the tile's pixels. Like the DepthBuffer, depths are stored as their
+   * reciprocals, with 0 being the farthest. It is rendered to only through
+   * the rasterize and rasterize_depth overloads below; the renderers and the
+   * HierarchicalDepthBuffer work on a DepthBuffer, into which the buffer can
+   * be decompressed.
+   */
+  class CompressedDepthBuffer {
+    public:
+
+      /** The width and height in pixels of a tile. */
+      static constexpr auto TILE_SIZE = 8;
+
+      /**
+       * Constructs a CompressedDepthBuffer with every depth set to 0.
+       * @param width The width of the buffer in pixels.
+       * @param height The height of the buffer in pixels.
+       */
+      CompressedDepthBuffer(int width, int height);
+
+      /** Returns the width of the buffer in pixels. */
+      int get_width() const;
+
+      /** Returns the height of the buffer in pixels. */
+      int get_height() const;
+
+      /** Returns the number of columns of tiles. */
+      int get_column_count() const;
+
+      /** Returns the number of rows of tiles. */
+      int get_row_count() const;
+
+      /**
+       * Returns the number of planes a tile is stored as, or 0 if the tile is
+       * stored per pixel.
+       * @param column The column of the tile.
+       * @param row The row of the tile.
+       */
+      int get_plane_count(int column, int row) const;
+
+      /** Returns the reciprocal depth stored at a pixel. */
+      float operator ()(int x, int y) const;
+
+      /** Sets every depth to 0, storing every tile as a single plane. */
+      void clear();
+
+      /**
+       * Performs the depth test of a triangle on the pixels of a tile,
+       * storing the depth of each covered pixel that is nearer than or as
+       * near as the stored depth.
+       * @param inverse_z The plane of the triangle's reciprocal depth, with
+       *        its value given at pixel (0, 0) of this buffer.
+       * @param coverage The pixels of the tile covered by the triangle, where
+       *        bit y * TILE_SIZE + x is set iff pixel (x, y) of the tile is
+       *        covered.
+       * @param column The column of the tile.
+       * @param row The row of the tile.
+       * @return The pixels of the tile that passed the depth test.
+       */
+      std::uint64_t test(const AttributePlane& inverse_z,
+        std::uint64_t coverage, int column, int row);
+
+      /**
+       * Writes the reciprocal depth of every pixel to a DepthBuffer.
+       * @param depth_buffer The DepthBuffer to write to, whose dimensions are
+       *        at least those of this buffer.
+       */
+      void decompress(DepthBuffer& depth_buffer) const;
+
+    private:
+      struct Tile {
+        std::array<AttributePlane, 2> m_planes;
+        std::uint64_t m_mask;
+        int m_plane_count;
+      };
+      int m_width;
+      int m_height;
+      int m_column_count;
+      int m_row_count;
+      std::vector<Tile> m_tiles;
+      DepthBuffer m_pixels;
+      std::vector<std::uint64_t> m_coverage;
+
+      template<typename S>
+      friend void test_tiles(const TriangleSetup& setup, int left, int top,
+        CompressedDepthBuffer& depth_buffer, S&& shader);
+
+      std::uint64_t get_valid_pixels(int column, int row) const;
+      FloatLanes load(const Tile& tile, int x, int y) const;
+      void write(const AttributePlane& inverse_z, std::uint64_t pixels,
+        int column, int row);
+  };
+
+  /**
+   * Evaluates a plane across a run of LANE_COUNT pixels.
+   * @param plane The plane to evaluate.
+   * @param x The column of the run's left most pixel.
+   * @param y The row of the run.
+   */
+  inline FloatLanes evaluate_lanes(const AttributePlane& plane, int x, int y) {
+    return FloatLanes(evaluate(plane, x, y)) + plane.m_dx * make_ramp();
+  }
+
+  /**
+   * Returns the pixels of one row of a tile from a mask of the tile's pixels.
+   * @param pixels The mask of the tile's pixels, where bit
+   *        y * CompressedDepthBuffer::TILE_SIZE + x is pixel (x, y).
+   * @param y The row of the tile.
+   * @return The mask of the row's pixels, where bit x is pixel (x, y).
+   */
+  inline int get_row_pixels(std::uint64_t pixels, int y) {
+    return static_cast<int>(
+      (pixels >> (y * CompressedDepthBuffer::TILE_SIZE)) & 0xFF);
+  }
+
+  /**
+   * Depth tests the part of a triangle that lies within a window of the
+   * screen against a CompressedDepthBuffer, a tile at a time.
+   * @param setup The setup of the triangle to test.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param depth_buffer The buffer storing the window's depths.
+   * @param shader The callable invoked as shader(pixels, column, row) with
+   *        the pixels of each tile that passed the depth test.
+   */
+  template<typename S>
+  void test_tiles(const TriangleSetup& setup, int left, int top,
+      CompressedDepthBuffer& depth_buffer, S&& shader) {
+    const auto TILE_SIZE = CompressedDepthBuffer::TILE_SIZE;
+    auto min_column = std::max(setup.m_min_x - left, 0) / TILE_SIZE;
+    auto max_column =
+      std::min(setup.m_max_x - left, depth_buffer.get_width() - 1) / TILE_SIZE;
+    auto min_row = std::max(setup.m_min_y - top, 0) / TILE_SIZE;
+    auto max_row =
+      std::min(setup.m_max_y - top, depth_buffer.get_height() - 1) / TILE_SIZE;
+    if(min_column > max_column || min_row > max_row) {
+      return;
+    }
+    auto& coverage = depth_buffer.m_coverage;
+    auto column_count = depth_buffer.get_column_count();
+    traverse(setup, left, top, depth_buffer.get_width(),
+      depth_buffer.get_height(), [&] (const AttributeLanes&,
+          MaskLanes mask, int count, int x, int y) {
+        auto bits = static_cast<std::uint64_t>(
+          to_bits(mask) & ((1 << count) - 1));
+        auto offset = (x - left) % TILE_SIZE;
+        auto shift = ((y - top) % TILE_SIZE) * TILE_SIZE;
+        auto index =
+          ((y - top) / TILE_SIZE) * column_count + (x - left) / TILE_SIZE;
+        coverage[index] |= ((bits << offset) & 0xFF) << shift;
+        auto overflow = bits >> (TILE_SIZE - offset);
+        if(overflow != 0) {
+          coverage[index + 1] |= overflow << shift;
+        }
+      });
+    auto inverse_z = setup.m_inverse_z;
+    inverse_z.m_value += inverse_z.m_dx * static_cast<float>(left) +
+      inverse_z.m_dy * static_cast<float>(top);
+    for(auto row = min_row; row <= max_row; ++row) {
+      for(auto column = min_column; column <= max_column; ++column) {
+        auto& tile_coverage = coverage[row * column_count + column];
+        auto pixels = tile_coverage;
+        tile_coverage = 0;
+        if(pixels != 0) {
+          pixels = depth_buffer.test(inverse_z, pixels, column, row);
+          if(pixels != 0) {
+            shader(pixels, column, row);
+          }
+        }
+      }
+    }
+  }
+
+  /**
+   * Rasterizes the part of a triangle that lies within a window of the screen
+   * without shading it, storing the depth of every covered pixel that passes
+   * the depth test into a CompressedDepthBuffer.
+   * @param setup The setup of the triangle to rasterize.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param depth_buffer The buffer storing the window's depths.
+   */
+  inline void rasterize_depth(const TriangleSetup& setup, int left, int top,
+      CompressedDepthBuffer& depth_buffer) {
+    test_tiles(setup, left, top, depth_buffer, [] (std::uint64_t, int, int) {});
+  }
+
+  /**
+   * Rasterizes the part of a triangle that lies within a window of the screen,
+   * shading every covered pixel that passes the depth test against a
+   * CompressedDepthBuffer.
+   * @param setup The setup of the triangle to rasterize.
+   * @param material The material used to shade the triangle.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param frame_buffer The raster storing the window's colors.
+   * @param depth_buffer The buffer storing the window's depths.
+   */
+  inline void rasterize(const TriangleSetup& setup, const Material& material,
+      int left, int top, FrameBuffer& frame_buffer,
+      CompressedDepthBuffer& depth_buffer) {
+    const auto TILE_SIZE = CompressedDepthBuffer::TILE_SIZE;
+    auto& sampler = material.get_diffuseness();
+    auto span = AffineSpan();
+    test_tiles(setup, left, top, depth_buffer,
+      [&] (std::uint64_t pixels, int column, int row) {
+        for(auto y = 0; y != TILE_SIZE; ++y) {
+          auto row_pixels = get_row_pixels(pixels, y);
+          for(auto x = 0; x < TILE_SIZE && row_pixels != 0; x += LANE_COUNT) {
+            auto bits = (row_pixels >> x) & ((1 << LANE_COUNT) - 1);
+            if(bits == 0) {
+              continue;
+            }
+            auto screen_x = left + column * TILE_SIZE + x;
+            auto screen_y = top + row * TILE_SIZE + y;
+            auto count = std::min(LANE_COUNT,
+              frame_buffer.get_width() - (screen_x - left));
+            shade_colors(sampler, setup, span,
+              evaluate(setup, screen_x, screen_y), to_mask(bits), count,
+              screen_x, screen_y,
+              &frame_buffer(screen_x - left, screen_y - top));
+          }
+        }
+      });
+  }
+
+  inline CompressedDepthBuffer::CompressedDepthBuffer(int width, int height)
+      : m_width(width),
+        m_height(height),
+        m_column_count((width + TILE_SIZE - 1) / TILE_SIZE),
+        m_row_count((height + TILE_SIZE - 1) / TILE_SIZE),
+        m_tiles(m_column_count * m_row_count),
+        m_pixels(width, height),
+        m_coverage(m_column_count * m_row_count, 0) {
+    clear();
+  }
+
+  inline int CompressedDepthBuffer::get_width() const {
+    return m_width;
+  }
+
+  inline int CompressedDepthBuffer::get_height() const {
+    return m_height;
+  }
+
+  inline int CompressedDepthBuffer::get_column_count() const {
+    return m_column_count;
+  }
+
+  inline int CompressedDepthBuffer::get_row_count() const {
+    return m_row_count;
+  }
+
+  inline int CompressedDepthBuffer::get_plane_count(int column, int row) const {
+    return m_tiles[row * m_column_count + column].m_plane_count;
+  }
+
+  inline float CompressedDepthBuffer::operator ()(int x, int y) const {
+    auto& tile = m_tiles[(y / TILE_SIZE) * m_column_count + x / TILE_SIZE];
+    if(tile.m_plane_count == 0) {
+      return m_pixels(x, y);
+    }
+    auto bit = (y % TILE_SIZE) * TILE_SIZE + x % TILE_SIZE;
+    auto& plane = tile.m_planes[(tile.m_mask >> bit) & 1];
+    auto run_x = x - x % LANE_COUNT;
+    return evaluate(plane, run_x, y) +
+      plane.m_dx * static_cast<float>(x - run_x);
+  }
+
+  inline void CompressedDepthBuffer::clear() {
+    std::fill(m_tiles.begin(), m_tiles.end(),
+      Tile(std::array{AttributePlane(0, 0, 0), AttributePlane(0, 0, 0)}, 0,
+        1));
+  }
+
+  inline std::uint64_t CompressedDepthBuffer::test(
+      const AttributePlane& inverse_z, std::uint64_t coverage, int column,
+      int row) {
+    auto& tile = m_tiles[row * m_column_count + column];
+    auto valid_pixels = get_valid_pixels(column, row);
+    coverage &= valid_pixels;
+    if(tile.m_plane_count != 0) {
+
+      // A plane's extremes over the tile lie at the tile's corners, so the
+      // whole tile can be rejected, or accepted when it is fully covered,
+      // without evaluating its pixels.
+      auto width = std::min(TILE_SIZE, m_width - column * TILE_SIZE) - 1;
+      auto height = std::min(TILE_SIZE, m_height - row * TILE_SIZE) - 1;
+      auto get_bounds = [&] (const AttributePlane& plane) {
+        auto value = evaluate(plane, column * TILE_SIZE, row * TILE_SIZE);
+        auto dx = plane.m_dx * static_cast<float>(width);
+        auto dy = plane.m_dy * static_cast<float>(height);
+        return std::array{value + std::min(dx, 0.f) + std::min(dy, 0.f),
+          value + std::max(dx, 0.f) + std::max(dy, 0.f)};
+      };
+      auto bounds = get_bounds(inverse_z);
+      auto stored_bounds = get_bounds(tile.m_planes[0]);
+      if(tile.m_plane_count == 2) {
+        auto second_bounds = get_bounds(tile.m_planes[1]);
+        stored_bounds[0] = std::min(stored_bounds[0], second_bounds[0]);
+        stored_bounds[1] = std::max(stored_bounds[1], second_bounds[1]);
+      }
+      if(bounds[1] < stored_bounds[0]) {
+        return 0;
+      } else if(coverage == valid_pixels && bounds[0] > stored_bounds[1]) {
+        tile.m_planes[0] = inverse_z;
+        tile.m_mask = 0;
+        tile.m_plane_count = 1;
+        return coverage;
+      }
+    }
+    auto passed = std::uint64_t(0);
+    for(auto y = 0; y != TILE_SIZE; ++y) {
+      auto row_coverage = get_row_pixels(coverage, y);
+      for(auto x = 0; x < TILE_SIZE && row_coverage != 0; x += LANE_COUNT) {
+        auto bits = (row_coverage >> x) & ((1 << LANE_COUNT) - 1);
+        if(bits == 0) {
+          continue;
+        }
+        auto pixel_x = column * TILE_SIZE + x;
+        auto pixel_y = row * TILE_SIZE + y;
+        auto mask = to_mask(bits) & (evaluate_lanes(inverse_z, pixel_x,
+          pixel_y) >= load(tile, pixel_x, pixel_y));
+        passed |= static_cast<std::uint64_t>(to_bits(mask)) <<
+          (y * TILE_SIZE + x);
+      }
+    }
+    if(passed == 0) {
+      return 0;
+    }
+    if(passed == valid_pixels) {
+      tile.m_planes[0] = inverse_z;
+      tile.m_mask = 0;
+      tile.m_plane_count = 1;
+      return passed;
+    }
+    if(tile.m_plane_count != 0) {
+      if(tile.m_plane_count == 1) {
+        tile.m_planes[1] = inverse_z;
+        tile.m_mask = passed;
+        tile.m_plane_count = 2;
+        return passed;
+      } else if((valid_pixels & ~tile.m_mask & ~passed) == 0) {
+        tile.m_planes[0] = tile.m_planes[1];
+        tile.m_planes[1] = inverse_z;
+        tile.m_mask = passed;
+        return passed;
+      } else if((tile.m_mask & ~passed) == 0) {
+        tile.m_planes[1] = inverse_z;
+        tile.m_mask = passed;
+        return passed;
+      }
+      write(tile.m_planes[0], valid_pixels & ~tile.m_mask, column, row);
+      write(tile.m_planes[1], tile.m_mask, column, row);
+      tile.m_plane_count = 0;
+    }
+    write(inverse_z, passed, column, row);
+    return passed;
+  }
+
+  inline void CompressedDepthBuffer::decompress(
+      DepthBuffer& depth_buffer) const {
+    depth_buffer.overwrite(0, 0, m_width, m_height);
+    for(auto y = 0; y != m_height; ++y) {
+      for(auto x = 0; x < m_width; x += LANE_COUNT) {
+        auto count = std::min(LANE_COUNT, m_width - x);
+        store(load(m_tiles[(y / TILE_SIZE) * m_column_count + x / TILE_SIZE],
+          x, y), &depth_buffer(x, y), count);
+      }
+    }
+  }
+
+  inline std::uint64_t CompressedDepthBuffer::get_valid_pixels(
+      int column, int row) const {
+    auto width = std::min(TILE_SIZE, m_width - column * TILE_SIZE);
+    auto height = std::min(TILE_SIZE, m_height - row * TILE_SIZE);
+    auto row_pixels = (std::uint64_t(1) << width) - 1;
+    auto pixels = std::uint64_t(0);
+    for(auto y = 0; y != height; ++y) {
+      pixels |= row_pixels << (y * TILE_SIZE);
+    }
+    return pixels;
+  }
+
+  inline FloatLanes CompressedDepthBuffer::load(
+      const Tile& tile, int x, int y) const {
+    if(tile.m_plane_count == 0) {
+      return Ashkal::load(m_pixels.data() + y * m_width + x,
+        std::min(LANE_COUNT, m_width - x));
+    }
+    auto depth = evaluate_lanes(tile.m_planes[0], x, y);
+    if(tile.m_plane_count == 1) {
+      return depth;
+    }
+    auto bits = static_cast<int>(tile.m_mask >>
+      ((y % TILE_SIZE) * TILE_SIZE + x % TILE_SIZE)) & ((1 << LANE_COUNT) - 1);
+    return select(
+      to_mask(bits), evaluate_lanes(tile.m_planes[1], x, y), depth);
+  }
+
+  inline void CompressedDepthBuffer::write(const AttributePlane& inverse_z,
+      std::uint64_t pixels, int column, int row) {
+    for(auto y = 0; y != TILE_SIZE; ++y) {
+      auto row_pixels = get_row_pixels(pixels, y);
+      for(auto x = 0; x < TILE_SIZE && row_pixels != 0; x += LANE_COUNT) {
+        auto bits = (row_pixels >> x) & ((1 << LANE_COUNT) - 1);
+        if(bits == 0) {
+          continue;
+        }
+        auto pixel_x = column * TILE_SIZE + x;
+        auto pixel_y = row * TILE_SIZE + y;
+        auto count = std::min(LANE_COUNT, m_width - pixel_x);
+        auto depths = &m_pixels(pixel_x, pixel_y);
+        store(select(to_mask(bits), evaluate_lanes(inverse_z, pixel_x,
+          pixel_y), Ashkal::load(depths, count)), depths, count);
+      }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef ASHKAL_CULLING_HPP
+#define ASHKAL_CULLING_HPP
+#include "Ashkal/Frustum.hpp"
+#include "Ashkal/Plane.hpp"
+#include "Ashkal/Point.hpp"
+
+namespace Ashkal {
+
+  /** Specifies which triangles are culled based on the way they face. */
+  enum class CullMode {
+
+    /** No triangles are culled based on the way they face. */
+    NONE,
+
+    /** Triangles facing away from the camera are culled. */
+    BACK,
+
+    /** Triangles facing towards the camera are culled. */
+    FRONT
+  };
+
+  /** Enumerates the outcomes of testing whether to cull a triangle. */
+  enum class CullResult {
+
+    /** The triangle faces the camera and may be visible. */
+    FRONT_FACING,
+
+    /** The triangle faces away from the camera and may be visible. */
+    BACK_FACING,
+
+    /** The triangle is culled. */
+    CULLED
+  };
+
+  /**
+   * Computes which way a triangle in camera space faces. Vertices are ordered
+   * counter-clockwise when viewed from the front in world space, which the
+   * reflection in the world to view transform turns into a clockwise order in
+   * camera space.
+   * @param a The first vertex of the triangle in camera space.
+   * @param b The second vertex of the triangle in camera space.
+   * @param c The third vertex of the triangle in camera space.
+   * @return A value that is positive if the triangle faces the camera,
+   *         negative if it faces away from the camera and zero if it is seen
+   *         edge on or has no area.
+   */
+  inline float get_facing(const Point& a, const Point& b, const Point& c) {
+    return dot(cross(b - a, c - a), Vector(a));
+  }
+
+  /**
+   * Tests whether a triangle in camera space can be culled before it is
+   * clipped and rasterized. Triangles are culled if they have no area, are
+   * entirely behind one of the frustum's planes, or face in the direction
+   * culled by the cull mode.
+   * @param a The first vertex of the triangle in camera space.
+   * @param b The second vertex of the triangle in camera space.
+   * @param c The third vertex of the triangle in camera space.
+   * @param frustum The camera's frustum in camera space.
+   * @param mode The directions of the triangles to cull.
+   * @param is_double_sided Whether the triangle's material is visible from
+   *        both sides, in which case it is never culled based on its facing.
+   * @return The outcome of the test.
+   */
+  inline CullResult cull(const Point& a, const Point& b, const Point& c,
+      const Frustum& frustum, CullMode mode, bool is_double_sided) {
+    auto facing = get_facing(a, b, c);
+    if(facing == 0) {
+      return CullResult::CULLED;
+    }
+    if(!is_double_sided && ((mode == CullMode::BACK && facing < 0) ||
+        (mode == CullMode::FRONT && facing > 0))) {
+      return CullResult::CULLED;
+    }
+    for(auto i = 0; i != Frustum::PLANE_COUNT; ++i) {
+      auto& plane =
+        frustum.get_plane(static_cast<Frustum::ClippingPlane>(i));
+      if(!is_in_front(plane, a) && !is_in_front(plane, b) &&
+          !is_in_front(plane, c)) {
+        return CullResult::CULLED;
+      }
+    }
+    if(facing < 0) {
+      return CullResult::BACK_FACING;
+    }
+    return CullResult::FRONT_FACING;
+  }
+}
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef ASHKAL_DEPTH_FORMAT_HPP
+#define ASHKAL_DEPTH_FORMAT_HPP
+#include <algorithm>
+#include <cstdint>
+#include "Ashkal/Camera.hpp"
+#include "Ashkal/Lanes.hpp"
+#include "Ashkal/Material.hpp"
+#include "Ashkal/Raster.hpp"
+#include "Ashkal/Rasterizer.hpp"
+
+namespace Ashkal {
+
+  /** The greatest depth stored by a Depth16Buffer. */
+  const auto DEPTH16_MAX = 0xFFFF;
+
+  /** The greatest depth stored by a Depth24Buffer. */
+  const auto DEPTH24_MAX = 0xFFFFFF;
+
+  /** The number of low bits of each value of a Depth24Buffer left to it. */
+  const auto STENCIL_BITS = 8;
+
+  /**
+   * Maps reciprocal depths between a camera's near and far planes onto
+   * [0, 1] so that they can be stored as normalized integers. The mapping is
+   * affine in the reciprocal depth, so normalized depths vary linearly across
+   * the screen just as reciprocal depths do, nearer points map to larger
+   * values, and a cleared depth of 0 remains the farthest.
+   */
+  struct DepthRange {
+
+    /** The reciprocal depth at the far plane, which maps to 0. */
+    float m_far_inverse_z;
+
+    /** The factor mapping the reciprocal depth at the near plane to 1. */
+    float m_scale;
+  };
+
+  /**
+   * Makes the DepthRange spanning a camera's near and far planes.
+   * @param camera The camera depths are measured from.
+   */
+  inline DepthRange make_depth_range(const Camera& camera) {
+    auto near_inverse_z = -1 / (camera.get_near_plane() - 1);
+    auto far_inverse_z = -1 / (camera.get_far_plane() - 1);
+    return DepthRange(far_inverse_z, 1 / (near_inverse_z - far_inverse_z));
+  }
+
+  /**
+   * Quantizes reciprocal depths into normalized integers.
+   * @param range The range of depths mapped onto [0, maximum].
+   * @param inverse_z The reciprocal depths to quantize.
+   * @param maximum The integer the near plane maps to.
+   */
+  inline IntLanes quantize(
+      const DepthRange& range, FloatLanes inverse_z, int maximum) {
+    auto scale = static_cast<float>(maximum);
+    auto depth = max((inverse_z - range.m_far_inverse_z) * range.m_scale,
+      FloatLanes(0));
+    return to_int(min(depth * scale + 0.5f, FloatLanes(scale)));
+  }
+
+  /**
+   * Returns the reciprocal depth stored by a Depth16Buffer.
+   * @param range The range of depths the buffer was written with.
+   * @param depth The stored depth.
+   */
+  inline float to_inverse_z(const DepthRange& range, std::uint16_t depth) {
+    return range.m_far_inverse_z +
+      static_cast<float>(depth) / (DEPTH16_MAX * range.m_scale);
+  }
+
+  /**
+   * Returns the reciprocal depth stored by a Depth24Buffer.
+   * @param range The range of depths the buffer was written with.
+   * @param depth The stored depth and stencil.
+   */
+  inline float to_inverse_z(const DepthRange& range, std::uint32_t depth) {
+    return range.m_far_inverse_z + static_cast<float>(depth >> STENCIL_BITS) /
+      (DEPTH24_MAX * range.m_scale);
+  }
+
+  /** Returns the stencil stored in the low bits of a Depth24Buffer value. */
+  inline std::uint8_t get_stencil(std::uint32_t depth) {
+    return static_cast<std::uint8_t>(depth);
+  }
+
+  /**
+   * Returns a Depth24Buffer value with its stencil replaced.
+   * @param depth The stored depth and stencil.
+   * @param stencil The stencil to store.
+   */
+  inline std::uint32_t set_stencil(std::uint32_t depth, std::uint8_t stencil) {
+    return (depth & ~0xFFu) | stencil;
+  }
+
+  /**
+   * Performs the depth test on a horizontal run of up to LANE_COUNT pixels
+   * of a DepthBuffer, which stores reciprocal depths directly and so ignores
+   * the range of depths.
+   * @param inverse_z The reciprocal depth of each pixel.
+   * @param coverage The mask of pixels covered by the triangle.
+   * @param count The number of pixels in the run.
+   * @param depths The reciprocal depths currently stored at the pixels.
+   * @return The mask of pixels that passed the depth test.
+   */
+  inline MaskLanes test_depth(FloatLanes inverse_z, MaskLanes coverage,
+      int count, const DepthRange&, float* depths) {
+    return test_depth(inverse_z, coverage, count, depths);
+  }
+
+  /**
+   * Performs the depth test on a horizontal run of up to LANE_COUNT pixels
+   * of a Depth16Buffer, storing the depth of each covered pixel that is
+   * nearer than or as near as the stored depth.
+   * @param inverse_z The reciprocal depth of each pixel.
+   * @param coverage The mask of pixels covered by the triangle.
+   * @param count The number of pixels in the run.
+   * @param range The range of depths stored.
+   * @param depths The depths currently stored at the pixels.
+   * @return The mask of pixels that passed the depth test.
+   */
+  inline MaskLanes test_depth(FloatLanes inverse_z, MaskLanes coverage,
+      int count, const DepthRange& range, std::uint16_t* depths) {
+    auto depth = quantize(range, inverse_z, DEPTH16_MAX);
+    auto stored_depth = load(depths, count);
+    auto mask = coverage & (depth >= stored_depth);
+    store(select(mask, depth, stored_depth), depths, count);
+    return mask;
+  }
+
+  /**
+   * Performs the depth test on a horizontal run of up to LANE_COUNT pixels
+   * of a Depth24Buffer, storing the depth of each covered pixel that is
+   * nearer than or as near as the stored depth and keeping its stencil.
+   * @param inverse_z The reciprocal depth of each pixel.
+   * @param coverage The mask of pixels covered by the triangle.
+   * @param count The number of pixels in the run.
+   * @param range The range of depths stored.
+   * @param depths The depths and stencils currently stored at the pixels.
+   * @return The mask of pixels that passed the depth test.
+   */
+  inline MaskLanes test_depth(FloatLanes inverse_z, MaskLanes coverage,
+      int count, const DepthRange& range, std::uint32_t* depths) {
+    auto depth = quantize(range, inverse_z, DEPTH24_MAX);
+    auto values = reinterpret_cast<std::int32_t*>(depths);
+    auto stored = load(values, count);
+    auto mask = coverage & (depth >= (stored >> STENCIL_BITS));
+    store(select(mask, (depth << STENCIL_BITS) | (stored & 0xFF), stored),
+      values, count);
+    return mask;
+  }
+
+  /**
+   * Rasterizes the part of a triangle that lies within a window of the screen
+   * without shading it, storing the depth of every covered pixel that passes
+   * the depth test into a depth buffer of any format.
+   * @param setup The setup of the triangle to rasterize.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param depth_buffer The raster storing the window's depths.
+   * @param range The range of depths stored.
+   */
+  template<typename T>
+  void rasterize_depth(const TriangleSetup& setup, int left, int top,
+      Raster<T>& depth_buffer, const DepthRange& range) {
+    resolve_bounds(setup, left, top, depth_buffer);
+    traverse(setup, left, top, depth_buffer.get_width(),
+      depth_buffer.get_height(), [&] (const AttributeLanes& attributes,
+          MaskLanes coverage, int count, int x, int y) {
+        test_depth(attributes.m_inverse_z, coverage, count, range,
+          &depth_buffer(x - left, y - top));
+      });
+  }
+
+  /**
+   * Rasterizes the part of a triangle that lies within a window of the screen,
+   * shading every covered pixel that passes the depth test against a depth
+   * buffer of any format.
+   * @param setup The setup of the triangle to rasterize.
+   * @param material The material used to shade the triangle.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param frame_buffer The raster storing the window's colors.
+   * @param depth_buffer The raster storing the window's depths.
+   * @param range The range of depths stored.
+   */
+  template<typename T>
+  void rasterize(const TriangleSetup& setup, const Material& material,
+      int left, int top, FrameBuffer& frame_buffer, Raster<T>& depth_buffer,
+      const DepthRange& range) {
+    auto& sampler = material.get_diffuseness();
+    auto span = AffineSpan();
+    resolve_bounds(setup, left, top, frame_buffer);
+    resolve_bounds(setup, left, top, depth_buffer);
+    traverse(setup, left, top, frame_buffer.get_width(),
+      frame_buffer.get_height(), [&] (const AttributeLanes& attributes,
+          MaskLanes coverage, int count, int x, int y) {
+        auto mask = test_depth(attributes.m_inverse_z, coverage, count, range,
+          &depth_buffer(x - left, y - top));
+        if(to_bits(mask) != 0) {
+          shade_colors(sampler, setup, span, attributes, mask, count, x, y,
+            &frame_buffer(x - left, y - top));
+        }
+      });
+  }
+}
+
+#endif
@@ -0,0 +1,323 @@
+#ifndef ASHKAL_DYNAMIC_RESOLUTION_HPP
+#define ASHKAL_DYNAMIC_RESOLUTION_HPP
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "Ashkal/Lanes.hpp"
+#include "Ashkal/Raster.hpp"
+
+namespace Ashkal {
+
+  /**
+   * Upscales a raster into a larger one using bilinear filtering, treating
+   * each pixel as a sample at its center and clamping at the borders.
+   * @param source The raster to upscale.
+   * @param destination The raster to write the upscaled pixels to.
+   */
+  inline void upscale(const FrameBuffer& source, FrameBuffer& destination) {
+    const auto WEIGHT_BITS = 8;
+    const auto WEIGHT_SCALE = 1 << WEIGHT_BITS;
+    auto source_width = source.get_width();
+    auto source_height = source.get_height();
+    auto width = destination.get_width();
+    auto height = destination.get_height();
+    destination.overwrite(0, 0, width, height);
+    auto map = [] (int x, int size, int source_size, int& first, int& second,
+        int& weight) {
+      auto position = std::max(0.f, (static_cast<float>(x) + 0.5f) *
+        static_cast<float>(source_size) / static_cast<float>(size) - 0.5f);
+      first = std::min(static_cast<int>(position), source_size - 1);
+      second = std::min(first + 1, source_size - 1);
+      weight = static_cast<int>(
+        (position - static_cast<float>(first)) * WEIGHT_SCALE + 0.5f);
+    };
+    auto lefts = std::vector<int>(width);
+    auto rights = std::vector<int>(width);
+    auto weights = std::vector<std::int32_t>(width);
+    for(auto x = 0; x != width; ++x) {
+      map(x, width, source_width, lefts[x], rights[x], weights[x]);
+    }
+    auto pixels = reinterpret_cast<const std::int32_t*>(source.data());
+
+    // Bilinear filtering is separable, so each source row is blended
+    // horizontally once into a row of channels, and every destination row is
+    // then a vertical blend of the two filtered rows it lies between, loaded
+    // contiguously. Upscaling makes consecutive destination rows share their
+    // source rows, so the gathers by column, which can't be vectorized, are
+    // done once per source row rather than once per destination row, leaving
+    // the per-frame cost dominated by the contiguous vertical blends.
+    using FilteredRow = std::array<std::vector<std::int32_t>, 4>;
+    auto filter_row = [&] (int y, FilteredRow& channels) {
+      auto row = pixels + y * source_width;
+      auto lefts_pixels = std::array<std::int32_t, LANE_COUNT>();
+      auto rights_pixels = std::array<std::int32_t, LANE_COUNT>();
+      for(auto x = 0; x < width; x += LANE_COUNT) {
+        auto count = std::min(LANE_COUNT, width - x);
+        for(auto i = 0; i != count; ++i) {
+          lefts_pixels[i] = row[lefts[x + i]];
+          rights_pixels[i] = row[rights[x + i]];
+        }
+        auto right_weight = load(weights.data() + x, count);
+        auto left_weight = WEIGHT_SCALE - right_weight;
+        auto left_lanes = load(lefts_pixels.data());
+        auto right_lanes = load(rights_pixels.data());
+        for(auto channel = 0; channel != 4; ++channel) {
+          auto shift = 8 * channel;
+          store(((left_lanes >> shift) & 0xFF) * left_weight +
+            ((right_lanes >> shift) & 0xFF) * right_weight,
+            channels[channel].data() + x, count);
+        }
+      }
+    };
+    auto filtered_rows = std::array<FilteredRow, 2>();
+    for(auto& filtered_row : filtered_rows) {
+      for(auto& channel : filtered_row) {
+        channel.resize(width);
+      }
+    }
+    auto filtered_ys = std::array{-1, -1};
+    auto get_filtered_row = [&] (int y, int kept_y) -> const FilteredRow& {
+      for(auto i = 0; i != 2; ++i) {
+        if(filtered_ys[i] == y) {
+          return filtered_rows[i];
+        }
+      }
+      auto i = filtered_ys[0] == kept_y ? 1 : 0;
+      filter_row(y, filtered_rows[i]);
+      filtered_ys[i] = y;
+      return filtered_rows[i];
+    };
+    for(auto y = 0; y != height; ++y) {
+      auto top = 0;
+      auto bottom = 0;
+      auto row_weight = 0;
+      map(y, height, source_height, top, bottom, row_weight);
+      auto& top_row = get_filtered_row(top, bottom);
+      auto& bottom_row = get_filtered_row(bottom, top);
+      auto lower_weight = IntLanes(row_weight);
+      auto upper_weight = IntLanes(WEIGHT_SCALE - row_weight);
+      auto row = reinterpret_cast<std::int32_t*>(&destination(0, y));
+      for(auto x = 0; x < width; x += LANE_COUNT) {
+        auto count = std::min(LANE_COUNT, width - x);
+        auto color = IntLanes(0);
+        for(auto channel = 0; channel != 4; ++channel) {
+          auto value = (load(top_row[channel].data() + x, count) *
+            upper_weight + load(bottom_row[channel].data() + x, count) *
+            lower_weight + (1 << (2 * WEIGHT_BITS - 1))) >> (2 * WEIGHT_BITS);
+          color = color | ((value & 0xFF) << (8 * channel));
+        }
+        store(color, row + x, count);
+      }
+    }
+  }
+
+  /**
+   * Chooses the resolution frames are rendered at so that rendering a frame
+   * takes about a target amount of time, rendering into pooled rasters at the
+   * chosen resolution and upscaling them to the presentation resolution.
+   * The resolution is scaled equally along both axes by a factor that is a
+   * multiple of 1 / SCALE_STEPS, so that a small set of rasters is reused as
+   * the resolution changes.
+   */
+  class DynamicResolution {
+    public:
+
+      /** The number of steps the scale is quantized to within (0, 1]. */
+      static constexpr auto SCALE_STEPS = 16;
+
+      /**
+       * The fraction of the target frame time below which the average frame
+       * time must fall before the resolution is raised, so that the
+       * resolution does not oscillate around the target.
+       */
+      static constexpr auto HEADROOM = 0.85f;
+
+      /**
+       * The weight given to the latest frame time when averaging frame times.
+       */
+      static constexpr auto SMOOTHING = 0.25f;
+
+      /**
+       * Constructs a DynamicResolution starting at its maximum scale.
+       * @param width The width of the presentation raster.
+       * @param height The height of the presentation raster.
+       * @param target_frame_time The time rendering a frame should take.
+       * @param min_scale The smallest scale to render frames at.
+       * @param max_scale The largest scale to render frames at, at most 1.
+       */
+      DynamicResolution(int width, int height,
+        std::chrono::duration<float> target_frame_time, float min_scale,
+        float max_scale);
+
+      /** Returns the width of the presentation raster. */
+      int get_width() const;
+
+      /** Returns the height of the presentation raster. */
+      int get_height() const;
+
+      /** Returns the time rendering a frame should take. */
+      std::chrono::duration<float> get_target_frame_time() const;
+
+      /** Returns the smallest scale frames are rendered at. */
+      float get_min_scale() const;
+
+      /** Returns the largest scale frames are rendered at. */
+      float get_max_scale() const;
+
+      /** Returns the scale the next frame is rendered at. */
+      float get_scale() const;
+
+      /** Returns the width the next frame is rendered at. */
+      int get_render_width() const;
+
+      /** Returns the height the next frame is rendered at. */
+      int get_render_height() const;
+
+      /** Returns the raster the next frame's colors are rendered to. */
+      FrameBuffer& get_frame_buffer();
+
+      /** Returns the raster the next frame's depths are rendered to. */
+      DepthBuffer& get_depth_buffer();
+
+      /**
+       * Records the time the last frame took to render, adjusting the scale
+       * of the next frame towards the target frame time.
+       * @param frame_time The time the last frame took to render.
+       */
+      void update(std::chrono::duration<float> frame_time);
+
+      /**
+       * Renders and presents a frame, timing its rendering to choose the
+       * scale of the next frame.
+       * @param renderer The callable invoked as renderer(frame_buffer,
+       *        depth_buffer) to render the frame into the pooled rasters.
+       * @param frame_buffer The raster to write the presented frame to.
+       */
+      template<typename R>
+      void render(R&& renderer, FrameBuffer& frame_buffer);
+
+    private:
+      struct RenderTarget {
+        FrameBuffer m_frame_buffer;
+        DepthBuffer m_depth_buffer;
+      };
+      int m_width;
+      int m_height;
+      std::chrono::duration<float> m_target_frame_time;
+      int m_min_step;
+      int m_max_step;
+      int m_step;
+      std::optional<float> m_average_frame_time;
+      std::vector<std::optional<RenderTarget>> m_targets;
+
+      RenderTarget& get_target();
+  };
+
+  inline DynamicResolution::DynamicResolution(int width, int height,
+      std::chrono::duration<float> target_frame_time, float min_scale,
+      float max_scale)
+      : m_width(width),
+        m_height(height),
+        m_target_frame_time(target_frame_time),
+        m_max_step(std::clamp(static_cast<int>(max_scale * SCALE_STEPS), 1,
+          SCALE_STEPS)),
+        m_targets(SCALE_STEPS + 1) {
+    m_min_step = std::clamp(static_cast<int>(std::ceil(min_scale *
+      SCALE_STEPS)), 1, m_max_step);
+    m_step = m_max_step;
+  }
+
+  inline int DynamicResolution::get_width() const {
+    return m_width;
+  }
+
+  inline int DynamicResolution::get_height() const {
+    return m_height;
+  }
+
+  inline std::chrono::duration<float>
+      DynamicResolution::get_target_frame_time() const {
+    return m_target_frame_time;
+  }
+
+  inline float DynamicResolution::get_min_scale() const {
+    return static_cast<float>(m_min_step) / SCALE_STEPS;
+  }
+
+  inline float DynamicResolution::get_max_scale() const {
+    return static_cast<float>(m_max_step) / SCALE_STEPS;
+  }
+
+  inline float DynamicResolution::get_scale() const {
+    return static_cast<float>(m_step) / SCALE_STEPS;
+  }
+
+  inline int DynamicResolution::get_render_width() const {
+    return std::max(1, (m_width * m_step + SCALE_STEPS / 2) / SCALE_STEPS);
+  }
+
+  inline int DynamicResolution::get_render_height() const {
+    return std::max(1, (m_height * m_step + SCALE_STEPS / 2) / SCALE_STEPS);
+  }
+
+  inline FrameBuffer& DynamicResolution::get_frame_buffer() {
+    return get_target().m_frame_buffer;
+  }
+
+  inline DepthBuffer& DynamicResolution::get_depth_buffer() {
+    return get_target().m_depth_buffer;
+  }
+
+  inline void DynamicResolution::update(
+      std::chrono::duration<float> frame_time) {
+    if(m_average_frame_time) {
+      *m_average_frame_time = SMOOTHING * frame_time.count() +
+        (1 - SMOOTHING) * *m_average_frame_time;
+    } else {
+      m_average_frame_time = frame_time.count();
+    }
+    auto target = m_target_frame_time.count();
+    if(*m_average_frame_time > target ||
+        *m_average_frame_time < HEADROOM * target) {
+      // The time to render a frame is assumed to be proportional to the
+      // number of pixels rendered, which is proportional to the square of
+      // the scale.
+      auto scale = get_scale() * std::sqrt(
+        HEADROOM * target / std::max(*m_average_frame_time, 1e-6f));
+      auto step = std::clamp(static_cast<int>(scale * SCALE_STEPS),
+        m_min_step, m_max_step);
+      if(step != m_step) {
+        auto ratio = static_cast<float>(step) / static_cast<float>(m_step);
+        *m_average_frame_time *= ratio * ratio;
+        m_step = step;
+      }
+    }
+  }
+
+  template<typename R>
+  void DynamicResolution::render(R&& renderer, FrameBuffer& frame_buffer) {
+    auto start = std::chrono::steady_clock::now();
+    auto& target = get_target();
+    renderer(target.m_frame_buffer, target.m_depth_buffer);
+    target.m_frame_buffer.resolve();
+    upscale(target.m_frame_buffer, frame_buffer);
+    update(std::chrono::steady_clock::now() - start);
+  }
+
+  inline DynamicResolution::RenderTarget& DynamicResolution::get_target() {
+    auto& target = m_targets[m_step];
+    if(!target) {
+      auto width = get_render_width();
+      auto height = get_render_height();
+      target.emplace(
+        FrameBuffer(width, height), DepthBuffer(width, height));
+    }
+    return *target;
+  }
+}
+
+#endif
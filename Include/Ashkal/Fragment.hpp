@@ -3,6 +3,7 @@
 #include <memory>
 #include <vector>
 #include "Ashkal/Material.hpp"
+#include "Ashkal/Meshlet.hpp"
 #include "Ashkal/VertexTriangle.hpp"
 
 namespace Ashkal {
@@ -28,9 +29,29 @@ namespace Ashkal {
       /** Returns the material of this fragment. */
       const Material& get_material() const;
 
+      /**
+       * Replaces the triangles in this fragment, such as to reorder them,
+       * removing its meshlets.
+       * @param triangles The triangles composing this fragment.
+       */
+      void set_triangles(std::vector<VertexTriangle> triangles);
+
+      /**
+       * Returns the meshlets splitting this fragment's triangles, or an empty
+       * list if the fragment is only culled as a whole.
+       */
+      const std::vector<Meshlet>& get_meshlets() const;
+
+      /**
+       * Sets the meshlets splitting this fragment's triangles.
+       * @param meshlets The meshlets covering every triangle in order.
+       */
+      void set_meshlets(std::vector<Meshlet> meshlets);
+
     private:
       std::vector<VertexTriangle> m_triangles;
       std::shared_ptr<Material> m_material;
+      std::vector<Meshlet> m_meshlets;
   };
 
   inline Fragment::Fragment(
@@ -45,6 +66,19 @@ namespace Ashkal {
   inline const Material& Fragment::get_material() const {
     return *m_material;
   }
+
+  inline void Fragment::set_triangles(std::vector<VertexTriangle> triangles) {
+    m_triangles = std::move(triangles);
+    m_meshlets.clear();
+  }
+
+  inline const std::vector<Meshlet>& Fragment::get_meshlets() const {
+    return m_meshlets;
+  }
+
+  inline void Fragment::set_meshlets(std::vector<Meshlet> meshlets) {
+    m_meshlets = std::move(meshlets);
+  }
 }
 
 #endif
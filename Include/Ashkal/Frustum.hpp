@@ -133,6 +133,27 @@ namespace Ashkal {
     }
     return true;
   }
+
+  /**
+   * Tests whether a bounding box lies entirely inside the frustum.
+   * @param frustum The view frustum.
+   * @param box The bounding box to test.
+   * @return True iff every part of the box lies within the frustum.
+   */
+  inline bool contains(const Frustum& frustum, const BoundingBox& box) {
+    for(auto i = std::size_t(0); i < Frustum::PLANE_COUNT; ++i) {
+      auto& plane = frustum.get_plane(static_cast<Frustum::ClippingPlane>(i));
+      auto corner = Point(
+        plane.m_normal.m_x >= 0 ? box.get_minimum().m_x : box.get_maximum().m_x,
+        plane.m_normal.m_y >= 0 ? box.get_minimum().m_y : box.get_maximum().m_y,
+        plane.m_normal.m_z >= 0 ?
+          box.get_minimum().m_z : box.get_maximum().m_z);
+      if(distance(plane, corner) < 0) {
+        return false;
+      }
+    }
+    return true;
+  }
 }
 
 #endif
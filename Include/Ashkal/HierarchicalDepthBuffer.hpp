@@ -0,0 +1,130 @@
+#ifndef ASHKAL_HIERARCHICAL_DEPTH_BUFFER_HPP
+#define ASHKAL_HIERARCHICAL_DEPTH_BUFFER_HPP
+#include <algorithm>
+#include "Ashkal/Raster.hpp"
+
+namespace Ashkal {
+
+  /**
+   * Stores a conservative bound on the farthest depth within each block of a
+   * DepthBuffer, so that triangles, or the parts of triangles, lying entirely
+   * behind a block's contents can be rejected without testing its pixels.
+   * Like the DepthBuffer, depths are stored as their reciprocals, so the
+   * farthest depth of a block is bounded by a value no greater than any value
+   * stored within the block.
+   */
+  class HierarchicalDepthBuffer {
+    public:
+
+      /** The width and height in pixels of the blocks that are bounded. */
+      static constexpr auto BLOCK_SIZE = 8;
+
+      /**
+       * Constructs a HierarchicalDepthBuffer bounding a DepthBuffer of the
+       * given width and height, with every block bounded by 0.
+       * @param width The width of the DepthBuffer in pixels.
+       * @param height The height of the DepthBuffer in pixels.
+       */
+      HierarchicalDepthBuffer(int width, int height);
+
+      /** Returns the width of the bounded DepthBuffer in pixels. */
+      int get_width() const;
+
+      /** Returns the height of the bounded DepthBuffer in pixels. */
+      int get_height() const;
+
+      /**
+       * Returns the bound on the farthest depth among a rectangle of pixels.
+       * @param min_x The left most column of the rectangle.
+       * @param min_y The top most row of the rectangle.
+       * @param max_x The right most column of the rectangle.
+       * @param max_y The bottom most row of the rectangle.
+       * @return A value no greater than any reciprocal depth stored in the
+       *         blocks overlapping the rectangle.
+       */
+      float get_farthest(int min_x, int min_y, int max_x, int max_y) const;
+
+      /**
+       * Raises the bound of a block after every one of its pixels has been
+       * written with a reciprocal depth of at least a given value.
+       * @param x A column within the block.
+       * @param y A row within the block.
+       * @param inverse_z The least reciprocal depth written to the block.
+       */
+      void raise(int x, int y, float inverse_z);
+
+      /**
+       * Computes the exact bound of every block from a DepthBuffer.
+       * @param depth_buffer The DepthBuffer to bound, whose dimensions are at
+       *        least those of this HierarchicalDepthBuffer.
+       */
+      void build(const DepthBuffer& depth_buffer);
+
+    private:
+      int m_width;
+      int m_height;
+      Raster<float> m_farthest;
+  };
+
+  // Each block lies within a single clear tile, so that building can read a
+  // cleared block as the clear value.
+  static_assert(
+    DepthBuffer::CLEAR_TILE_SIZE % HierarchicalDepthBuffer::BLOCK_SIZE == 0);
+
+  inline HierarchicalDepthBuffer::HierarchicalDepthBuffer(int width, int height)
+      : m_width(width),
+        m_height(height),
+        m_farthest((width + BLOCK_SIZE - 1) / BLOCK_SIZE,
+          (height + BLOCK_SIZE - 1) / BLOCK_SIZE) {
+    m_farthest.fill(0);
+  }
+
+  inline int HierarchicalDepthBuffer::get_width() const {
+    return m_width;
+  }
+
+  inline int HierarchicalDepthBuffer::get_height() const {
+    return m_height;
+  }
+
+  inline float HierarchicalDepthBuffer::get_farthest(
+      int min_x, int min_y, int max_x, int max_y) const {
+    auto farthest = m_farthest(min_x / BLOCK_SIZE, min_y / BLOCK_SIZE);
+    for(auto y = min_y / BLOCK_SIZE; y <= max_y / BLOCK_SIZE; ++y) {
+      for(auto x = min_x / BLOCK_SIZE; x <= max_x / BLOCK_SIZE; ++x) {
+        farthest = std::min(farthest, m_farthest(x, y));
+      }
+    }
+    return farthest;
+  }
+
+  inline void HierarchicalDepthBuffer::raise(int x, int y, float inverse_z) {
+    auto& farthest = m_farthest(x / BLOCK_SIZE, y / BLOCK_SIZE);
+    farthest = std::max(farthest, inverse_z);
+  }
+
+  inline void HierarchicalDepthBuffer::build(const DepthBuffer& depth_buffer) {
+    for(auto block_y = 0; block_y != m_farthest.get_height(); ++block_y) {
+      for(auto block_x = 0; block_x != m_farthest.get_width(); ++block_x) {
+        auto start_x = block_x * BLOCK_SIZE;
+        auto end_x = std::min(start_x + BLOCK_SIZE, m_width);
+        auto start_y = block_y * BLOCK_SIZE;
+        auto end_y = std::min(start_y + BLOCK_SIZE, m_height);
+        if(depth_buffer.is_cleared(
+            start_x, start_y, end_x - start_x, end_y - start_y)) {
+          m_farthest(block_x, block_y) = depth_buffer.get_clear_value();
+          continue;
+        }
+        auto farthest = depth_buffer(start_x, start_y);
+        for(auto y = start_y; y != end_y; ++y) {
+          for(auto x = start_x; x != end_x; ++x) {
+            farthest = std::min(farthest, depth_buffer(x, y));
+          }
+        }
+        m_farthest(block_x, block_y) = farthest;
+      }
+    }
+  }
+}
+
+#endif
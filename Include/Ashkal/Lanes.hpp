@@ -0,0 +1,800 @@
+#ifndef ASHKAL_LANES_HPP
+#define ASHKAL_LANES_HPP
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#if defined(__AVX2__)
+  #define ASHKAL_AVX2
+  #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    defined(_M_IX86_FP) && _M_IX86_FP >= 2
+  #define ASHKAL_SSE
+  #if defined(__SSE4_1__) || defined(__AVX__)
+    #define ASHKAL_SSE4_1
+    #include <smmintrin.h>
+  #else
+    #include <emmintrin.h>
+  #endif
+#endif
+
+namespace Ashkal {
+
+  /**
+   * The number of values operated on at once by FloatLanes and IntLanes,
+   * 8 when compiled for AVX2, otherwise 4 using SSE (taking advantage of
+   * SSE4.1 when available) or a portable scalar fallback.
+   */
+#ifdef ASHKAL_AVX2
+  constexpr auto LANE_COUNT = 8;
+#else
+  constexpr auto LANE_COUNT = 4;
+#endif
+
+  /** Stores a mask selecting a subset of lanes. */
+  struct MaskLanes {
+#if defined(ASHKAL_AVX2)
+    __m256 m_value;
+#elif defined(ASHKAL_SSE)
+    __m128 m_value;
+#else
+    std::array<bool, LANE_COUNT> m_value;
+#endif
+  };
+
+  /** Stores LANE_COUNT floats that are operated on together. */
+  struct FloatLanes {
+#if defined(ASHKAL_AVX2)
+    __m256 m_value;
+#elif defined(ASHKAL_SSE)
+    __m128 m_value;
+#else
+    std::array<float, LANE_COUNT> m_value;
+#endif
+
+    /** Constructs FloatLanes with every lane set to zero. */
+    FloatLanes();
+
+    /** Constructs FloatLanes with every lane set to the same value. */
+    FloatLanes(float value);
+
+#if defined(ASHKAL_AVX2)
+    /** Constructs FloatLanes from a native register. */
+    explicit FloatLanes(__m256 value);
+#elif defined(ASHKAL_SSE)
+    /** Constructs FloatLanes from a native register. */
+    explicit FloatLanes(__m128 value);
+#endif
+  };
+
+  /** Stores LANE_COUNT 32-bit signed integers that are operated on together. */
+  struct IntLanes {
+#if defined(ASHKAL_AVX2)
+    __m256i m_value;
+#elif defined(ASHKAL_SSE)
+    __m128i m_value;
+#else
+    std::array<std::int32_t, LANE_COUNT> m_value;
+#endif
+
+    /** Constructs IntLanes with every lane set to zero. */
+    IntLanes();
+
+    /** Constructs IntLanes with every lane set to the same value. */
+    IntLanes(std::int32_t value);
+
+#if defined(ASHKAL_AVX2)
+    /** Constructs IntLanes from a native register. */
+    explicit IntLanes(__m256i value);
+#elif defined(ASHKAL_SSE)
+    /** Constructs IntLanes from a native register. */
+    explicit IntLanes(__m128i value);
+#endif
+  };
+
+  /** Returns FloatLanes whose i-th lane is equal to i. */
+  inline FloatLanes make_ramp() {
+#if defined(ASHKAL_AVX2)
+    return FloatLanes(_mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7));
+#elif defined(ASHKAL_SSE)
+    return FloatLanes(_mm_setr_ps(0, 1, 2, 3));
+#else
+    auto ramp = FloatLanes();
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      ramp.m_value[i] = static_cast<float>(i);
+    }
+    return ramp;
+#endif
+  }
+
+  /**
+   * Returns a mask selecting the first lanes.
+   * @param count The number of leading lanes to select.
+   */
+  inline MaskLanes make_mask(int count) {
+#if defined(ASHKAL_AVX2)
+    return MaskLanes(_mm256_castsi256_ps(_mm256_cmpgt_epi32(
+      _mm256_set1_epi32(count), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7))));
+#elif defined(ASHKAL_SSE)
+    return MaskLanes(_mm_castsi128_ps(
+      _mm_cmpgt_epi32(_mm_set1_epi32(count), _mm_setr_epi32(0, 1, 2, 3))));
+#else
+    auto mask = MaskLanes();
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      mask.m_value[i] = i < count;
+    }
+    return mask;
+#endif
+  }
+
+  /**
+   * Returns a bit set whose i-th bit is set iff the i-th lane of a mask is
+   * selected.
+   */
+  inline int to_bits(MaskLanes mask) {
+#if defined(ASHKAL_AVX2)
+    return _mm256_movemask_ps(mask.m_value);
+#elif defined(ASHKAL_SSE)
+    return _mm_movemask_ps(mask.m_value);
+#else
+    auto bits = 0;
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      bits |= static_cast<int>(mask.m_value[i]) << i;
+    }
+    return bits;
+#endif
+  }
+
+  /**
+   * Returns a mask selecting the i-th lane iff the i-th bit of a bit set is
+   * set.
+   */
+  inline MaskLanes to_mask(int bits) {
+#if defined(ASHKAL_AVX2)
+    auto lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    return MaskLanes(_mm256_castsi256_ps(_mm256_cmpeq_epi32(
+      _mm256_and_si256(_mm256_set1_epi32(bits), lane_bits), lane_bits)));
+#elif defined(ASHKAL_SSE)
+    auto lane_bits = _mm_setr_epi32(1, 2, 4, 8);
+    return MaskLanes(_mm_castsi128_ps(_mm_cmpeq_epi32(
+      _mm_and_si128(_mm_set1_epi32(bits), lane_bits), lane_bits)));
+#else
+    auto mask = MaskLanes();
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      mask.m_value[i] = (bits & (1 << i)) != 0;
+    }
+    return mask;
+#endif
+  }
+
+  inline MaskLanes operator &(MaskLanes left, MaskLanes right) {
+#if defined(ASHKAL_AVX2)
+    return MaskLanes(_mm256_and_ps(left.m_value, right.m_value));
+#elif defined(ASHKAL_SSE)
+    return MaskLanes(_mm_and_ps(left.m_value, right.m_value));
+#else
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      left.m_value[i] = left.m_value[i] && right.m_value[i];
+    }
+    return left;
+#endif
+  }
+
+  inline MaskLanes operator |(MaskLanes left, MaskLanes right) {
+#if defined(ASHKAL_AVX2)
+    return MaskLanes(_mm256_or_ps(left.m_value, right.m_value));
+#elif defined(ASHKAL_SSE)
+    return MaskLanes(_mm_or_ps(left.m_value, right.m_value));
+#else
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      left.m_value[i] = left.m_value[i] || right.m_value[i];
+    }
+    return left;
+#endif
+  }
+
+  /**
+   * Loads FloatLanes from memory.
+   * @param source The address of LANE_COUNT floats, no alignment is required.
+   */
+  inline FloatLanes load(const float* source) {
+#if defined(ASHKAL_AVX2)
+    return FloatLanes(_mm256_loadu_ps(source));
+#elif defined(ASHKAL_SSE)
+    return FloatLanes(_mm_loadu_ps(source));
+#else
+    auto lanes = FloatLanes();
+    std::copy_n(source, LANE_COUNT, lanes.m_value.begin());
+    return lanes;
+#endif
+  }
+
+  /**
+   * Loads the leading lanes of FloatLanes from memory, setting the remaining
+   * lanes to zero.
+   * @param source The address of the floats to load.
+   * @param count The number of floats to load.
+   */
+  inline FloatLanes load(const float* source, int count) {
+    if(count == LANE_COUNT) {
+      return load(source);
+    }
+    auto values = std::array<float, LANE_COUNT>();
+    std::copy_n(source, count, values.begin());
+    return load(values.data());
+  }
+
+  /** Stores FloatLanes into LANE_COUNT floats of memory. */
+  inline void store(FloatLanes lanes, float* destination) {
+#if defined(ASHKAL_AVX2)
+    _mm256_storeu_ps(destination, lanes.m_value);
+#elif defined(ASHKAL_SSE)
+    _mm_storeu_ps(destination, lanes.m_value);
+#else
+    std::copy(lanes.m_value.begin(), lanes.m_value.end(), destination);
+#endif
+  }
+
+  /** Stores the leading lanes of FloatLanes into memory. */
+  inline void store(FloatLanes lanes, float* destination, int count) {
+    if(count == LANE_COUNT) {
+      store(lanes, destination);
+      return;
+    }
+    auto values = std::array<float, LANE_COUNT>();
+    store(lanes, values.data());
+    std::copy_n(values.begin(), count, destination);
+  }
+
+  inline FloatLanes operator +(FloatLanes left, FloatLanes right) {
+#if defined(ASHKAL_AVX2)
+    return FloatLanes(_mm256_add_ps(left.m_value, right.m_value));
+#elif defined(ASHKAL_SSE)
+    return FloatLanes(_mm_add_ps(left.m_value, right.m_value));
+#else
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      left.m_value[i] += right.m_value[i];
+    }
+    return left;
+#endif
+  }
+
+  inline FloatLanes operator -(FloatLanes left, FloatLanes right) {
+#if defined(ASHKAL_AVX2)
+    return FloatLanes(_mm256_sub_ps(left.m_value, right.m_value));
+#elif defined(ASHKAL_SSE)
+    return FloatLanes(_mm_sub_ps(left.m_value, right.m_value));
+#else
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      left.m_value[i] -= right.m_value[i];
+    }
+    return left;
+#endif
+  }
+
+  inline FloatLanes operator *(FloatLanes left, FloatLanes right) {
+#if defined(ASHKAL_AVX2)
+    return FloatLanes(_mm256_mul_ps(left.m_value, right.m_value));
+#elif defined(ASHKAL_SSE)
+    return FloatLanes(_mm_mul_ps(left.m_value, right.m_value));
+#else
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      left.m_value[i] *= right.m_value[i];
+    }
+    return left;
+#endif
+  }
+
+  inline FloatLanes operator /(FloatLanes left, FloatLanes right) {
+#if defined(ASHKAL_AVX2)
+    return FloatLanes(_mm256_div_ps(left.m_value, right.m_value));
+#elif defined(ASHKAL_SSE)
+    return FloatLanes(_mm_div_ps(left.m_value, right.m_value));
+#else
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      left.m_value[i] /= right.m_value[i];
+    }
+    return left;
+#endif
+  }
+
+  inline FloatLanes& operator +=(FloatLanes& left, FloatLanes right) {
+    left = left + right;
+    return left;
+  }
+
+  /** Returns the lane-wise minimum of two FloatLanes. */
+  inline FloatLanes min(FloatLanes left, FloatLanes right) {
+#if defined(ASHKAL_AVX2)
+    return FloatLanes(_mm256_min_ps(left.m_value, right.m_value));
+#elif defined(ASHKAL_SSE)
+    return FloatLanes(_mm_min_ps(left.m_value, right.m_value));
+#else
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      left.m_value[i] = std::min(left.m_value[i], right.m_value[i]);
+    }
+    return left;
+#endif
+  }
+
+  /** Returns the lane-wise maximum of two FloatLanes. */
+  inline FloatLanes max(FloatLanes left, FloatLanes right) {
+#if defined(ASHKAL_AVX2)
+    return FloatLanes(_mm256_max_ps(left.m_value, right.m_value));
+#elif defined(ASHKAL_SSE)
+    return FloatLanes(_mm_max_ps(left.m_value, right.m_value));
+#else
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      left.m_value[i] = std::max(left.m_value[i], right.m_value[i]);
+    }
+    return left;
+#endif
+  }
+
+  /** Returns the lane-wise square root of FloatLanes. */
+  inline FloatLanes sqrt(FloatLanes lanes) {
+#if defined(ASHKAL_AVX2)
+    return FloatLanes(_mm256_sqrt_ps(lanes.m_value));
+#elif defined(ASHKAL_SSE)
+    return FloatLanes(_mm_sqrt_ps(lanes.m_value));
+#else
+    for(auto& lane : lanes.m_value) {
+      lane = std::sqrt(lane);
+    }
+    return lanes;
+#endif
+  }
+
+  inline MaskLanes operator <(FloatLanes left, FloatLanes right) {
+#if defined(ASHKAL_AVX2)
+    return MaskLanes(_mm256_cmp_ps(left.m_value, right.m_value, _CMP_LT_OQ));
+#elif defined(ASHKAL_SSE)
+    return MaskLanes(_mm_cmplt_ps(left.m_value, right.m_value));
+#else
+    auto mask = MaskLanes();
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      mask.m_value[i] = left.m_value[i] < right.m_value[i];
+    }
+    return mask;
+#endif
+  }
+
+  inline MaskLanes operator <=(FloatLanes left, FloatLanes right) {
+#if defined(ASHKAL_AVX2)
+    return MaskLanes(_mm256_cmp_ps(left.m_value, right.m_value, _CMP_LE_OQ));
+#elif defined(ASHKAL_SSE)
+    return MaskLanes(_mm_cmple_ps(left.m_value, right.m_value));
+#else
+    auto mask = MaskLanes();
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      mask.m_value[i] = left.m_value[i] <= right.m_value[i];
+    }
+    return mask;
+#endif
+  }
+
+  inline MaskLanes operator >(FloatLanes left, FloatLanes right) {
+    return right < left;
+  }
+
+  inline MaskLanes operator >=(FloatLanes left, FloatLanes right) {
+    return right <= left;
+  }
+
+  inline MaskLanes operator ==(FloatLanes left, FloatLanes right) {
+#if defined(ASHKAL_AVX2)
+    return MaskLanes(_mm256_cmp_ps(left.m_value, right.m_value, _CMP_EQ_OQ));
+#elif defined(ASHKAL_SSE)
+    return MaskLanes(_mm_cmpeq_ps(left.m_value, right.m_value));
+#else
+    auto mask = MaskLanes();
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      mask.m_value[i] = left.m_value[i] == right.m_value[i];
+    }
+    return mask;
+#endif
+  }
+
+  /**
+   * Selects between the lanes of two FloatLanes.
+   * @param mask The mask choosing which lanes are taken from the first operand.
+   * @param left The lanes selected where the mask is set.
+   * @param right The lanes selected where the mask is clear.
+   */
+  inline FloatLanes select(MaskLanes mask, FloatLanes left, FloatLanes right) {
+#if defined(ASHKAL_AVX2)
+    return FloatLanes(
+      _mm256_blendv_ps(right.m_value, left.m_value, mask.m_value));
+#elif defined(ASHKAL_SSE4_1)
+    return FloatLanes(_mm_blendv_ps(right.m_value, left.m_value, mask.m_value));
+#elif defined(ASHKAL_SSE)
+    return FloatLanes(_mm_or_ps(_mm_and_ps(mask.m_value, left.m_value),
+      _mm_andnot_ps(mask.m_value, right.m_value)));
+#else
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      if(mask.m_value[i]) {
+        right.m_value[i] = left.m_value[i];
+      }
+    }
+    return right;
+#endif
+  }
+
+  /**
+   * Loads IntLanes from memory.
+   * @param source The address of LANE_COUNT 32-bit integers, no alignment is
+   *        required.
+   */
+  inline IntLanes load(const std::int32_t* source) {
+#if defined(ASHKAL_AVX2)
+    return IntLanes(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source)));
+#elif defined(ASHKAL_SSE)
+    return IntLanes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source)));
+#else
+    auto lanes = IntLanes();
+    std::copy_n(source, LANE_COUNT, lanes.m_value.begin());
+    return lanes;
+#endif
+  }
+
+  /**
+   * Loads the leading lanes of IntLanes from memory, setting the remaining
+   * lanes to zero.
+   * @param source The address of the integers to load.
+   * @param count The number of integers to load.
+   */
+  inline IntLanes load(const std::int32_t* source, int count) {
+    if(count == LANE_COUNT) {
+      return load(source);
+    }
+    auto values = std::array<std::int32_t, LANE_COUNT>();
+    std::copy_n(source, count, values.begin());
+    return load(values.data());
+  }
+
+  /** Stores IntLanes into LANE_COUNT 32-bit integers of memory. */
+  inline void store(IntLanes lanes, std::int32_t* destination) {
+#if defined(ASHKAL_AVX2)
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination), lanes.m_value);
+#elif defined(ASHKAL_SSE)
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), lanes.m_value);
+#else
+    std::copy(lanes.m_value.begin(), lanes.m_value.end(), destination);
+#endif
+  }
+
+  /** Stores the leading lanes of IntLanes into memory. */
+  inline void store(IntLanes lanes, std::int32_t* destination, int count) {
+    if(count == LANE_COUNT) {
+      store(lanes, destination);
+      return;
+    }
+    auto values = std::array<std::int32_t, LANE_COUNT>();
+    store(lanes, values.data());
+    std::copy_n(values.begin(), count, destination);
+  }
+
+  /**
+   * Loads IntLanes from unsigned 16-bit integers of memory, extending each to
+   * 32 bits.
+   * @param source The address of the integers to load.
+   * @param count The number of integers to load, the remaining lanes are set
+   *        to zero.
+   */
+  inline IntLanes load(const std::uint16_t* source, int count) {
+    auto values = std::array<std::uint16_t, LANE_COUNT>();
+    if(count != LANE_COUNT) {
+      std::copy_n(source, count, values.begin());
+      source = values.data();
+    }
+#if defined(ASHKAL_AVX2)
+    return IntLanes(_mm256_cvtepu16_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(source))));
+#elif defined(ASHKAL_SSE4_1)
+    return IntLanes(_mm_cvtepu16_epi32(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source))));
+#elif defined(ASHKAL_SSE)
+    return IntLanes(_mm_unpacklo_epi16(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source)),
+      _mm_setzero_si128()));
+#else
+    auto lanes = IntLanes();
+    std::copy_n(source, LANE_COUNT, lanes.m_value.begin());
+    return lanes;
+#endif
+  }
+
+  /**
+   * Stores the leading lanes of IntLanes into unsigned 16-bit integers of
+   * memory, keeping the low 16 bits of each lane.
+   * @param lanes The lanes to store, each within [0, 65535].
+   * @param destination The address to store the integers to.
+   * @param count The number of integers to store.
+   */
+  inline void store(IntLanes lanes, std::uint16_t* destination, int count) {
+    auto values = std::array<std::uint16_t, LANE_COUNT>();
+    auto target = count == LANE_COUNT ? destination : values.data();
+#if defined(ASHKAL_AVX2)
+    auto packed = _mm256_packus_epi32(lanes.m_value, lanes.m_value);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(target),
+      _mm256_castsi256_si128(_mm256_permute4x64_epi64(packed, 0b1000)));
+#elif defined(ASHKAL_SSE4_1)
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(target),
+      _mm_packus_epi32(lanes.m_value, lanes.m_value));
+#elif defined(ASHKAL_SSE)
+    auto packed = _mm_shufflelo_epi16(lanes.m_value, 0b11111000);
+    packed = _mm_shufflehi_epi16(packed, 0b11111000);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(target),
+      _mm_shuffle_epi32(packed, 0b11111000));
+#else
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      target[i] = static_cast<std::uint16_t>(lanes.m_value[i]);
+    }
+#endif
+    if(target != destination) {
+      std::copy_n(values.begin(), count, destination);
+    }
+  }
+
+  /** Converts FloatLanes to IntLanes, truncating towards zero. */
+  inline IntLanes to_int(FloatLanes lanes) {
+#if defined(ASHKAL_AVX2)
+    return IntLanes(_mm256_cvttps_epi32(lanes.m_value));
+#elif defined(ASHKAL_SSE)
+    return IntLanes(_mm_cvttps_epi32(lanes.m_value));
+#else
+    auto result = IntLanes();
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      result.m_value[i] = static_cast<std::int32_t>(lanes.m_value[i]);
+    }
+    return result;
+#endif
+  }
+
+  /** Converts IntLanes to FloatLanes. */
+  inline FloatLanes to_float(IntLanes lanes) {
+#if defined(ASHKAL_AVX2)
+    return FloatLanes(_mm256_cvtepi32_ps(lanes.m_value));
+#elif defined(ASHKAL_SSE)
+    return FloatLanes(_mm_cvtepi32_ps(lanes.m_value));
+#else
+    auto result = FloatLanes();
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      result.m_value[i] = static_cast<float>(lanes.m_value[i]);
+    }
+    return result;
+#endif
+  }
+
+  inline IntLanes operator +(IntLanes left, IntLanes right) {
+#if defined(ASHKAL_AVX2)
+    return IntLanes(_mm256_add_epi32(left.m_value, right.m_value));
+#elif defined(ASHKAL_SSE)
+    return IntLanes(_mm_add_epi32(left.m_value, right.m_value));
+#else
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      left.m_value[i] += right.m_value[i];
+    }
+    return left;
+#endif
+  }
+
+  inline IntLanes& operator +=(IntLanes& left, IntLanes right) {
+    left = left + right;
+    return left;
+  }
+
+  inline IntLanes operator -(IntLanes left, IntLanes right) {
+#if defined(ASHKAL_AVX2)
+    return IntLanes(_mm256_sub_epi32(left.m_value, right.m_value));
+#elif defined(ASHKAL_SSE)
+    return IntLanes(_mm_sub_epi32(left.m_value, right.m_value));
+#else
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      left.m_value[i] -= right.m_value[i];
+    }
+    return left;
+#endif
+  }
+
+  inline IntLanes operator *(IntLanes left, IntLanes right) {
+#if defined(ASHKAL_AVX2)
+    return IntLanes(_mm256_mullo_epi32(left.m_value, right.m_value));
+#elif defined(ASHKAL_SSE4_1)
+    return IntLanes(_mm_mullo_epi32(left.m_value, right.m_value));
+#elif defined(ASHKAL_SSE)
+    auto even = _mm_mul_epu32(left.m_value, right.m_value);
+    auto odd = _mm_mul_epu32(
+      _mm_srli_epi64(left.m_value, 32), _mm_srli_epi64(right.m_value, 32));
+    return IntLanes(_mm_unpacklo_epi32(
+      _mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+      _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0))));
+#else
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      left.m_value[i] *= right.m_value[i];
+    }
+    return left;
+#endif
+  }
+
+  inline IntLanes operator &(IntLanes left, IntLanes right) {
+#if defined(ASHKAL_AVX2)
+    return IntLanes(_mm256_and_si256(left.m_value, right.m_value));
+#elif defined(ASHKAL_SSE)
+    return IntLanes(_mm_and_si128(left.m_value, right.m_value));
+#else
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      left.m_value[i] &= right.m_value[i];
+    }
+    return left;
+#endif
+  }
+
+  inline IntLanes operator |(IntLanes left, IntLanes right) {
+#if defined(ASHKAL_AVX2)
+    return IntLanes(_mm256_or_si256(left.m_value, right.m_value));
+#elif defined(ASHKAL_SSE)
+    return IntLanes(_mm_or_si128(left.m_value, right.m_value));
+#else
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      left.m_value[i] |= right.m_value[i];
+    }
+    return left;
+#endif
+  }
+
+  /** Shifts every lane left by the same number of bits. */
+  inline IntLanes operator <<(IntLanes lanes, int count) {
+#if defined(ASHKAL_AVX2)
+    return IntLanes(_mm256_sll_epi32(lanes.m_value, _mm_cvtsi32_si128(count)));
+#elif defined(ASHKAL_SSE)
+    return IntLanes(_mm_sll_epi32(lanes.m_value, _mm_cvtsi32_si128(count)));
+#else
+    for(auto& lane : lanes.m_value) {
+      lane = static_cast<std::int32_t>(
+        static_cast<std::uint32_t>(lane) << count);
+    }
+    return lanes;
+#endif
+  }
+
+  /** Shifts every lane right by the same number of bits, shifting in zeros. */
+  inline IntLanes operator >>(IntLanes lanes, int count) {
+#if defined(ASHKAL_AVX2)
+    return IntLanes(_mm256_srl_epi32(lanes.m_value, _mm_cvtsi32_si128(count)));
+#elif defined(ASHKAL_SSE)
+    return IntLanes(_mm_srl_epi32(lanes.m_value, _mm_cvtsi32_si128(count)));
+#else
+    for(auto& lane : lanes.m_value) {
+      lane = static_cast<std::int32_t>(
+        static_cast<std::uint32_t>(lane) >> count);
+    }
+    return lanes;
+#endif
+  }
+
+  inline MaskLanes operator <(IntLanes left, IntLanes right) {
+#if defined(ASHKAL_AVX2)
+    return MaskLanes(
+      _mm256_castsi256_ps(_mm256_cmpgt_epi32(right.m_value, left.m_value)));
+#elif defined(ASHKAL_SSE)
+    return MaskLanes(
+      _mm_castsi128_ps(_mm_cmplt_epi32(left.m_value, right.m_value)));
+#else
+    auto mask = MaskLanes();
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      mask.m_value[i] = left.m_value[i] < right.m_value[i];
+    }
+    return mask;
+#endif
+  }
+
+  inline MaskLanes operator >(IntLanes left, IntLanes right) {
+    return right < left;
+  }
+
+  inline MaskLanes operator <=(IntLanes left, IntLanes right) {
+#if defined(ASHKAL_AVX2)
+    return MaskLanes(_mm256_castsi256_ps(_mm256_xor_si256(
+      _mm256_cmpgt_epi32(left.m_value, right.m_value),
+      _mm256_set1_epi32(-1))));
+#elif defined(ASHKAL_SSE)
+    return MaskLanes(_mm_castsi128_ps(_mm_xor_si128(
+      _mm_cmpgt_epi32(left.m_value, right.m_value), _mm_set1_epi32(-1))));
+#else
+    auto mask = MaskLanes();
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      mask.m_value[i] = left.m_value[i] <= right.m_value[i];
+    }
+    return mask;
+#endif
+  }
+
+  inline MaskLanes operator >=(IntLanes left, IntLanes right) {
+    return right <= left;
+  }
+
+  /**
+   * Selects between the lanes of two IntLanes.
+   * @param mask The mask choosing which lanes are taken from the first operand.
+   * @param left The lanes selected where the mask is set.
+   * @param right The lanes selected where the mask is clear.
+   */
+  inline IntLanes select(MaskLanes mask, IntLanes left, IntLanes right) {
+#if defined(ASHKAL_AVX2)
+    return IntLanes(_mm256_castps_si256(_mm256_blendv_ps(
+      _mm256_castsi256_ps(right.m_value), _mm256_castsi256_ps(left.m_value),
+      mask.m_value)));
+#elif defined(ASHKAL_SSE4_1)
+    return IntLanes(_mm_castps_si128(_mm_blendv_ps(
+      _mm_castsi128_ps(right.m_value), _mm_castsi128_ps(left.m_value),
+      mask.m_value)));
+#elif defined(ASHKAL_SSE)
+    auto bits = _mm_castps_si128(mask.m_value);
+    return IntLanes(_mm_or_si128(_mm_and_si128(bits, left.m_value),
+      _mm_andnot_si128(bits, right.m_value)));
+#else
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      if(mask.m_value[i]) {
+        right.m_value[i] = left.m_value[i];
+      }
+    }
+    return right;
+#endif
+  }
+
+#if defined(ASHKAL_AVX2)
+  inline FloatLanes::FloatLanes()
+    : m_value(_mm256_setzero_ps()) {}
+
+  inline FloatLanes::FloatLanes(float value)
+    : m_value(_mm256_set1_ps(value)) {}
+
+  inline FloatLanes::FloatLanes(__m256 value)
+    : m_value(value) {}
+
+  inline IntLanes::IntLanes()
+    : m_value(_mm256_setzero_si256()) {}
+
+  inline IntLanes::IntLanes(std::int32_t value)
+    : m_value(_mm256_set1_epi32(value)) {}
+
+  inline IntLanes::IntLanes(__m256i value)
+    : m_value(value) {}
+#elif defined(ASHKAL_SSE)
+  inline FloatLanes::FloatLanes()
+    : m_value(_mm_setzero_ps()) {}
+
+  inline FloatLanes::FloatLanes(float value)
+    : m_value(_mm_set1_ps(value)) {}
+
+  inline FloatLanes::FloatLanes(__m128 value)
+    : m_value(value) {}
+
+  inline IntLanes::IntLanes()
+    : m_value(_mm_setzero_si128()) {}
+
+  inline IntLanes::IntLanes(std::int32_t value)
+    : m_value(_mm_set1_epi32(value)) {}
+
+  inline IntLanes::IntLanes(__m128i value)
+    : m_value(value) {}
+#else
+  inline FloatLanes::FloatLanes()
+    : m_value() {}
+
+  inline FloatLanes::FloatLanes(float value) {
+    m_value.fill(value);
+  }
+
+  inline IntLanes::IntLanes()
+    : m_value() {}
+
+  inline IntLanes::IntLanes(std::int32_t value) {
+    m_value.fill(value);
+  }
+#endif
+}
+
+#endif
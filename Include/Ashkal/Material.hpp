@@ -2,6 +2,7 @@
 #define ASHKAL_MATERIAL_HPP
 #include <memory>
 #include "Ashkal/ColorSampler.hpp"
+#include "Ashkal/ShadingRate.hpp"
 
 namespace Ashkal {
 
@@ -18,19 +19,67 @@ namespace Ashkal {
        */
       explicit Material(std::shared_ptr<ColorSampler> diffuseness);
 
+      /**
+       * Constructs a Material with a diffuseness sampler.
+       * @param  diffuseness The ColorSampler providing diffuse color lookups.
+       * @param is_double_sided Whether surfaces using this material are
+       *        visible from both sides, and are thus never back-face culled.
+       */
+      Material(
+        std::shared_ptr<ColorSampler> diffuseness, bool is_double_sided);
+
+      /**
+       * Constructs a Material with a diffuseness sampler.
+       * @param  diffuseness The ColorSampler providing diffuse color lookups.
+       * @param is_double_sided Whether surfaces using this material are
+       *        visible from both sides, and are thus never back-face culled.
+       * @param shading_rate The finest rate surfaces using this material are
+       *        shaded at, where coarser rates suit materials whose color
+       *        varies little across neighbouring pixels.
+       */
+      Material(std::shared_ptr<ColorSampler> diffuseness,
+        bool is_double_sided, ShadingRate shading_rate);
+
       /** Returns the material's diffuseness sampler. */
       const ColorSampler& get_diffuseness() const;
 
+      /** Returns whether the material is visible from both sides. */
+      bool is_double_sided() const;
+
+      /** Returns the finest rate the material is shaded at. */
+      ShadingRate get_shading_rate() const;
+
     private:
       std::shared_ptr<ColorSampler> m_diffuseness;
+      bool m_is_double_sided;
+      ShadingRate m_shading_rate;
   };
 
   inline Material::Material(std::shared_ptr<ColorSampler> diffuseness)
-    : m_diffuseness(std::move(diffuseness)) {}
+    : Material(std::move(diffuseness), false) {}
+
+  inline Material::Material(
+    std::shared_ptr<ColorSampler> diffuseness, bool is_double_sided)
+    : Material(std::move(diffuseness), is_double_sided,
+        ShadingRate::ONE_BY_ONE) {}
+
+  inline Material::Material(std::shared_ptr<ColorSampler> diffuseness,
+    bool is_double_sided, ShadingRate shading_rate)
+    : m_diffuseness(std::move(diffuseness)),
+      m_is_double_sided(is_double_sided),
+      m_shading_rate(shading_rate) {}
 
   inline const ColorSampler& Material::get_diffuseness() const {
     return *m_diffuseness;
   }
+
+  inline bool Material::is_double_sided() const {
+    return m_is_double_sided;
+  }
+
+  inline ShadingRate Material::get_shading_rate() const {
+    return m_shading_rate;
+  }
 }
 
 #endif
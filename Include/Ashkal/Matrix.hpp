@@ -433,6 +433,19 @@ namespace Ashkal {
     return transformed_vector;
   }
 
+  /**
+   * Returns <code>true</code> iff a transformation mirrors the space it
+   * transforms, which reverses the winding of every triangle it is applied
+   * to.
+   * @param transformation The transformation matrix to test.
+   */
+  inline bool is_mirroring(const Matrix& transformation) {
+    auto x = linear_transform(transformation, Vector(1, 0, 0));
+    auto y = linear_transform(transformation, Vector(0, 1, 0));
+    auto z = linear_transform(transformation, Vector(0, 0, 1));
+    return dot(cross(x, y), z) < 0;
+  }
+
   inline std::ostream& operator <<(std::ostream& out, const Matrix& matrix) {
     out << "Matrix(";
     for(auto y = 0; y != Matrix::HEIGHT; ++y) {
@@ -8,6 +8,7 @@
 #include <SDL_image.h>
 #include "Ashkal/Material.hpp"
 #include "Ashkal/Mesh.hpp"
+#include "Ashkal/MeshOptimizer.hpp"
 #include "Ashkal/SdlSurfaceColorSampler.hpp"
 #include "Ashkal/SolidColorSampler.hpp"
 #include "Ashkal/VertexTriangle.hpp"
@@ -15,7 +16,8 @@
 namespace Ashkal {
 
   /**
-   * Loads a Mesh from a file on disk.
+   * Loads a Mesh from a file on disk, optimizing it for drawing and splitting
+   * it into meshlets.
    * @param path The path to the mesh file to load (e.g., .obj, .ply).
    * @return A Mesh populated with vertices and a root MeshNode.
    * @throws std::runtime_error if the file cannot be read or parsing fails.
@@ -24,7 +26,7 @@ namespace Ashkal {
     auto importer = Assimp::Importer();
     auto scene = importer.ReadFile(path.string(), aiProcess_Triangulate |
       aiProcess_JoinIdenticalVertices | aiProcess_GenNormals |
-      aiProcess_ImproveCacheLocality | aiProcess_PreTransformVertices);
+      aiProcess_PreTransformVertices);
     if(!scene || !scene->HasMeshes()) {
       throw std::runtime_error(
         "Failed to load OBJ: " + std::string(importer.GetErrorString()));
@@ -101,7 +103,10 @@ namespace Ashkal {
       children.emplace_back(std::move(fragment));
     }
     auto root = MeshNode(std::move(children));
-    return Mesh(std::move(vertices), std::move(root));
+    auto mesh = Mesh(std::move(vertices), std::move(root));
+    optimize(mesh);
+    build_meshlets(mesh);
+    return mesh;
   }
 }
 
@@ -0,0 +1,606 @@
+#ifndef ASHKAL_MESH_OPTIMIZER_HPP
+#define ASHKAL_MESH_OPTIMIZER_HPP
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+#include "Ashkal/Mesh.hpp"
+#include "Ashkal/Meshlet.hpp"
+#include "Ashkal/Vector.hpp"
+
+namespace Ashkal {
+
+  /** The number of entries in the FIFO post-transform cache simulated. */
+  const auto VERTEX_CACHE_SIZE = 16;
+
+  /**
+   * The factor by which a cluster's cache efficiency may fall below that of
+   * the run of triangles it was split from when reordering for overdraw.
+   */
+  const auto OVERDRAW_THRESHOLD = 1.05f;
+
+  /**
+   * The width and height of the raster each view is drawn into when
+   * measuring overdraw.
+   */
+  const auto OVERDRAW_RESOLUTION = 256;
+
+  /** Stores measures of how efficiently a mesh is drawn. */
+  struct MeshStatistics {
+
+    /**
+     * The average number of vertices transformed per triangle, or average
+     * cache miss ratio, with a FIFO post-transform cache that is flushed
+     * between fragments.
+     */
+    float m_acmr;
+
+    /**
+     * The average number of times each pixel covered by the mesh is shaded
+     * when drawn in order, viewed along each of the positive and negative
+     * axes.
+     */
+    float m_overdraw;
+  };
+
+  /**
+   * Draws a triangle through a simulated FIFO post-transform cache.
+   * A vertex is cached if fewer than cache_size misses have occurred since
+   * it last missed.
+   * @param triangle The triangle to draw.
+   * @param cache_size The number of entries in the cache.
+   * @param timestamps The time at which each vertex last missed.
+   * @param time The current time, advanced by each miss.
+   * @return The number of vertices of the triangle that missed the cache.
+   */
+  inline int update_cache(const VertexTriangle& triangle, int cache_size,
+      std::vector<int>& timestamps, int& time) {
+    auto misses = 0;
+    for(auto index : {triangle.m_a, triangle.m_b, triangle.m_c}) {
+      if(time - timestamps[index] > cache_size) {
+        timestamps[index] = time;
+        ++time;
+        ++misses;
+      }
+    }
+    return misses;
+  }
+
+  /**
+   * Counts the vertices transformed to draw a list of triangles through a
+   * FIFO post-transform cache that starts out empty.
+   * @param triangles The triangles to draw.
+   * @param vertex_count The number of vertices the triangles index into.
+   * @param cache_size The number of entries in the cache.
+   */
+  inline int count_cache_misses(const std::vector<VertexTriangle>& triangles,
+      int vertex_count, int cache_size) {
+    auto timestamps = std::vector<int>(vertex_count, 0);
+    auto time = cache_size + 1;
+    auto misses = 0;
+    for(auto& triangle : triangles) {
+      misses += update_cache(triangle, cache_size, timestamps, time);
+    }
+    return misses;
+  }
+
+  /**
+   * Renumbers the vertices of a list of triangles to a compact range in the
+   * order they are first referenced, so that the cost of optimizing a
+   * fragment depends on its own size rather than that of its mesh.
+   * @param triangles The triangles to renumber.
+   * @param remapping The scratch map from each vertex of the mesh to its
+   *        compact index, every entry of which must be -1, and is restored
+   *        to -1 on return.
+   * @param indices Stores the original index of each compact vertex.
+   * @return The renumbered triangles.
+   */
+  inline std::vector<VertexTriangle> compact_vertices(
+      const std::vector<VertexTriangle>& triangles, std::vector<int>& remapping,
+      std::vector<int>& indices) {
+    indices.clear();
+    auto remap = [&] (int index) {
+      if(remapping[index] == -1) {
+        remapping[index] = static_cast<int>(indices.size());
+        indices.push_back(index);
+      }
+      return remapping[index];
+    };
+    auto compacted = std::vector<VertexTriangle>();
+    compacted.reserve(triangles.size());
+    for(auto& triangle : triangles) {
+      auto a = remap(triangle.m_a);
+      auto b = remap(triangle.m_b);
+      auto c = remap(triangle.m_c);
+      compacted.push_back(VertexTriangle(a, b, c));
+    }
+    for(auto index : indices) {
+      remapping[index] = -1;
+    }
+    return compacted;
+  }
+
+  /**
+   * Measures the overdraw of a list of triangles drawn in order, rasterizing
+   * the front faces of the triangles with a depth test from each of the six
+   * axis-aligned directions.
+   * @param triangles The triangles to draw.
+   * @param vertices The vertices the triangles index into.
+   * @return The number of pixels shaded divided by the number of pixels
+   *         covered, summed over all six views.
+   */
+  inline float calculate_overdraw(const std::vector<VertexTriangle>& triangles,
+      const std::vector<Vertex>& vertices) {
+    auto minimum = std::array{std::numeric_limits<float>::infinity(),
+      std::numeric_limits<float>::infinity(),
+      std::numeric_limits<float>::infinity()};
+    auto maximum = std::array{-minimum[0], -minimum[1], -minimum[2]};
+    for(auto& triangle : triangles) {
+      for(auto index : {triangle.m_a, triangle.m_b, triangle.m_c}) {
+        auto& position = vertices[index].m_position;
+        auto coordinates =
+          std::array{position.m_x, position.m_y, position.m_z};
+        for(auto i = 0; i != 3; ++i) {
+          minimum[i] = std::min(minimum[i], coordinates[i]);
+          maximum[i] = std::max(maximum[i], coordinates[i]);
+        }
+      }
+    }
+    auto extent = std::numeric_limits<float>::min();
+    for(auto i = 0; i != 3; ++i) {
+      extent = std::max(extent, maximum[i] - minimum[i]);
+    }
+    const auto SIZE = OVERDRAW_RESOLUTION;
+    auto depths = std::vector<float>(SIZE * SIZE);
+    auto shaded = std::int64_t(0);
+    auto covered = std::int64_t(0);
+    for(auto view = 0; view != 6; ++view) {
+      auto axis = view / 2;
+      auto is_negative = view % 2 == 1;
+
+      // Each view looks down its axis with the other two axes taken in
+      // cyclic order, mirroring the horizontal axis when looking up the
+      // axis, so that front faces remain counter-clockwise. Nearer points
+      // have larger depths.
+      auto project = [&] (int index) {
+        auto& position = vertices[index].m_position;
+        auto coordinates =
+          std::array{position.m_x, position.m_y, position.m_z};
+        auto scale = [&] (int i) {
+          return (coordinates[i] - minimum[i]) / extent;
+        };
+        auto x = scale((axis + 1) % 3);
+        auto y = scale((axis + 2) % 3);
+        auto depth = scale(axis);
+        if(is_negative) {
+          x = 1 - x;
+          depth = 1 - depth;
+        }
+        return Point(x * SIZE, y * SIZE, depth);
+      };
+      std::fill(depths.begin(), depths.end(), -1.f);
+      for(auto& triangle : triangles) {
+        auto a = project(triangle.m_a);
+        auto b = project(triangle.m_b);
+        auto c = project(triangle.m_c);
+        auto edge = [] (const Point& from, const Point& to, float x,
+            float y) {
+          return (to.m_x - from.m_x) * (y - from.m_y) -
+            (to.m_y - from.m_y) * (x - from.m_x);
+        };
+        auto area = edge(a, b, c.m_x, c.m_y);
+        if(area <= 0) {
+          continue;
+        }
+        auto left = std::max(0,
+          static_cast<int>(std::floor(std::min({a.m_x, b.m_x, c.m_x}))));
+        auto right = std::min(SIZE - 1,
+          static_cast<int>(std::ceil(std::max({a.m_x, b.m_x, c.m_x}))));
+        auto top = std::max(0,
+          static_cast<int>(std::floor(std::min({a.m_y, b.m_y, c.m_y}))));
+        auto bottom = std::min(SIZE - 1,
+          static_cast<int>(std::ceil(std::max({a.m_y, b.m_y, c.m_y}))));
+        for(auto y = top; y <= bottom; ++y) {
+          auto center_y = static_cast<float>(y) + 0.5f;
+          for(auto x = left; x <= right; ++x) {
+            auto center_x = static_cast<float>(x) + 0.5f;
+            auto weight_a = edge(b, c, center_x, center_y);
+            auto weight_b = edge(c, a, center_x, center_y);
+            auto weight_c = edge(a, b, center_x, center_y);
+            if(weight_a < 0 || weight_b < 0 || weight_c < 0) {
+              continue;
+            }
+            auto depth = (weight_a * a.m_z + weight_b * b.m_z +
+              weight_c * c.m_z) / area;
+            auto& stored_depth = depths[x + SIZE * y];
+            if(depth > stored_depth) {
+              stored_depth = depth;
+              ++shaded;
+            }
+          }
+        }
+      }
+      covered += std::count_if(depths.begin(), depths.end(),
+        [] (float depth) { return depth >= 0; });
+    }
+    if(covered == 0) {
+      return 0;
+    }
+    return static_cast<float>(shaded) / static_cast<float>(covered);
+  }
+
+  /**
+   * Reorders triangles for reuse of a FIFO post-transform cache using the
+   * Tipsify algorithm, which fans around one vertex at a time and moves on
+   * to the vertex among those just drawn that is likely to remain cached
+   * longest while it still has triangles left to draw.
+   * @param triangles The triangles to reorder.
+   * @param vertex_count The number of vertices the triangles index into.
+   * @param cache_size The number of entries in the cache.
+   * @return The reordered triangles.
+   */
+  inline std::vector<VertexTriangle> optimize_vertex_cache(
+      const std::vector<VertexTriangle>& triangles, int vertex_count,
+      int cache_size) {
+    auto offsets = std::vector<int>(vertex_count + 1, 0);
+    for(auto& triangle : triangles) {
+      for(auto index : {triangle.m_a, triangle.m_b, triangle.m_c}) {
+        ++offsets[index + 1];
+      }
+    }
+    auto live_counts = std::vector<int>(vertex_count);
+    for(auto i = 0; i != vertex_count; ++i) {
+      live_counts[i] = offsets[i + 1];
+      offsets[i + 1] += offsets[i];
+    }
+    auto adjacency = std::vector<int>(offsets.back());
+    auto cursors = std::vector<int>(offsets.begin(), offsets.end() - 1);
+    for(auto i = 0; i != static_cast<int>(triangles.size()); ++i) {
+      auto& triangle = triangles[i];
+      for(auto index : {triangle.m_a, triangle.m_b, triangle.m_c}) {
+        adjacency[cursors[index]] = i;
+        ++cursors[index];
+      }
+    }
+    auto timestamps = std::vector<int>(vertex_count, 0);
+    auto time = cache_size + 1;
+    auto is_emitted = std::vector<std::uint8_t>(triangles.size(), 0);
+    auto dead_ends = std::vector<int>();
+    auto candidates = std::vector<int>();
+    auto next_vertex = 0;
+    auto skip_dead_end = [&] {
+      while(!dead_ends.empty()) {
+        auto vertex = dead_ends.back();
+        dead_ends.pop_back();
+        if(live_counts[vertex] > 0) {
+          return vertex;
+        }
+      }
+      while(next_vertex != vertex_count) {
+        if(live_counts[next_vertex] > 0) {
+          return next_vertex;
+        }
+        ++next_vertex;
+      }
+      return -1;
+    };
+    auto result = std::vector<VertexTriangle>();
+    result.reserve(triangles.size());
+    auto fanning_vertex = skip_dead_end();
+    while(fanning_vertex != -1) {
+      candidates.clear();
+      for(auto i = offsets[fanning_vertex]; i != offsets[fanning_vertex + 1];
+          ++i) {
+        auto t = adjacency[i];
+        if(is_emitted[t]) {
+          continue;
+        }
+        auto& triangle = triangles[t];
+        result.push_back(triangle);
+        is_emitted[t] = 1;
+        for(auto index : {triangle.m_a, triangle.m_b, triangle.m_c}) {
+          dead_ends.push_back(index);
+          candidates.push_back(index);
+          --live_counts[index];
+          if(time - timestamps[index] > cache_size) {
+            timestamps[index] = time;
+            ++time;
+          }
+        }
+      }
+
+      // Prefers the candidate that entered the cache earliest among those
+      // that remain cached after their remaining triangles are drawn.
+      auto best_vertex = -1;
+      auto best_priority = -1;
+      for(auto candidate : candidates) {
+        if(live_counts[candidate] > 0) {
+          auto priority = 0;
+          auto age = time - timestamps[candidate];
+          if(age + 2 * live_counts[candidate] <= cache_size) {
+            priority = age;
+          }
+          if(priority > best_priority) {
+            best_priority = priority;
+            best_vertex = candidate;
+          }
+        }
+      }
+      if(best_vertex == -1) {
+        best_vertex = skip_dead_end();
+      }
+      fanning_vertex = best_vertex;
+    }
+    return result;
+  }
+
+  /**
+   * Reorders triangles already ordered for cache reuse so that triangles
+   * likely to occlude others are drawn first, independently of the view.
+   * The triangles are split into clusters wherever the cache restarts and
+   * wherever a cluster's cache efficiency comes within a threshold of that
+   * of the run it belongs to, and the clusters are sorted by how far they
+   * face outwards from the center of the mesh.
+   * @param triangles The triangles to reorder.
+   * @param vertices The vertices the triangles index into.
+   * @param cache_size The number of entries in the cache.
+   * @param threshold The factor by which a cluster's cache miss ratio may
+   *        exceed that of the run it was split from.
+   * @return The reordered triangles.
+   */
+  inline std::vector<VertexTriangle> optimize_overdraw(
+      const std::vector<VertexTriangle>& triangles,
+      const std::vector<Vertex>& vertices, int cache_size, float threshold) {
+    auto count = static_cast<int>(triangles.size());
+    auto timestamps = std::vector<int>(vertices.size(), 0);
+    auto time = cache_size + 1;
+    auto runs = std::vector<int>();
+    for(auto i = 0; i != count; ++i) {
+      auto misses = update_cache(triangles[i], cache_size, timestamps, time);
+      if(i == 0 || misses == 3) {
+        runs.push_back(i);
+      }
+    }
+    runs.push_back(count);
+    auto clusters = std::vector<int>();
+    for(auto run = std::size_t(0); run + 1 < runs.size(); ++run) {
+      auto start = runs[run];
+      auto end = runs[run + 1];
+      time += cache_size + 1;
+      auto run_misses = 0;
+      for(auto i = start; i != end; ++i) {
+        run_misses += update_cache(triangles[i], cache_size, timestamps, time);
+      }
+      auto target =
+        threshold * static_cast<float>(run_misses) / (end - start);
+      clusters.push_back(start);
+      time += cache_size + 1;
+      auto misses = 0;
+      auto size = 0;
+      for(auto i = start; i != end; ++i) {
+        misses += update_cache(triangles[i], cache_size, timestamps, time);
+        ++size;
+        if(i + 1 != end && static_cast<float>(misses) <= target * size) {
+          clusters.push_back(i + 1);
+          time += cache_size + 1;
+          misses = 0;
+          size = 0;
+        }
+      }
+    }
+    clusters.push_back(count);
+    auto get_position = [&] (int index) {
+      return Vector(vertices[index].m_position);
+    };
+    auto mesh_center = Vector();
+    for(auto& triangle : triangles) {
+      mesh_center = mesh_center + get_position(triangle.m_a) +
+        get_position(triangle.m_b) + get_position(triangle.m_c);
+    }
+    mesh_center = mesh_center / static_cast<float>(3 * std::max(count, 1));
+    auto cluster_count = static_cast<int>(clusters.size()) - 1;
+    auto keys = std::vector<float>(cluster_count);
+    for(auto cluster = 0; cluster != cluster_count; ++cluster) {
+      auto center = Vector();
+      auto normal = Vector();
+      auto area = 0.f;
+      for(auto i = clusters[cluster]; i != clusters[cluster + 1]; ++i) {
+        auto a = get_position(triangles[i].m_a);
+        auto b = get_position(triangles[i].m_b);
+        auto c = get_position(triangles[i].m_c);
+        auto triangle_normal = cross(b - a, c - a);
+        auto triangle_area = magnitude(triangle_normal);
+        center = center + (triangle_area / 3) * (a + b + c);
+        normal = normal + triangle_normal;
+        area += triangle_area;
+      }
+      auto length = magnitude(normal);
+      if(area > 0 && length > 0) {
+        keys[cluster] = dot(center / area - mesh_center, normal / length);
+      } else {
+        keys[cluster] = 0;
+      }
+    }
+    auto order = std::vector<int>(cluster_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&] (int left, int right) {
+      return keys[left] > keys[right];
+    });
+    auto result = std::vector<VertexTriangle>();
+    result.reserve(triangles.size());
+    for(auto cluster : order) {
+      result.insert(result.end(), triangles.begin() + clusters[cluster],
+        triangles.begin() + clusters[cluster + 1]);
+    }
+    return result;
+  }
+
+  /**
+   * Builds a copy of a mesh node with each fragment modified.
+   * @param node The node to copy.
+   * @param f The callable invoked as f(fragment) on a copy of each fragment,
+   *        in drawing order, to modify it.
+   */
+  template<typename F>
+  MeshNode modify_fragments(const MeshNode& node, F&& f) {
+    if(node.get_type() == MeshNode::Type::CHUNK) {
+      auto children = std::vector<MeshNode>();
+      for(auto& child : node.as_chunk()) {
+        children.push_back(modify_fragments(child, f));
+      }
+      return MeshNode(std::move(children));
+    }
+    auto fragment = node.as_fragment();
+    f(fragment);
+    return MeshNode(std::move(fragment));
+  }
+
+  /**
+   * Calls a function on the triangles of each fragment of a mesh node, in
+   * drawing order.
+   * @param node The node to visit.
+   * @param f The callable invoked as f(triangles) on each fragment.
+   */
+  template<typename F>
+  void for_each_fragment(const MeshNode& node, F&& f) {
+    if(node.get_type() == MeshNode::Type::CHUNK) {
+      for(auto& child : node.as_chunk()) {
+        for_each_fragment(child, f);
+      }
+    } else {
+      f(node.as_fragment().get_triangles());
+    }
+  }
+
+  /**
+   * Reorders a mesh's vertices in the order they are first referenced by its
+   * triangles so that they are fetched sequentially, moving any vertices
+   * that are not referenced to the end.
+   * @param mesh The mesh whose vertices are reordered.
+   */
+  inline void optimize_vertex_fetch(Mesh& mesh) {
+    auto remapping = std::vector<int>(mesh.m_vertices.size(), -1);
+    auto vertices = std::vector<Vertex>();
+    vertices.reserve(mesh.m_vertices.size());
+    auto remap = [&] (int index) {
+      if(remapping[index] == -1) {
+        remapping[index] = static_cast<int>(vertices.size());
+        vertices.push_back(mesh.m_vertices[index]);
+      }
+      return remapping[index];
+    };
+    mesh.m_root = modify_fragments(mesh.m_root, [&] (Fragment& fragment) {
+      auto triangles = std::vector<VertexTriangle>();
+      triangles.reserve(fragment.get_triangles().size());
+      for(auto& triangle : fragment.get_triangles()) {
+        auto a = remap(triangle.m_a);
+        auto b = remap(triangle.m_b);
+        auto c = remap(triangle.m_c);
+        triangles.push_back(VertexTriangle(a, b, c));
+      }
+      auto meshlets = fragment.get_meshlets();
+      fragment.set_triangles(std::move(triangles));
+      fragment.set_meshlets(std::move(meshlets));
+    });
+    for(auto i = std::size_t(0); i != remapping.size(); ++i) {
+      if(remapping[i] == -1) {
+        vertices.push_back(mesh.m_vertices[i]);
+      }
+    }
+    mesh.m_vertices = std::move(vertices);
+  }
+
+  /**
+   * Splits the triangles of each of a mesh's fragments into meshlets, so
+   * that parts of a fragment can be culled before their vertices are
+   * transformed. Since a Model refers to the nodes of its mesh, meshlets must
+   * be built before a Model is made from the mesh.
+   * @param mesh The mesh whose fragments are split.
+   */
+  inline void build_meshlets(Mesh& mesh) {
+    mesh.m_root = modify_fragments(mesh.m_root, [&] (Fragment& fragment) {
+      fragment.set_meshlets(
+        make_meshlets(fragment.get_triangles(), mesh.m_vertices));
+    });
+  }
+
+  /**
+   * Measures how efficiently a mesh is drawn.
+   * @param mesh The mesh to measure.
+   * @param cache_size The number of entries in the simulated cache.
+   */
+  inline MeshStatistics analyze(const Mesh& mesh, int cache_size) {
+    auto remapping = std::vector<int>(mesh.m_vertices.size(), -1);
+    auto indices = std::vector<int>();
+    auto misses = 0;
+    auto triangles = std::vector<VertexTriangle>();
+    for_each_fragment(mesh.m_root,
+      [&] (const std::vector<VertexTriangle>& fragment_triangles) {
+        auto compacted =
+          compact_vertices(fragment_triangles, remapping, indices);
+        misses += count_cache_misses(
+          compacted, static_cast<int>(indices.size()), cache_size);
+        triangles.insert(triangles.end(), fragment_triangles.begin(),
+          fragment_triangles.end());
+      });
+    auto acmr = [&] {
+      if(triangles.empty()) {
+        return 0.f;
+      }
+      return static_cast<float>(misses) /
+        static_cast<float>(triangles.size());
+    }();
+    return MeshStatistics(acmr,
+      calculate_overdraw(triangles, mesh.m_vertices));
+  }
+
+  /**
+   * Optimizes a mesh for drawing, reordering each fragment's triangles for
+   * post-transform cache reuse and then to reduce overdraw, and reordering
+   * the vertices for sequential fetch. Since a Model refers to the nodes of
+   * its mesh, a mesh must be optimized before a Model is made from it. Any
+   * meshlets are removed, since the triangles they cover are reordered.
+   * No statistics are measured; use analyze to measure the mesh before and
+   * after optimizing it.
+   * @param mesh The mesh to optimize.
+   * @param cache_size The number of entries in the simulated cache.
+   * @param threshold The factor by which a cluster's cache miss ratio may
+   *        exceed that of the run it was split from when reducing overdraw.
+   */
+  inline void optimize(Mesh& mesh, int cache_size, float threshold) {
+    auto remapping = std::vector<int>(mesh.m_vertices.size(), -1);
+    auto indices = std::vector<int>();
+    auto vertices = std::vector<Vertex>();
+    mesh.m_root = modify_fragments(mesh.m_root, [&] (Fragment& fragment) {
+      auto triangles =
+        compact_vertices(fragment.get_triangles(), remapping, indices);
+      vertices.clear();
+      for(auto index : indices) {
+        vertices.push_back(mesh.m_vertices[index]);
+      }
+      triangles = optimize_overdraw(optimize_vertex_cache(triangles,
+        static_cast<int>(indices.size()), cache_size), vertices, cache_size,
+        threshold);
+      for(auto& triangle : triangles) {
+        triangle = VertexTriangle(
+          indices[triangle.m_a], indices[triangle.m_b], indices[triangle.m_c]);
+      }
+      fragment.set_triangles(std::move(triangles));
+    });
+    optimize_vertex_fetch(mesh);
+  }
+
+  /**
+   * Optimizes a mesh for drawing using a cache of VERTEX_CACHE_SIZE entries
+   * and an OVERDRAW_THRESHOLD.
+   * @param mesh The mesh to optimize.
+   */
+  inline void optimize(Mesh& mesh) {
+    optimize(mesh, VERTEX_CACHE_SIZE, OVERDRAW_THRESHOLD);
+  }
+}
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef ASHKAL_MESHLET_HPP
+#define ASHKAL_MESHLET_HPP
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "Ashkal/BoundingBox.hpp"
+#include "Ashkal/Vector.hpp"
+#include "Ashkal/Vertex.hpp"
+#include "Ashkal/VertexTriangle.hpp"
+
+namespace Ashkal {
+
+  /** The most triangles placed in a meshlet. */
+  const auto MAX_MESHLET_TRIANGLES = 128;
+
+  /**
+   * The fewest triangles placed in a meshlet before it is ended early to
+   * keep its normal cone narrow.
+   */
+  const auto MIN_MESHLET_TRIANGLES = 64;
+
+  /**
+   * The smallest cosine between a meshlet's cone axis and its triangles'
+   * normals for which the cone is used for culling.
+   */
+  const auto MIN_CONE_COSINE = 0.1f;
+
+  /**
+   * A run of consecutive triangles of a fragment, bounded so that it can be
+   * culled as a whole before any of its vertices are transformed.
+   */
+  struct Meshlet {
+
+    /** The index of the meshlet's first triangle within its fragment. */
+    int m_offset;
+
+    /** The number of triangles in the meshlet. */
+    int m_count;
+
+    /** The bounding box of the meshlet in model space. */
+    BoundingBox m_bounding_box;
+
+    /** The axis of the cone bounding the normals of the triangles. */
+    Vector m_cone_axis;
+
+    /**
+     * The sine of the half angle of the normal cone, or 1 if the cone is too
+     * wide for the meshlet to ever face entirely one way.
+     */
+    float m_cone_cutoff;
+  };
+
+  /**
+   * Returns the normal of a triangle, whose length is twice its area.
+   * @param triangle The triangle.
+   * @param vertices The vertices the triangle indexes into.
+   */
+  inline Vector get_normal(
+      const VertexTriangle& triangle, const std::vector<Vertex>& vertices) {
+    auto& a = vertices[triangle.m_a].m_position;
+    auto& b = vertices[triangle.m_b].m_position;
+    auto& c = vertices[triangle.m_c].m_position;
+    return cross(b - a, c - a);
+  }
+
+  /**
+   * Makes the meshlet bounding a run of triangles.
+   * @param triangles The triangles of a fragment.
+   * @param vertices The vertices the triangles index into.
+   * @param offset The index of the run's first triangle.
+   * @param count The number of triangles in the run.
+   */
+  inline Meshlet make_meshlet(const std::vector<VertexTriangle>& triangles,
+      const std::vector<Vertex>& vertices, int offset, int count) {
+    auto& first = vertices[triangles[offset].m_a].m_position;
+    auto minimum = first;
+    auto maximum = first;
+    auto normals = std::vector<Vector>();
+    auto axis = Vector();
+    for(auto i = offset; i != offset + count; ++i) {
+      auto& triangle = triangles[i];
+      for(auto index : {triangle.m_a, triangle.m_b, triangle.m_c}) {
+        auto& position = vertices[index].m_position;
+        minimum = Point(std::min(minimum.m_x, position.m_x),
+          std::min(minimum.m_y, position.m_y),
+          std::min(minimum.m_z, position.m_z));
+        maximum = Point(std::max(maximum.m_x, position.m_x),
+          std::max(maximum.m_y, position.m_y),
+          std::max(maximum.m_z, position.m_z));
+      }
+      auto normal = get_normal(triangle, vertices);
+      auto length = magnitude(normal);
+      if(length > 0) {
+        normals.push_back(normal / length);
+        axis = axis + normals.back();
+      }
+    }
+    auto cone_cutoff = 1.f;
+    auto axis_length = magnitude(axis);
+    if(axis_length > 0) {
+      axis = axis / axis_length;
+      auto min_cosine = 1.f;
+      for(auto& normal : normals) {
+        min_cosine = std::min(min_cosine, dot(normal, axis));
+      }
+      if(min_cosine > MIN_CONE_COSINE) {
+        cone_cutoff = std::sqrt(1 - min_cosine * min_cosine);
+      }
+    }
+    return Meshlet(offset, count, BoundingBox(minimum, maximum), axis,
+      cone_cutoff);
+  }
+
+  /**
+   * Splits a fragment's triangles into meshlets of consecutive triangles.
+   * Each meshlet holds up to MAX_MESHLET_TRIANGLES triangles, ending early
+   * once it holds MIN_MESHLET_TRIANGLES if the next triangle faces more than
+   * a right angle away from the triangles already in it.
+   * @param triangles The triangles of a fragment.
+   * @param vertices The vertices the triangles index into.
+   * @return The meshlets covering every triangle in order.
+   */
+  inline std::vector<Meshlet> make_meshlets(
+      const std::vector<VertexTriangle>& triangles,
+      const std::vector<Vertex>& vertices) {
+    auto meshlets = std::vector<Meshlet>();
+    auto size = static_cast<int>(triangles.size());
+    auto offset = 0;
+    while(offset != size) {
+      auto count = 0;
+      auto normal_sum = Vector();
+      while(offset + count != size && count != MAX_MESHLET_TRIANGLES) {
+        auto normal = get_normal(triangles[offset + count], vertices);
+        if(count >= MIN_MESHLET_TRIANGLES && dot(normal, normal_sum) < 0) {
+          break;
+        }
+        auto length = magnitude(normal);
+        if(length > 0) {
+          normal_sum = normal_sum + normal / length;
+        }
+        ++count;
+      }
+      meshlets.push_back(make_meshlet(triangles, vertices, offset, count));
+      offset += count;
+    }
+    return meshlets;
+  }
+
+  /**
+   * Tests whether every triangle of a meshlet faces away from a point,
+   * testing the bounding sphere of its bounding box against its normal cone.
+   * @param meshlet The meshlet to test.
+   * @param eye The point viewing the meshlet, in model space.
+   */
+  inline bool is_back_facing(const Meshlet& meshlet, const Point& eye) {
+    if(meshlet.m_cone_cutoff >= 1) {
+      return false;
+    }
+    auto& minimum = meshlet.m_bounding_box.get_minimum();
+    auto& maximum = meshlet.m_bounding_box.get_maximum();
+    auto center = Point((minimum.m_x + maximum.m_x) / 2,
+      (minimum.m_y + maximum.m_y) / 2, (minimum.m_z + maximum.m_z) / 2);
+    auto radius = magnitude(maximum - minimum) / 2;
+    auto offset = center - eye;
+    return dot(offset, meshlet.m_cone_axis) >=
+      meshlet.m_cone_cutoff * magnitude(offset) + radius;
+  }
+
+  /**
+   * Tests whether every triangle of a meshlet faces towards a point.
+   * @param meshlet The meshlet to test.
+   * @param eye The point viewing the meshlet, in model space.
+   */
+  inline bool is_front_facing(const Meshlet& meshlet, const Point& eye) {
+    auto reversed = meshlet;
+    reversed.m_cone_axis = -meshlet.m_cone_axis;
+    return is_back_facing(reversed, eye);
+  }
+}
+
+#endif
@@ -72,10 +72,25 @@ namespace Ashkal {
        */
       Segment& get_segment(const MeshNode& node);
 
+      /**
+       * Returns whether this model is rendered into the occlusion buffer used
+       * to cull the models hidden behind it.
+       */
+      bool is_occluder() const;
+
+      /**
+       * Sets whether this model is rendered into the occlusion buffer used to
+       * cull the models hidden behind it. Occluders should be large, closed
+       * and simple, such as walls and terrain.
+       * @param is_occluder Whether this model is an occluder.
+       */
+      void set_occluder(bool is_occluder);
+
     private:
       std::unordered_map<const MeshNode*, Segment*> m_mesh_to_segment;
       Mesh m_mesh;
       Segment m_root;
+      bool m_is_occluder;
 
       Model(const MeshNode& node);
   };
@@ -139,7 +154,8 @@ namespace Ashkal {
 
   inline Model::Model(Mesh mesh)
     : m_mesh(std::move(mesh)),
-      m_root(nullptr, m_mesh, m_mesh.m_root, m_mesh_to_segment) {}
+      m_root(nullptr, m_mesh, m_mesh.m_root, m_mesh_to_segment),
+      m_is_occluder(false) {}
 
   inline const Mesh& Model::get_mesh() const {
     return m_mesh;
@@ -153,6 +169,14 @@ namespace Ashkal {
     return *m_mesh_to_segment.at(&node);
   }
 
+  inline bool Model::is_occluder() const {
+    return m_is_occluder;
+  }
+
+  inline void Model::set_occluder(bool is_occluder) {
+    m_is_occluder = is_occluder;
+  }
+
   inline Model::Segment::Segment(Segment* parent, const Mesh& mesh,
       const MeshNode& node,
       std::unordered_map<const MeshNode*, Segment*>& mesh_to_segment)
@@ -0,0 +1,196 @@
+#ifndef ASHKAL_OCCLUSION_BUFFER_HPP
+#define ASHKAL_OCCLUSION_BUFFER_HPP
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include "Ashkal/BoundingBox.hpp"
+#include "Ashkal/Camera.hpp"
+#include "Ashkal/Raster.hpp"
+#include "Ashkal/Rasterizer.hpp"
+#include "Ashkal/Renderer.hpp"
+
+namespace Ashkal {
+
+  /**
+   * A low resolution depth buffer rasterized from a set of occluding
+   * triangles, used to cull bounding boxes that lie entirely behind them
+   * before any of their geometry is transformed. Occluders are rasterized
+   * with the same fill rule as the Rasterizer, so that occluders sharing an
+   * edge leave no gaps, but write the farthest depth they have anywhere
+   * within each pixel they cover. Since an occluder may cover only part of a
+   * pixel on its silhouette, boxes are tested against every pixel within one
+   * pixel of their projected bounds.
+   */
+  class OcclusionBuffer {
+    public:
+
+      /**
+       * Constructs an empty OcclusionBuffer.
+       * @param width The width of the buffer in pixels.
+       * @param height The height of the buffer in pixels.
+       */
+      OcclusionBuffer(int width, int height);
+
+      /** Returns the width of the buffer in pixels. */
+      int get_width() const;
+
+      /** Returns the height of the buffer in pixels. */
+      int get_height() const;
+
+      /** Returns the reciprocal depths stored by the buffer. */
+      const DepthBuffer& get_depth_buffer() const;
+
+      /** Removes all occluders. */
+      void clear();
+
+      /**
+       * Adds an occluding triangle.
+       * @param a The first vertex of the triangle in camera space.
+       * @param b The second vertex of the triangle in camera space.
+       * @param c The third vertex of the triangle in camera space.
+       * @param camera The camera the triangle is viewed from.
+       */
+      void add(const Point& a, const Point& b, const Point& c,
+        const Camera& camera);
+
+      /**
+       * Tests whether a bounding box lies entirely behind the occluders.
+       * @param box The bounding box in world space.
+       * @param camera The camera the occluders were viewed from.
+       * @return <code>true</code> iff no point within the box is visible.
+       */
+      bool is_occluded(const BoundingBox& box, const Camera& camera) const;
+
+    private:
+      DepthBuffer m_depth_buffer;
+  };
+
+  inline OcclusionBuffer::OcclusionBuffer(int width, int height)
+      : m_depth_buffer(width, height) {
+    m_depth_buffer.fill(0);
+  }
+
+  inline int OcclusionBuffer::get_width() const {
+    return m_depth_buffer.get_width();
+  }
+
+  inline int OcclusionBuffer::get_height() const {
+    return m_depth_buffer.get_height();
+  }
+
+  inline const DepthBuffer& OcclusionBuffer::get_depth_buffer() const {
+    return m_depth_buffer;
+  }
+
+  inline void OcclusionBuffer::clear() {
+    m_depth_buffer.fill(0);
+  }
+
+  inline void OcclusionBuffer::add(const Point& a, const Point& b,
+      const Point& c, const Camera& camera) {
+    auto near_plane = camera.get_near_plane();
+    if(a.m_z > near_plane || b.m_z > near_plane || c.m_z > near_plane) {
+      return;
+    }
+    auto width = get_width();
+    auto height = get_height();
+    auto vertices = std::array{project_to_subpixel(a, camera, width, height),
+      project_to_subpixel(b, camera, width, height),
+      project_to_subpixel(c, camera, width, height)};
+    auto inverse_z = std::array{-1 / (a.m_z - 1), -1 / (b.m_z - 1),
+      -1 / (c.m_z - 1)};
+    auto edges = std::array{make_edge_function(vertices[1], vertices[2]),
+      make_edge_function(vertices[2], vertices[0]),
+      make_edge_function(vertices[0], vertices[1])};
+    auto area = evaluate(edges[0], vertices[0]);
+    if(area == 0) {
+      return;
+    }
+    if(area < 0) {
+      std::swap(vertices[1], vertices[2]);
+      std::swap(inverse_z[1], inverse_z[2]);
+      edges = std::array{make_edge_function(vertices[1], vertices[2]),
+        make_edge_function(vertices[2], vertices[0]),
+        make_edge_function(vertices[0], vertices[1])};
+      area = -area;
+    }
+    auto plane = make_attribute_plane(edges, area, inverse_z);
+    auto farthest_inverse_z =
+      std::min({inverse_z[0], inverse_z[1], inverse_z[2]});
+    auto margin = (std::abs(plane.m_dx) + std::abs(plane.m_dy)) / 2;
+    auto biases = std::array<int, 3>();
+    for(auto i = 0; i != 3; ++i) {
+      biases[i] = is_top_left(edges[i]) ? 0 : -1;
+    }
+    auto min_x = std::max(0, std::min({vertices[0].m_x, vertices[1].m_x,
+      vertices[2].m_x}) >> SUBPIXEL_BITS);
+    auto max_x = std::min(width - 1, std::max({vertices[0].m_x,
+      vertices[1].m_x, vertices[2].m_x}) >> SUBPIXEL_BITS);
+    auto min_y = std::max(0, std::min({vertices[0].m_y, vertices[1].m_y,
+      vertices[2].m_y}) >> SUBPIXEL_BITS);
+    auto max_y = std::min(height - 1, std::max({vertices[0].m_y,
+      vertices[1].m_y, vertices[2].m_y}) >> SUBPIXEL_BITS);
+    for(auto y = min_y; y <= max_y; ++y) {
+      for(auto x = min_x; x <= max_x; ++x) {
+        auto center = get_pixel_center(x, y);
+        auto is_covered = true;
+        for(auto i = 0; i != 3; ++i) {
+          is_covered =
+            is_covered && evaluate(edges[i], center) + biases[i] >= 0;
+        }
+        if(is_covered) {
+          auto depth = std::max(evaluate(plane, x, y) - margin,
+            farthest_inverse_z) * (1 - DEPTH_BOUND_TOLERANCE);
+          m_depth_buffer(x, y) = std::max(m_depth_buffer(x, y), depth);
+        }
+      }
+    }
+  }
+
+  inline bool OcclusionBuffer::is_occluded(
+      const BoundingBox& box, const Camera& camera) const {
+    auto& minimum = box.get_minimum();
+    auto& maximum = box.get_maximum();
+    auto min_x = static_cast<float>(get_width());
+    auto max_x = -1.f;
+    auto min_y = static_cast<float>(get_height());
+    auto max_y = -1.f;
+    auto nearest_inverse_z = 0.f;
+    for(auto i = 0; i != 8; ++i) {
+      auto corner = world_to_view(Point(i & 1 ? maximum.m_x : minimum.m_x,
+        i & 2 ? maximum.m_y : minimum.m_y, i & 4 ? maximum.m_z : minimum.m_z),
+        camera);
+      if(corner.m_z > camera.get_near_plane()) {
+        return false;
+      }
+      auto screen =
+        project_to_float_screen(corner, camera, get_width(), get_height());
+      min_x = std::min(min_x, screen.m_x);
+      max_x = std::max(max_x, screen.m_x);
+      min_y = std::min(min_y, screen.m_y);
+      max_y = std::max(max_y, screen.m_y);
+      nearest_inverse_z = std::max(nearest_inverse_z, -1 / (corner.m_z - 1));
+    }
+    auto left = std::max(0, static_cast<int>(std::floor(min_x)) - 1);
+    auto right =
+      std::min(get_width() - 1, static_cast<int>(std::floor(max_x)) + 1);
+    auto top = std::max(0, static_cast<int>(std::floor(min_y)) - 1);
+    auto bottom =
+      std::min(get_height() - 1, static_cast<int>(std::floor(max_y)) + 1);
+    if(left > right || top > bottom) {
+      return false;
+    }
+    auto depths = m_depth_buffer.data();
+    for(auto y = top; y <= bottom; ++y) {
+      auto row = depths + y * get_width();
+      if(std::any_of(row + left, row + right + 1, [&] (float depth) {
+          return depth <= nearest_inverse_z;
+        })) {
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+#endif
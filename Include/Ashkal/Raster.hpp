@@ -1,12 +1,20 @@
 #ifndef ASHKAL_RASTER_HPP
 #define ASHKAL_RASTER_HPP
 #include <algorithm>
+#include <cstdint>
 #include <vector>
+#include "Ashkal/Color.hpp"
 
 namespace Ashkal {
 
   /**
    * A two-dimensional raster of values of type T, stored in row-major order.
+   * The raster can be cleared lazily a tile at a time: a cleared tile keeps
+   * its stale values in memory and reads as the clear value until it is
+   * resolved or overwritten. Mutable access to an element resolves only the
+   * tile containing it, so a run of elements addressed from it may only
+   * extend into other tiles once they are resolved, whereas access to the
+   * underlying array resolves every cleared tile first.
    * @param <T> The type of data stored.
    */
   template<typename T>
@@ -16,6 +24,9 @@ namespace Ashkal {
       /** The type of data stored. */
       using Type = T;
 
+      /** The width and height in elements of the tiles cleared lazily. */
+      static constexpr auto CLEAR_TILE_SIZE = 32;
+
       /**
        * Constructs a raster of the given width and height.
        * @param width Number of columns.
@@ -36,27 +47,116 @@ namespace Ashkal {
       int get_byte_size() const;
 
       /**
-       * Read-only element access at (x, y).
+       * Read-only element access at (x, y), returning the clear value within
+       * cleared tiles.
        * @param x Column index [0..width-1]
        * @param y Row index [0..height-1]
        */
       Type operator()(int x, int y) const;
 
       /**
-       * Mutable element access at (x, y).
+       * Mutable element access at (x, y), resolving the tile containing the
+       * element first if it is cleared.
        */
       Type& operator()(int x, int y);
 
       /** Fill the entire raster with the given value. */
       void fill(T value);
 
-      /** Pointer to the underlying contiguous data array. */
+      /**
+       * Clears the entire raster to the given value by marking every tile as
+       * cleared, without writing any element.
+       */
+      void clear(T value);
+
+      /** Returns the value of the last clear. */
+      Type get_clear_value() const;
+
+      /**
+       * Returns <code>true</code> iff every tile overlapping a rectangle is
+       * cleared, so that every element of the rectangle is the clear value.
+       * @param left The left most column of the rectangle.
+       * @param top The top most row of the rectangle.
+       * @param width The width of the rectangle.
+       * @param height The height of the rectangle.
+       */
+      bool is_cleared(int left, int top, int width, int height) const;
+
+      /** Writes the clear value to every cleared tile. */
+      void resolve();
+
+      /**
+       * Writes the clear value to every cleared tile overlapping a rectangle.
+       * @param left The left most column of the rectangle.
+       * @param top The top most row of the rectangle.
+       * @param width The width of the rectangle.
+       * @param height The height of the rectangle.
+       */
+      void resolve(int left, int top, int width, int height);
+
+      /**
+       * Prepares a rectangle to have every one of its elements written,
+       * marking the cleared tiles it contains as no longer cleared and
+       * resolving the cleared tiles it only partially overlaps.
+       * @param left The left most column of the rectangle.
+       * @param top The top most row of the rectangle.
+       * @param width The width of the rectangle.
+       * @param height The height of the rectangle.
+       */
+      void overwrite(int left, int top, int width, int height);
+
+      /**
+       * Copies a rectangle of this raster into the top left corner of another
+       * raster, reading cleared tiles as the clear value without resolving
+       * them. Only the tiles overlapping the rectangle are accessed.
+       * @param left The left most column of the rectangle.
+       * @param top The top most row of the rectangle.
+       * @param width The width of the rectangle.
+       * @param height The height of the rectangle.
+       * @param destination The raster to copy the rectangle into.
+       */
+      void copy_to(int left, int top, int width, int height,
+        Raster& destination) const;
+
+      /**
+       * Copies the top left corner of another raster into a rectangle of this
+       * raster, overwriting the rectangle. Only the tiles overlapping the
+       * rectangle are accessed.
+       * @param source The raster to copy from.
+       * @param left The left most column of the rectangle.
+       * @param top The top most row of the rectangle.
+       * @param width The width of the rectangle.
+       * @param height The height of the rectangle.
+       */
+      void copy_from(
+        const Raster& source, int left, int top, int width, int height);
+
+      /**
+       * Pointer to the underlying contiguous data array, resolving every
+       * cleared tile first. Resolving writes to the raster, so this must not
+       * be called concurrently with any other access while tiles are cleared.
+       */
       const Type* data() const;
 
+      /**
+       * Pointer to the underlying contiguous data array, resolving every
+       * cleared tile first.
+       */
+      Type* data();
+
     private:
       int m_width;
       int m_height;
-      std::vector<Type> m_buffer;
+      mutable std::vector<Type> m_buffer;
+      int m_clear_column_count;
+      mutable bool m_has_clears;
+      T m_clear_value;
+      mutable std::vector<std::uint8_t> m_clears;
+
+      template<typename F>
+      void for_each_tile(int left, int top, int width, int height, F&& f);
+      void resolve_clears() const;
+      void resolve_tile(int column, int row) const;
   };
 
   /** Defines a Raster used for rendering frames. */
@@ -65,11 +165,41 @@ namespace Ashkal {
   /** Defines a Raster used for building a depth buffer. */
   using DepthBuffer = Raster<float>;
 
+  /**
+   * Defines a Raster storing depths as 16-bit unsigned normalized integers.
+   * It is rendered to only through the functions of DepthFormat.hpp; the
+   * renderers keep their depths in a DepthBuffer.
+   */
+  using Depth16Buffer = Raster<std::uint16_t>;
+
+  /**
+   * Defines a Raster storing depths as 24-bit unsigned normalized integers in
+   * the high bits of each value, leaving the low 8 bits for a stencil or
+   * identifier. Like the Depth16Buffer, it is rendered to only through the
+   * functions of DepthFormat.hpp.
+   */
+  using Depth24Buffer = Raster<std::uint32_t>;
+
+  /**
+   * Defines a Raster storing, for each pixel, which triangle of which draw is
+   * visible at that pixel.
+   */
+  using VisibilityBuffer = Raster<std::uint64_t>;
+
+  /**
+   * Defines a Raster marking the pixels a triangle has drawn to but not yet
+   * shaded.
+   */
+  using CoverageBuffer = Raster<std::uint8_t>;
+
   template<typename T>
   Raster<T>::Raster(int width, int height)
     : m_width(width),
       m_height(height),
-      m_buffer(width * height) {}
+      m_buffer(width * height),
+      m_clear_column_count((width + CLEAR_TILE_SIZE - 1) / CLEAR_TILE_SIZE),
+      m_has_clears(false),
+      m_clear_value() {}
 
   template<typename T>
   int Raster<T>::get_width() const {
@@ -93,23 +223,184 @@ namespace Ashkal {
 
   template<typename T>
   typename Raster<T>::Type Raster<T>::operator()(int x, int y) const {
+    if(m_has_clears && m_clears[(y / CLEAR_TILE_SIZE) * m_clear_column_count +
+        x / CLEAR_TILE_SIZE]) {
+      return m_clear_value;
+    }
     return m_buffer[y * m_width + x];
   }
 
   template<typename T>
   typename Raster<T>::Type& Raster<T>::operator()(int x, int y) {
+    if(m_has_clears) {
+      resolve_tile(x / CLEAR_TILE_SIZE, y / CLEAR_TILE_SIZE);
+    }
     return m_buffer[y * m_width + x];
   }
 
   template<typename T>
   void Raster<T>::fill(T value) {
     std::fill(m_buffer.begin(), m_buffer.end(), value);
+    m_has_clears = false;
+  }
+
+  template<typename T>
+  void Raster<T>::clear(T value) {
+    m_clear_value = value;
+    m_clears.assign(m_clear_column_count *
+      ((m_height + CLEAR_TILE_SIZE - 1) / CLEAR_TILE_SIZE), 1);
+    m_has_clears = true;
+  }
+
+  template<typename T>
+  typename Raster<T>::Type Raster<T>::get_clear_value() const {
+    return m_clear_value;
+  }
+
+  template<typename T>
+  bool Raster<T>::is_cleared(int left, int top, int width, int height) const {
+    if(!m_has_clears) {
+      return false;
+    }
+    for(auto row = top / CLEAR_TILE_SIZE;
+        row <= (top + height - 1) / CLEAR_TILE_SIZE; ++row) {
+      for(auto column = left / CLEAR_TILE_SIZE;
+          column <= (left + width - 1) / CLEAR_TILE_SIZE; ++column) {
+        if(!m_clears[row * m_clear_column_count + column]) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  template<typename T>
+  void Raster<T>::resolve() {
+    resolve_clears();
+  }
+
+  template<typename T>
+  void Raster<T>::resolve(int left, int top, int width, int height) {
+    for_each_tile(left, top, width, height,
+      [&] (int column, int row, bool) {
+        resolve_tile(column, row);
+      });
+  }
+
+  template<typename T>
+  void Raster<T>::overwrite(int left, int top, int width, int height) {
+    for_each_tile(left, top, width, height,
+      [&] (int column, int row, bool is_contained) {
+        if(is_contained) {
+          m_clears[row * m_clear_column_count + column] = 0;
+        } else {
+          resolve_tile(column, row);
+        }
+      });
+  }
+
+  template<typename T>
+  void Raster<T>::copy_to(int left, int top, int width, int height,
+      Raster& destination) const {
+    destination.overwrite(0, 0, width, height);
+    for(auto y = 0; y != height; ++y) {
+      auto source = m_buffer.begin() + (top + y) * m_width;
+      auto target = destination.m_buffer.begin() + y * destination.m_width;
+      auto x = left;
+      while(x != left + width) {
+        auto end = std::min(
+          (x / CLEAR_TILE_SIZE + 1) * CLEAR_TILE_SIZE, left + width);
+        if(m_has_clears && m_clears[((top + y) / CLEAR_TILE_SIZE) *
+            m_clear_column_count + x / CLEAR_TILE_SIZE]) {
+          std::fill(target + (x - left), target + (end - left),
+            m_clear_value);
+        } else {
+          std::copy(source + x, source + end, target + (x - left));
+        }
+        x = end;
+      }
+    }
+  }
+
+  template<typename T>
+  void Raster<T>::copy_from(
+      const Raster& source, int left, int top, int width, int height) {
+    overwrite(left, top, width, height);
+    for(auto y = 0; y != height; ++y) {
+      std::copy_n(source.data() + y * source.m_width, width,
+        m_buffer.begin() + (top + y) * m_width + left);
+    }
   }
 
   template<typename T>
   const typename Raster<T>::Type* Raster<T>::data() const {
+    if(m_has_clears) {
+      resolve_clears();
+    }
+    return m_buffer.data();
+  }
+
+  template<typename T>
+  typename Raster<T>::Type* Raster<T>::data() {
+    if(m_has_clears) {
+      resolve();
+    }
     return m_buffer.data();
   }
+
+  template<typename T>
+  template<typename F>
+  void Raster<T>::for_each_tile(
+      int left, int top, int width, int height, F&& f) {
+    if(!m_has_clears || width <= 0 || height <= 0) {
+      return;
+    }
+    auto right = left + width;
+    auto bottom = top + height;
+    for(auto row = top / CLEAR_TILE_SIZE;
+        row <= (bottom - 1) / CLEAR_TILE_SIZE; ++row) {
+      auto tile_top = row * CLEAR_TILE_SIZE;
+      auto tile_bottom = std::min(tile_top + CLEAR_TILE_SIZE, m_height);
+      for(auto column = left / CLEAR_TILE_SIZE;
+          column <= (right - 1) / CLEAR_TILE_SIZE; ++column) {
+        if(m_clears[row * m_clear_column_count + column]) {
+          auto tile_left = column * CLEAR_TILE_SIZE;
+          auto tile_right = std::min(tile_left + CLEAR_TILE_SIZE, m_width);
+          f(column, row, left <= tile_left && tile_right <= right &&
+            top <= tile_top && tile_bottom <= bottom);
+        }
+      }
+    }
+  }
+
+  template<typename T>
+  void Raster<T>::resolve_clears() const {
+    if(!m_has_clears) {
+      return;
+    }
+    for(auto row = 0;
+        row != (m_height + CLEAR_TILE_SIZE - 1) / CLEAR_TILE_SIZE; ++row) {
+      for(auto column = 0; column != m_clear_column_count; ++column) {
+        resolve_tile(column, row);
+      }
+    }
+    m_has_clears = false;
+  }
+
+  template<typename T>
+  void Raster<T>::resolve_tile(int column, int row) const {
+    auto& clear = m_clears[row * m_clear_column_count + column];
+    if(!clear) {
+      return;
+    }
+    auto left = column * CLEAR_TILE_SIZE;
+    auto width = std::min(CLEAR_TILE_SIZE, m_width - left);
+    for(auto y = row * CLEAR_TILE_SIZE;
+        y != std::min((row + 1) * CLEAR_TILE_SIZE, m_height); ++y) {
+      std::fill_n(m_buffer.begin() + y * m_width + left, width, m_clear_value);
+    }
+    clear = 0;
+  }
 }
 
 #endif
@@ -0,0 +1,1885 @@
+#ifndef ASHKAL_RASTERIZER_HPP
+#define ASHKAL_RASTERIZER_HPP
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include "Ashkal/Camera.hpp"
+#include "Ashkal/HierarchicalDepthBuffer.hpp"
+#include "Ashkal/Lanes.hpp"
+#include "Ashkal/Material.hpp"
+#include "Ashkal/Raster.hpp"
+#include "Ashkal/Renderer.hpp"
+#include "Ashkal/ShadedVertex.hpp"
+
+namespace Ashkal {
+
+  /**
+   * Stores the edge function E(x, y) = a * x + b * y + c of a directed edge
+   * between two subpixel coordinates. The edge function is positive for points
+   * to the left of the edge and changes by a constant amount per subpixel,
+   * which allows it to be evaluated incrementally across the screen. Since the
+   * coefficients are integers, the edge function is evaluated exactly and
+   * neighbouring triangles agree on which side of a shared edge a point lies.
+   */
+  struct EdgeFunction {
+
+    /** The change in the edge function per subpixel step along x. */
+    int m_a;
+
+    /** The change in the edge function per subpixel step along y. */
+    int m_b;
+
+    /** The value of the edge function at the origin. */
+    std::int64_t m_c;
+  };
+
+  /**
+   * Builds the edge function of the directed edge from p1 to p2.
+   * @param p1 The start of the edge.
+   * @param p2 The end of the edge.
+   * @return The EdgeFunction of the edge.
+   */
+  inline EdgeFunction make_edge_function(
+      SubpixelCoordinate p1, SubpixelCoordinate p2) {
+    return EdgeFunction(p1.m_y - p2.m_y, p2.m_x - p1.m_x,
+      static_cast<std::int64_t>(p1.m_x) * p2.m_y -
+        static_cast<std::int64_t>(p1.m_y) * p2.m_x);
+  }
+
+  /**
+   * Evaluates an edge function at a point.
+   * @param edge The edge function to evaluate.
+   * @param point The point to evaluate the edge function at.
+   * @return The value of the edge function at the point.
+   */
+  inline std::int64_t evaluate(
+      const EdgeFunction& edge, SubpixelCoordinate point) {
+    return static_cast<std::int64_t>(edge.m_a) * point.m_x +
+      static_cast<std::int64_t>(edge.m_b) * point.m_y + edge.m_c;
+  }
+
+  /**
+   * The magnitude beyond which the value of an edge function is clamped when
+   * it is narrowed to 32 bits.
+   */
+  const auto EDGE_LIMIT = std::int64_t(1) << 30;
+
+  /**
+   * Narrows the value of an edge function to 32 bits. Values are clamped to
+   * [-EDGE_LIMIT, EDGE_LIMIT], so a clamped value stepped by less than
+   * EDGE_LIMIT keeps the sign of the exact value.
+   * @param w The value of the edge function.
+   * @return The value clamped to [-EDGE_LIMIT, EDGE_LIMIT].
+   */
+  inline std::int32_t narrow_edge(std::int64_t w) {
+    return static_cast<std::int32_t>(std::clamp(w, -EDGE_LIMIT, EDGE_LIMIT));
+  }
+
+  /**
+   * Returns <code>true</code> iff an edge is a top or left edge of a triangle
+   * whose edge functions are positive in its interior. Points lying exactly on
+   * an edge are only covered by the triangle if the edge is a top or left
+   * edge, so that pixels on an edge shared by two triangles are rasterized
+   * exactly once.
+   * @param edge The edge function to test.
+   */
+  inline bool is_top_left(const EdgeFunction& edge) {
+    return edge.m_a > 0 || (edge.m_a == 0 && edge.m_b > 0);
+  }
+
+  /**
+   * Returns the subpixel coordinate of a pixel's center.
+   * @param x The pixel's column.
+   * @param y The pixel's row.
+   * @return The SubpixelCoordinate of the center of the pixel.
+   */
+  inline SubpixelCoordinate get_pixel_center(int x, int y) {
+    return SubpixelCoordinate(x * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2,
+      y * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2);
+  }
+
+  /**
+   * Stores the plane equation f(x, y) = value + dx * x + dy * y of an attribute
+   * that varies linearly across the screen, where (x, y) is a pixel, so that
+   * the attribute can be interpolated by repeated addition.
+   */
+  struct AttributePlane {
+
+    /** The value of the attribute at pixel (0, 0). */
+    float m_value;
+
+    /** The change in the attribute per pixel along x. */
+    float m_dx;
+
+    /** The change in the attribute per pixel along y. */
+    float m_dy;
+  };
+
+  /**
+   * Builds the plane equation of an attribute from its value at each vertex of
+   * a triangle.
+   * @param edges The triangle's edge functions, where edges[i] is opposite to
+   *        vertex i.
+   * @param area The value of each edge function at its opposite vertex.
+   * @param values The attribute's value at each vertex.
+   * @return The AttributePlane interpolating the values across the triangle.
+   */
+  inline AttributePlane make_attribute_plane(
+      const std::array<EdgeFunction, 3>& edges, std::int64_t area,
+      const std::array<float, 3>& values) {
+    auto origin = get_pixel_center(0, 0);
+    auto value = 0.0;
+    auto dx = 0.0;
+    auto dy = 0.0;
+    for(auto i = 0; i != 3; ++i) {
+      value += static_cast<double>(evaluate(edges[i], origin)) * values[i];
+      dx += static_cast<double>(edges[i].m_a) * values[i];
+      dy += static_cast<double>(edges[i].m_b) * values[i];
+    }
+    auto scale = 1.0 / static_cast<double>(area);
+    return AttributePlane(static_cast<float>(value * scale),
+      static_cast<float>(dx * SUBPIXEL_SCALE * scale),
+      static_cast<float>(dy * SUBPIXEL_SCALE * scale));
+  }
+
+  /**
+   * Evaluates an attribute's plane equation at a pixel.
+   * @param plane The plane equation to evaluate.
+   * @param x The pixel's column.
+   * @param y The pixel's row.
+   * @return The value of the attribute at the pixel.
+   */
+  inline float evaluate(const AttributePlane& plane, int x, int y) {
+    return plane.m_value + plane.m_dx * static_cast<float>(x) +
+      plane.m_dy * static_cast<float>(y);
+  }
+
+  /**
+   * Stores the per-triangle state computed once before rasterization, so that
+   * the per-pixel loop only needs additions and multiplications.
+   */
+  struct TriangleSetup {
+
+    /**
+     * The edge functions opposite to each vertex, such that m_edges[i]
+     * evaluates to the unnormalized barycentric weight of vertex i.
+     */
+    std::array<EdgeFunction, 3> m_edges;
+
+    /**
+     * The amount added to each edge function before testing coverage, 0 for
+     * top or left edges and -1 otherwise, such that a point is covered iff all
+     * three biased edge functions are non-negative.
+     */
+    std::array<int, 3> m_biases;
+
+    /**
+     * The value of each edge function at its opposite vertex, which is twice
+     * the triangle's area in square subpixels.
+     */
+    std::int64_t m_area;
+
+    /** The left most pixel column covered by the triangle's bounds. */
+    int m_min_x;
+
+    /** The right most pixel column covered by the triangle's bounds. */
+    int m_max_x;
+
+    /** The top most pixel row covered by the triangle's bounds. */
+    int m_min_y;
+
+    /** The bottom most pixel row covered by the triangle's bounds. */
+    int m_max_y;
+
+    /** The greatest reciprocal depth among the triangle's vertices. */
+    float m_nearest_inverse_z;
+
+    /** The least reciprocal depth among the triangle's vertices. */
+    float m_farthest_inverse_z;
+
+    /**
+     * The number of pixels between exact perspective corrections of the
+     * texture coordinates along a row, or 1 if every pixel is corrected.
+     */
+    int m_affine_span;
+
+    /** The reciprocal of the depth, which is also what is depth tested. */
+    AttributePlane m_inverse_z;
+
+    /** The u texture coordinate divided by the depth. */
+    AttributePlane m_u_over_z;
+
+    /** The v texture coordinate divided by the depth. */
+    AttributePlane m_v_over_z;
+
+    /** The red channel of the light's color. */
+    AttributePlane m_red;
+
+    /** The green channel of the light's color. */
+    AttributePlane m_green;
+
+    /** The blue channel of the light's color. */
+    AttributePlane m_blue;
+
+    /** The light's intensity. */
+    AttributePlane m_intensity;
+  };
+
+  /**
+   * Computes the setup of a triangle in camera space, whose bounds cover the
+   * pixels having at least one sample point within the triangle's bounds.
+   * @param a The first vertex of the triangle.
+   * @param b The second vertex of the triangle.
+   * @param c The third vertex of the triangle.
+   * @param camera The camera used to project the triangle onto the screen.
+   * @param width The width of the viewport in pixels.
+   * @param height The height of the viewport in pixels.
+   * @param min_offset The least subpixel offset along either axis, from a
+   *        pixel's top left corner, of the points sampled within each pixel.
+   * @param max_offset The greatest subpixel offset along either axis, from a
+   *        pixel's top left corner, of the points sampled within each pixel.
+   * @return The triangle's setup, or std::nullopt if the triangle has no area
+   *         or does not overlap the viewport.
+   */
+  inline std::optional<TriangleSetup> make_triangle_setup(
+      const ShadedVertex& a, const ShadedVertex& b, const ShadedVertex& c,
+      const Camera& camera, int width, int height, int min_offset,
+      int max_offset) {
+    auto screen_a = project_to_subpixel(a.m_position, camera, width, height);
+    auto screen_b = project_to_subpixel(b.m_position, camera, width, height);
+    auto screen_c = project_to_subpixel(c.m_position, camera, width, height);
+    auto setup = TriangleSetup();
+    setup.m_edges[0] = make_edge_function(screen_b, screen_c);
+    setup.m_edges[1] = make_edge_function(screen_c, screen_a);
+    setup.m_edges[2] = make_edge_function(screen_a, screen_b);
+    auto area = evaluate(setup.m_edges[0], screen_a);
+    if(area <= 0) {
+      return std::nullopt;
+    }
+    setup.m_area = area;
+    for(auto i = 0; i != 3; ++i) {
+      setup.m_biases[i] = is_top_left(setup.m_edges[i]) ? 0 : -1;
+    }
+    auto to_first_pixel = [&] (int subpixel) {
+      return (subpixel - max_offset + SUBPIXEL_SCALE - 1) >> SUBPIXEL_BITS;
+    };
+    auto to_last_pixel = [&] (int subpixel) {
+      return (subpixel - min_offset) >> SUBPIXEL_BITS;
+    };
+    setup.m_min_x = std::max(0,
+      to_first_pixel(std::min({screen_a.m_x, screen_b.m_x, screen_c.m_x})));
+    setup.m_max_x = std::min(width - 1,
+      to_last_pixel(std::max({screen_a.m_x, screen_b.m_x, screen_c.m_x})));
+    setup.m_min_y = std::max(0,
+      to_first_pixel(std::min({screen_a.m_y, screen_b.m_y, screen_c.m_y})));
+    setup.m_max_y = std::min(height - 1,
+      to_last_pixel(std::max({screen_a.m_y, screen_b.m_y, screen_c.m_y})));
+    if(setup.m_min_x > setup.m_max_x || setup.m_min_y > setup.m_max_y) {
+      return std::nullopt;
+    }
+    auto vertices = std::array{&a, &b, &c};
+    auto inverse_z = std::array<float, 3>();
+    auto u_over_z = std::array<float, 3>();
+    auto v_over_z = std::array<float, 3>();
+    auto red = std::array<float, 3>();
+    auto green = std::array<float, 3>();
+    auto blue = std::array<float, 3>();
+    auto intensity = std::array<float, 3>();
+    for(auto i = 0; i != 3; ++i) {
+      auto& vertex = *vertices[i];
+      inverse_z[i] = -1 / (vertex.m_position.m_z - 1);
+      u_over_z[i] = vertex.m_uv.m_u * inverse_z[i];
+      v_over_z[i] = vertex.m_uv.m_v * inverse_z[i];
+      red[i] = vertex.m_shading.m_color.get_red();
+      green[i] = vertex.m_shading.m_color.get_green();
+      blue[i] = vertex.m_shading.m_color.get_blue();
+      intensity[i] = vertex.m_shading.m_intensity;
+    }
+    setup.m_nearest_inverse_z = std::max({inverse_z[0], inverse_z[1],
+      inverse_z[2]});
+    setup.m_farthest_inverse_z = std::min({inverse_z[0], inverse_z[1],
+      inverse_z[2]});
+    setup.m_affine_span = 1;
+    setup.m_inverse_z = make_attribute_plane(setup.m_edges, area, inverse_z);
+    setup.m_u_over_z = make_attribute_plane(setup.m_edges, area, u_over_z);
+    setup.m_v_over_z = make_attribute_plane(setup.m_edges, area, v_over_z);
+    setup.m_red = make_attribute_plane(setup.m_edges, area, red);
+    setup.m_green = make_attribute_plane(setup.m_edges, area, green);
+    setup.m_blue = make_attribute_plane(setup.m_edges, area, blue);
+    setup.m_intensity = make_attribute_plane(setup.m_edges, area, intensity);
+    return setup;
+  }
+
+  /**
+   * Computes the setup of a triangle in camera space that is sampled at the
+   * center of each pixel.
+   * @param a The first vertex of the triangle.
+   * @param b The second vertex of the triangle.
+   * @param c The third vertex of the triangle.
+   * @param camera The camera used to project the triangle onto the screen.
+   * @param width The width of the viewport in pixels.
+   * @param height The height of the viewport in pixels.
+   * @return The triangle's setup, or std::nullopt if the triangle has no area
+   *         or does not overlap the viewport.
+   */
+  inline std::optional<TriangleSetup> make_triangle_setup(
+      const ShadedVertex& a, const ShadedVertex& b, const ShadedVertex& c,
+      const Camera& camera, int width, int height) {
+    return make_triangle_setup(a, b, c, camera, width, height,
+      SUBPIXEL_SCALE / 2, SUBPIXEL_SCALE / 2);
+  }
+
+  /** The number of samples stored per pixel when multisampling. */
+  const auto SAMPLE_COUNT = 4;
+
+  /**
+   * The subpixel offset of each sample from its pixel's top left corner. The
+   * samples lie on a rotated grid, so that edges close to horizontal or
+   * vertical still cover SAMPLE_COUNT + 1 distinct fractions of a pixel.
+   */
+  const auto SAMPLE_OFFSETS = std::array{SubpixelCoordinate(6, 2),
+    SubpixelCoordinate(14, 6), SubpixelCoordinate(2, 10),
+    SubpixelCoordinate(10, 14)};
+
+  /**
+   * Computes the setup of a triangle in camera space that is sampled at each
+   * of SAMPLE_OFFSETS within a pixel.
+   * @param a The first vertex of the triangle.
+   * @param b The second vertex of the triangle.
+   * @param c The third vertex of the triangle.
+   * @param camera The camera used to project the triangle onto the screen.
+   * @param width The width of the viewport in pixels.
+   * @param height The height of the viewport in pixels.
+   * @return The triangle's setup, or std::nullopt if the triangle has no area
+   *         or does not overlap the viewport.
+   */
+  inline std::optional<TriangleSetup> make_multisample_triangle_setup(
+      const ShadedVertex& a, const ShadedVertex& b, const ShadedVertex& c,
+      const Camera& camera, int width, int height) {
+    auto min_offset = SUBPIXEL_SCALE;
+    auto max_offset = 0;
+    for(auto& offset : SAMPLE_OFFSETS) {
+      min_offset = std::min({min_offset, offset.m_x, offset.m_y});
+      max_offset = std::max({max_offset, offset.m_x, offset.m_y});
+    }
+    return make_triangle_setup(
+      a, b, c, camera, width, height, min_offset, max_offset);
+  }
+
+  /**
+   * Specifies how often a triangle's texture coordinates are corrected for
+   * perspective along a row of pixels. Between corrections, texture
+   * coordinates are interpolated affinely, which saves the reciprocal of the
+   * depth at every pixel at the cost of an error that grows with how much the
+   * depth changes between corrections.
+   */
+  struct PerspectiveCorrection {
+
+    /**
+     * The number of pixels between exact corrections, or 1 to correct every
+     * pixel.
+     */
+    int m_span;
+
+    /**
+     * The greatest relative change in a triangle's reciprocal depth across
+     * m_span pixels for which its texture coordinates are interpolated
+     * affinely. Steeper triangles are corrected at every pixel.
+     */
+    float m_tolerance;
+  };
+
+  /** The PerspectiveCorrection correcting every pixel. */
+  const auto EXACT_PERSPECTIVE_CORRECTION = PerspectiveCorrection(1, 0.f);
+
+  /**
+   * Chooses how often a triangle's texture coordinates are corrected for
+   * perspective.
+   * @param setup The setup of the triangle.
+   * @param correction The requested perspective correction.
+   */
+  inline void correct_perspective(
+      TriangleSetup& setup, const PerspectiveCorrection& correction) {
+    if(correction.m_span > 1 &&
+        std::abs(setup.m_inverse_z.m_dx) * static_cast<float>(
+          correction.m_span) <=
+            correction.m_tolerance * setup.m_farthest_inverse_z) {
+      setup.m_affine_span = correction.m_span;
+    } else {
+      setup.m_affine_span = 1;
+    }
+  }
+
+  /**
+   * The width and height in pixels of the blocks that are tested against a
+   * triangle's edges before any per-pixel work is done.
+   */
+  const auto BLOCK_SIZE = 8;
+
+  /**
+   * The relative amount by which bounds on a triangle's reciprocal depth are
+   * widened to account for the rounding of incrementally interpolated depths.
+   */
+  const auto DEPTH_BOUND_TOLERANCE = 1e-4f;
+
+  /**
+   * Returns a bound on the nearest depth of a triangle within a rectangle of
+   * pixels.
+   * @param setup The setup of the triangle.
+   * @param min_x The left most column of the rectangle.
+   * @param min_y The top most row of the rectangle.
+   * @param max_x The right most column of the rectangle.
+   * @param max_y The bottom most row of the rectangle.
+   * @return A value no less than the triangle's interpolated reciprocal depth
+   *         at any of the rectangle's pixels.
+   */
+  inline float get_nearest(const TriangleSetup& setup, int min_x, int min_y,
+      int max_x, int max_y) {
+    auto& plane = setup.m_inverse_z;
+    auto nearest = evaluate(plane, min_x, min_y) +
+      std::max(plane.m_dx, 0.f) * static_cast<float>(max_x - min_x) +
+      std::max(plane.m_dy, 0.f) * static_cast<float>(max_y - min_y);
+    return std::min(nearest, setup.m_nearest_inverse_z) *
+      (1 + DEPTH_BOUND_TOLERANCE);
+  }
+
+  /**
+   * Returns a bound on the farthest depth of a triangle within a rectangle of
+   * pixels.
+   * @param setup The setup of the triangle.
+   * @param min_x The left most column of the rectangle.
+   * @param min_y The top most row of the rectangle.
+   * @param max_x The right most column of the rectangle.
+   * @param max_y The bottom most row of the rectangle.
+   * @return A value no greater than the triangle's interpolated reciprocal
+   *         depth at any of the rectangle's pixels.
+   */
+  inline float get_farthest(const TriangleSetup& setup, int min_x, int min_y,
+      int max_x, int max_y) {
+    auto& plane = setup.m_inverse_z;
+    auto farthest = evaluate(plane, min_x, min_y) +
+      std::min(plane.m_dx, 0.f) * static_cast<float>(max_x - min_x) +
+      std::min(plane.m_dy, 0.f) * static_cast<float>(max_y - min_y);
+    return std::max(farthest, setup.m_farthest_inverse_z) *
+      (1 - DEPTH_BOUND_TOLERANCE);
+  }
+
+  /**
+   * Tests whether a triangle covers every pixel of a rectangle.
+   * @param setup The setup of the triangle.
+   * @param min_x The left most column of the rectangle.
+   * @param min_y The top most row of the rectangle.
+   * @param max_x The right most column of the rectangle.
+   * @param max_y The bottom most row of the rectangle.
+   * @return <code>true</code> iff every pixel of the rectangle is covered.
+   */
+  inline bool is_covered(const TriangleSetup& setup, int min_x, int min_y,
+      int max_x, int max_y) {
+    for(auto i = 0; i != 3; ++i) {
+      auto& edge = setup.m_edges[i];
+      auto x = edge.m_a < 0 ? max_x : min_x;
+      auto y = edge.m_b < 0 ? max_y : min_y;
+      if(evaluate(edge, get_pixel_center(x, y)) + setup.m_biases[i] < 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Tests whether a triangle lies behind every depth stored within a
+   * rectangle of pixels.
+   * @param setup The setup of the triangle.
+   * @param hierarchical_depth_buffer The bounds on the window's depths.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param min_x The left most screen column of the rectangle.
+   * @param min_y The top most screen row of the rectangle.
+   * @param max_x The right most screen column of the rectangle.
+   * @param max_y The bottom most screen row of the rectangle.
+   * @return <code>true</code> iff none of the triangle's pixels within the
+   *         rectangle can pass the depth test.
+   */
+  inline bool is_occluded(const TriangleSetup& setup,
+      const HierarchicalDepthBuffer& hierarchical_depth_buffer, int left,
+      int top, int min_x, int min_y, int max_x, int max_y) {
+    return get_nearest(setup, min_x, min_y, max_x, max_y) <
+      hierarchical_depth_buffer.get_farthest(
+        min_x - left, min_y - top, max_x - left, max_y - top);
+  }
+
+  /**
+   * Raises the bounds of the blocks of a HierarchicalDepthBuffer that a
+   * triangle entirely covers, after the triangle has been depth tested and
+   * written to the bounded DepthBuffer.
+   * @param hierarchical_depth_buffer The bounds on the window's depths.
+   * @param setup The setup of the triangle.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   */
+  inline void raise(HierarchicalDepthBuffer& hierarchical_depth_buffer,
+      const TriangleSetup& setup, int left, int top) {
+    auto min_x = std::max(setup.m_min_x - left, 0);
+    auto max_x =
+      std::min(setup.m_max_x - left, hierarchical_depth_buffer.get_width() - 1);
+    auto min_y = std::max(setup.m_min_y - top, 0);
+    auto max_y = std::min(
+      setup.m_max_y - top, hierarchical_depth_buffer.get_height() - 1);
+    const auto size = HierarchicalDepthBuffer::BLOCK_SIZE;
+    for(auto y = min_y - min_y % size; y <= max_y; y += size) {
+      auto end_y = std::min(y + size, hierarchical_depth_buffer.get_height());
+      for(auto x = min_x - min_x % size; x <= max_x; x += size) {
+        auto end_x = std::min(x + size, hierarchical_depth_buffer.get_width());
+        if(is_covered(setup, left + x, top + y, left + end_x - 1,
+            top + end_y - 1)) {
+          hierarchical_depth_buffer.raise(x, y, get_farthest(setup, left + x,
+            top + y, left + end_x - 1, top + end_y - 1));
+        }
+      }
+    }
+  }
+
+  /** Stores a triangle's attributes across a run of LANE_COUNT pixels. */
+  struct AttributeLanes {
+
+    /** The reciprocal of the depth. */
+    FloatLanes m_inverse_z;
+
+    /** The u texture coordinate divided by the depth. */
+    FloatLanes m_u_over_z;
+
+    /** The v texture coordinate divided by the depth. */
+    FloatLanes m_v_over_z;
+
+    /** The red channel of the light's color. */
+    FloatLanes m_red;
+
+    /** The green channel of the light's color. */
+    FloatLanes m_green;
+
+    /** The blue channel of the light's color. */
+    FloatLanes m_blue;
+
+    /** The light's intensity. */
+    FloatLanes m_intensity;
+  };
+
+  /**
+   * Evaluates a triangle's attributes across a run of pixels.
+   * @param setup The setup of the triangle.
+   * @param x The column of the run's left most pixel.
+   * @param y The row of the run.
+   * @return The attributes of the run's pixels.
+   */
+  inline AttributeLanes evaluate(const TriangleSetup& setup, int x, int y) {
+    auto ramp = make_ramp();
+    auto evaluate_lanes = [&] (const AttributePlane& plane) {
+      return FloatLanes(evaluate(plane, x, y)) + plane.m_dx * ramp;
+    };
+    return AttributeLanes(evaluate_lanes(setup.m_inverse_z),
+      evaluate_lanes(setup.m_u_over_z), evaluate_lanes(setup.m_v_over_z),
+      evaluate_lanes(setup.m_red), evaluate_lanes(setup.m_green),
+      evaluate_lanes(setup.m_blue), evaluate_lanes(setup.m_intensity));
+  }
+
+  /**
+   * Returns the change in a triangle's attributes across a run of pixels when
+   * the run is moved by a number of pixels along x and y.
+   * @param setup The setup of the triangle.
+   * @param dx The number of pixels moved along x.
+   * @param dy The number of pixels moved along y.
+   */
+  inline AttributeLanes get_step(const TriangleSetup& setup, int dx, int dy) {
+    auto get_lanes = [&] (const AttributePlane& plane) {
+      return FloatLanes(plane.m_dx * static_cast<float>(dx) +
+        plane.m_dy * static_cast<float>(dy));
+    };
+    return AttributeLanes(get_lanes(setup.m_inverse_z),
+      get_lanes(setup.m_u_over_z), get_lanes(setup.m_v_over_z),
+      get_lanes(setup.m_red), get_lanes(setup.m_green),
+      get_lanes(setup.m_blue), get_lanes(setup.m_intensity));
+  }
+
+  /**
+   * Moves a run of attributes by a step.
+   * @param attributes The attributes to move.
+   * @param step The step, as returned by get_step.
+   */
+  inline void advance(AttributeLanes& attributes, const AttributeLanes& step) {
+    attributes.m_inverse_z += step.m_inverse_z;
+    attributes.m_u_over_z += step.m_u_over_z;
+    attributes.m_v_over_z += step.m_v_over_z;
+    attributes.m_red += step.m_red;
+    attributes.m_green += step.m_green;
+    attributes.m_blue += step.m_blue;
+    attributes.m_intensity += step.m_intensity;
+  }
+
+  /**
+   * Stores a triangle's perspective correct texture coordinates at LANE_COUNT
+   * nodes spaced m_affine_span pixels apart along a row, between which its
+   * texture coordinates are interpolated affinely.
+   */
+  struct AffineSpan {
+
+    /** The row the nodes lie on, or -1 if no nodes are stored. */
+    int m_y = -1;
+
+    /** The column of the first node. */
+    int m_x = 0;
+
+    /** The u texture coordinate at each node. */
+    std::array<float, LANE_COUNT> m_u = {};
+
+    /** The v texture coordinate at each node. */
+    std::array<float, LANE_COUNT> m_v = {};
+  };
+
+  /**
+   * Interpolates a triangle's texture coordinates affinely across a run of
+   * pixels between the nodes of an AffineSpan, computing new nodes, with a
+   * single reciprocal for all of them, when the run lies outside of the
+   * stored nodes.
+   * @param setup The setup of the triangle, whose m_affine_span is at least 2.
+   * @param span The nodes of the row being shaded.
+   * @param x The column of the run's left most pixel.
+   * @param y The row of the run.
+   * @param u Set to the u texture coordinate of each pixel.
+   * @param v Set to the v texture coordinate of each pixel.
+   */
+  inline void interpolate(const TriangleSetup& setup, AffineSpan& span, int x,
+      int y, FloatLanes& u, FloatLanes& v) {
+    auto size = setup.m_affine_span;
+    auto ramp = make_ramp();
+    if(y != span.m_y || x < span.m_x ||
+        x + LANE_COUNT - 1 > span.m_x + (LANE_COUNT - 1) * size) {
+      span.m_y = y;
+      span.m_x = x - x % size;
+      auto node_ramp = static_cast<float>(size) * ramp;
+      auto evaluate_nodes = [&] (const AttributePlane& plane) {
+        return FloatLanes(evaluate(plane, span.m_x, y)) +
+          plane.m_dx * node_ramp;
+      };
+      auto depth = FloatLanes(1) / evaluate_nodes(setup.m_inverse_z);
+      store(evaluate_nodes(setup.m_u_over_z) * depth, span.m_u.data());
+      store(evaluate_nodes(setup.m_v_over_z) * depth, span.m_v.data());
+    }
+    auto position = FloatLanes(static_cast<float>(x)) + ramp;
+    auto interpolate_segment = [&] (
+        const std::array<float, LANE_COUNT>& values, int node) {
+      auto slope = (values[node + 1] - values[node]) / static_cast<float>(size);
+      return FloatLanes(values[node]) + FloatLanes(slope) *
+        (position - static_cast<float>(span.m_x + node * size));
+    };
+    auto segment = (x - span.m_x) / size;
+    u = interpolate_segment(span.m_u, segment);
+    v = interpolate_segment(span.m_v, segment);
+    for(auto boundary = span.m_x + (segment + 1) * size;
+        boundary <= x + LANE_COUNT - 1; boundary += size) {
+      segment = std::min(segment + 1, LANE_COUNT - 2);
+      auto mask = position >= static_cast<float>(boundary);
+      u = select(mask, interpolate_segment(span.m_u, segment), u);
+      v = select(mask, interpolate_segment(span.m_v, segment), v);
+    }
+  }
+
+  /**
+   * Shades a horizontal run of up to LANE_COUNT pixels at once given their
+   * texture coordinates, writing the colors of the selected pixels.
+   * @param sampler The sampler providing the triangle's diffuse color.
+   * @param attributes The triangle's attributes at each pixel.
+   * @param u The u texture coordinate of each pixel.
+   * @param v The v texture coordinate of each pixel.
+   * @param mask The mask of pixels to shade.
+   * @param count The number of pixels in the run.
+   * @param colors The colors currently stored at the pixels.
+   */
+  inline void shade_colors(const ColorSampler& sampler,
+      const AttributeLanes& attributes, FloatLanes u_lanes,
+      FloatLanes v_lanes, MaskLanes mask, int count, Color* colors) {
+    auto bits = to_bits(mask);
+    auto u = std::array<float, LANE_COUNT>();
+    store(u_lanes, u.data());
+    auto v = std::array<float, LANE_COUNT>();
+    store(v_lanes, v.data());
+    auto texels = std::array<std::int32_t, LANE_COUNT>();
+    for(auto i = 0; i != count; ++i) {
+      if(bits & (1 << i)) {
+        texels[i] = static_cast<std::int32_t>(
+          sampler.sample(TextureCoordinate(u[i], v[i])).as_rgba());
+      }
+    }
+    auto texel = load(texels.data());
+    auto shade_channel = [&] (FloatLanes light, int shift) {
+      auto base = (texel >> shift) & 0xFF;
+      return (to_int(to_float((to_int(light) & 0xFF) * base) *
+        attributes.m_intensity / 255.f) & 0xFF) << shift;
+    };
+    auto color = shade_channel(attributes.m_red, 24) |
+      shade_channel(attributes.m_green, 16) |
+      shade_channel(attributes.m_blue, 8) | (texel & 0xFF);
+    auto stored_colors = reinterpret_cast<std::int32_t*>(colors);
+    store(select(mask, color, load(stored_colors, count)), stored_colors,
+      count);
+  }
+
+  /**
+   * Shades a horizontal run of up to LANE_COUNT pixels at once, writing the
+   * colors of the selected pixels.
+   * @param sampler The sampler providing the triangle's diffuse color.
+   * @param attributes The triangle's attributes at each pixel.
+   * @param mask The mask of pixels to shade.
+   * @param count The number of pixels in the run.
+   * @param colors The colors currently stored at the pixels.
+   */
+  inline void shade_colors(const ColorSampler& sampler,
+      const AttributeLanes& attributes, MaskLanes mask, int count,
+      Color* colors) {
+    auto depth = FloatLanes(1) / attributes.m_inverse_z;
+    shade_colors(sampler, attributes, attributes.m_u_over_z * depth,
+      attributes.m_v_over_z * depth, mask, count, colors);
+  }
+
+  /**
+   * Shades a horizontal run of up to LANE_COUNT pixels of a triangle at once,
+   * correcting texture coordinates for perspective as often as the
+   * triangle's setup specifies, and writing the colors of the selected
+   * pixels.
+   * @param sampler The sampler providing the triangle's diffuse color.
+   * @param setup The setup of the triangle.
+   * @param span The nodes of the row being shaded.
+   * @param attributes The triangle's attributes at each pixel.
+   * @param mask The mask of pixels to shade.
+   * @param count The number of pixels in the run.
+   * @param x The column of the run's left most pixel.
+   * @param y The row of the run.
+   * @param colors The colors currently stored at the pixels.
+   */
+  inline void shade_colors(const ColorSampler& sampler,
+      const TriangleSetup& setup, AffineSpan& span,
+      const AttributeLanes& attributes, MaskLanes mask, int count, int x,
+      int y, Color* colors) {
+    if(setup.m_affine_span <= 1) {
+      shade_colors(sampler, attributes, mask, count, colors);
+      return;
+    }
+    auto u = FloatLanes();
+    auto v = FloatLanes();
+    interpolate(setup, span, x, y, u, v);
+    shade_colors(sampler, attributes, u, v, mask, count, colors);
+  }
+
+  /**
+   * Depth tests a horizontal run of up to LANE_COUNT pixels at once, storing
+   * the depths of the pixels that are covered by a triangle and pass. The
+   * depth buffer stores the reciprocal of the depth, so nearer pixels have
+   * larger values and a cleared depth buffer is filled with 0.
+   * @param inverse_z The triangle's reciprocal depth at each pixel.
+   * @param coverage The mask of pixels covered by the triangle.
+   * @param count The number of pixels in the run.
+   * @param depths The reciprocal depths currently stored at the pixels.
+   * @return The mask of pixels that passed the depth test.
+   */
+  inline MaskLanes test_depth(
+      FloatLanes inverse_z, MaskLanes coverage, int count, float* depths) {
+    auto stored_depth = load(depths, count);
+    auto mask = coverage & (inverse_z >= stored_depth);
+    store(select(mask, inverse_z, stored_depth), depths, count);
+    return mask;
+  }
+
+  /**
+   * Shades a horizontal run of up to LANE_COUNT pixels at once, writing the
+   * pixels that are covered by a triangle and pass the depth test.
+   * @param sampler The sampler providing the triangle's diffuse color.
+   * @param attributes The triangle's attributes at each pixel.
+   * @param coverage The mask of pixels covered by the triangle.
+   * @param count The number of pixels in the run.
+   * @param depths The reciprocal depths currently stored at the pixels.
+   * @param colors The colors currently stored at the pixels.
+   */
+  inline void shade_pixels(const ColorSampler& sampler,
+      const AttributeLanes& attributes, MaskLanes coverage, int count,
+      float* depths, Color* colors) {
+    auto mask = test_depth(attributes.m_inverse_z, coverage, count, depths);
+    if(to_bits(mask) != 0) {
+      shade_colors(sampler, attributes, mask, count, colors);
+    }
+  }
+
+  /**
+   * Shades a horizontal run of up to LANE_COUNT pixels of a triangle at once,
+   * writing the pixels that are covered by the triangle and pass the depth
+   * test, and correcting texture coordinates for perspective as often as the
+   * triangle's setup specifies.
+   * @param sampler The sampler providing the triangle's diffuse color.
+   * @param setup The setup of the triangle.
+   * @param span The nodes of the row being shaded.
+   * @param attributes The triangle's attributes at each pixel.
+   * @param coverage The mask of pixels covered by the triangle.
+   * @param count The number of pixels in the run.
+   * @param x The column of the run's left most pixel.
+   * @param y The row of the run.
+   * @param depths The reciprocal depths currently stored at the pixels.
+   * @param colors The colors currently stored at the pixels.
+   */
+  inline void shade_pixels(const ColorSampler& sampler,
+      const TriangleSetup& setup, AffineSpan& span,
+      const AttributeLanes& attributes, MaskLanes coverage, int count, int x,
+      int y, float* depths, Color* colors) {
+    auto mask = test_depth(attributes.m_inverse_z, coverage, count, depths);
+    if(to_bits(mask) != 0) {
+      shade_colors(
+        sampler, setup, span, attributes, mask, count, x, y, colors);
+    }
+  }
+
+  /**
+   * Walks the pixels of a triangle that lie within a window of the screen in
+   * blocks, passing every run of up to LANE_COUNT pixels that may be covered
+   * to a shader. The window is traversed in blocks of BLOCK_SIZE pixels,
+   * blocks entirely outside of the triangle are skipped and blocks entirely
+   * inside of the triangle are passed on without per-pixel coverage tests.
+   * The triangle, and then each of its blocks, is also skipped when an
+   * occlusion test finds that it lies behind what has already been drawn.
+   * @param setup The setup of the triangle to traverse.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param width The width of the window.
+   * @param height The height of the window.
+   * @param is_occluded The callable invoked as is_occluded(min_x, min_y,
+   *        max_x, max_y) to test whether the triangle's pixels within a
+   *        rectangle of the screen can be skipped.
+   * @param shader The callable invoked as shader(attributes, coverage, count,
+   *        x, y) for a run of count pixels starting at screen pixel (x, y).
+   */
+  template<typename O, typename S>
+  void traverse_blocks(const TriangleSetup& setup, int left, int top,
+      int width, int height, O&& is_occluded, S&& shader) {
+    auto min_x = std::max(setup.m_min_x, left);
+    auto max_x = std::min(setup.m_max_x, left + width - 1);
+    auto min_y = std::max(setup.m_min_y, top);
+    auto max_y = std::min(setup.m_max_y, top + height - 1);
+    if(min_x > max_x || min_y > max_y ||
+        is_occluded(min_x, min_y, max_x, max_y)) {
+      return;
+    }
+    auto& e0 = setup.m_edges[0];
+    auto& e1 = setup.m_edges[1];
+    auto& e2 = setup.m_edges[2];
+    auto ramp = to_int(make_ramp());
+    auto step_x0 = e0.m_a * SUBPIXEL_SCALE;
+    auto step_x1 = e1.m_a * SUBPIXEL_SCALE;
+    auto step_x2 = e2.m_a * SUBPIXEL_SCALE;
+    auto step_y0 = e0.m_b * SUBPIXEL_SCALE;
+    auto step_y1 = e1.m_b * SUBPIXEL_SCALE;
+    auto step_y2 = e2.m_b * SUBPIXEL_SCALE;
+    auto step_w0 = IntLanes(step_x0) * ramp;
+    auto step_w1 = IntLanes(step_x1) * ramp;
+    auto step_w2 = IntLanes(step_x2) * ramp;
+    auto lane_step_w0 = IntLanes(step_x0 * LANE_COUNT);
+    auto lane_step_w1 = IntLanes(step_x1 * LANE_COUNT);
+    auto lane_step_w2 = IntLanes(step_x2 * LANE_COUNT);
+    auto lane_step = get_step(setup, LANE_COUNT, 0);
+    auto row_step = get_step(setup, 0, 1);
+    auto threshold0 = IntLanes(-setup.m_biases[0]);
+    auto threshold1 = IntLanes(-setup.m_biases[1]);
+    auto threshold2 = IntLanes(-setup.m_biases[2]);
+    auto classify = [] (const EdgeFunction& edge, std::int64_t w, int width,
+        int height, bool& is_outside, bool& is_inside) {
+      auto step_x = static_cast<std::int64_t>(edge.m_a) * SUBPIXEL_SCALE;
+      auto step_y = static_cast<std::int64_t>(edge.m_b) * SUBPIXEL_SCALE;
+      auto maximum = w + std::max<std::int64_t>(step_x, 0) * width +
+        std::max<std::int64_t>(step_y, 0) * height;
+      auto minimum = w + std::min<std::int64_t>(step_x, 0) * width +
+        std::min<std::int64_t>(step_y, 0) * height;
+      is_outside = is_outside || maximum < 0;
+      is_inside = is_inside && minimum >= 0;
+    };
+    for(auto block_y = min_y - min_y % BLOCK_SIZE; block_y <= max_y;
+        block_y += BLOCK_SIZE) {
+      auto start_y = std::max(block_y, min_y);
+      auto end_y = std::min(block_y + BLOCK_SIZE - 1, max_y);
+      for(auto block_x = min_x - min_x % BLOCK_SIZE; block_x <= max_x;
+          block_x += BLOCK_SIZE) {
+        auto start_x = std::max(block_x, min_x);
+        auto end_x = std::min(block_x + BLOCK_SIZE - 1, max_x);
+        auto origin = get_pixel_center(start_x, start_y);
+        auto origin_w0 = evaluate(e0, origin);
+        auto origin_w1 = evaluate(e1, origin);
+        auto origin_w2 = evaluate(e2, origin);
+        auto is_outside = false;
+        auto is_inside = true;
+        auto block_width = end_x - start_x;
+        auto block_height = end_y - start_y;
+        classify(e0, origin_w0 + setup.m_biases[0], block_width, block_height,
+          is_outside, is_inside);
+        classify(e1, origin_w1 + setup.m_biases[1], block_width, block_height,
+          is_outside, is_inside);
+        classify(e2, origin_w2 + setup.m_biases[2], block_width, block_height,
+          is_outside, is_inside);
+        if(is_outside || is_occluded(start_x, start_y, end_x, end_y)) {
+          continue;
+        }
+        // The edge functions are stepped across the block in 32 bits. The
+        // edges of a triangle spanning fewer than 2^17 pixels change by less
+        // than EDGE_LIMIT across a block, so values narrowed at the block's
+        // origin keep their exact sign throughout the block.
+        auto row_w0 = narrow_edge(origin_w0);
+        auto row_w1 = narrow_edge(origin_w1);
+        auto row_w2 = narrow_edge(origin_w2);
+        auto row_attributes = evaluate(setup, start_x, start_y);
+        for(auto y = start_y; y <= end_y; ++y) {
+          auto w0 = row_w0 + step_w0;
+          auto w1 = row_w1 + step_w1;
+          auto w2 = row_w2 + step_w2;
+          auto attributes = row_attributes;
+          for(auto x = start_x; x <= end_x; x += LANE_COUNT) {
+            auto count = std::min(LANE_COUNT, end_x - x + 1);
+            auto coverage = make_mask(count);
+            if(!is_inside) {
+              coverage = coverage & (w0 >= threshold0) & (w1 >= threshold1) &
+                (w2 >= threshold2);
+            }
+            if(to_bits(coverage) != 0) {
+              shader(attributes, coverage, count, x, y);
+            }
+            w0 += lane_step_w0;
+            w1 += lane_step_w1;
+            w2 += lane_step_w2;
+            advance(attributes, lane_step);
+          }
+          row_w0 += step_y0;
+          row_w1 += step_y1;
+          row_w2 += step_y2;
+          advance(row_attributes, row_step);
+        }
+      }
+    }
+  }
+
+  /**
+   * Walks the pixels of a triangle that lie within a window of the screen in
+   * blocks, without any occlusion test.
+   * @param setup The setup of the triangle to traverse.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param width The width of the window.
+   * @param height The height of the window.
+   * @param shader The callable invoked as shader(attributes, coverage, count,
+   *        x, y) for a run of count pixels starting at screen pixel (x, y).
+   */
+  template<typename S>
+  void traverse_blocks(const TriangleSetup& setup, int left, int top,
+      int width, int height, S&& shader) {
+    traverse_blocks(setup, left, top, width, height,
+      [] (int, int, int, int) { return false; }, shader);
+  }
+
+  /**
+   * Walks the pixels of a triangle that lie within a window of the screen one
+   * row at a time, passing every run of up to LANE_COUNT covered pixels to a
+   * shader. The exact span of pixels covered on each row is computed from the
+   * triangle's edge functions, so no per-pixel coverage tests are needed.
+   * The triangle is skipped when an occlusion test finds that it lies behind
+   * what has already been drawn, and each span is trimmed of the blocks of
+   * HierarchicalDepthBuffer::BLOCK_SIZE pixels at either of its ends that are
+   * found to be occluded.
+   * @param setup The setup of the triangle to traverse.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param width The width of the window.
+   * @param height The height of the window.
+   * @param is_occluded The callable invoked as is_occluded(min_x, min_y,
+   *        max_x, max_y) to test whether the triangle's pixels within a
+   *        rectangle of the screen can be skipped.
+   * @param shader The callable invoked as shader(attributes, coverage, count,
+   *        x, y) for a run of count pixels starting at screen pixel (x, y).
+   */
+  template<typename O, typename S>
+  void traverse_spans(const TriangleSetup& setup, int left, int top,
+      int width, int height, O&& is_occluded, S&& shader) {
+    auto min_x = std::max(setup.m_min_x, left);
+    auto max_x = std::min(setup.m_max_x, left + width - 1);
+    auto min_y = std::max(setup.m_min_y, top);
+    auto max_y = std::min(setup.m_max_y, top + height - 1);
+    if(min_x > max_x || min_y > max_y ||
+        is_occluded(min_x, min_y, max_x, max_y)) {
+      return;
+    }
+    const auto block_size = HierarchicalDepthBuffer::BLOCK_SIZE;
+    auto lane_step = get_step(setup, LANE_COUNT, 0);
+    auto floor_divide = [] (std::int64_t numerator, std::int64_t denominator) {
+      if(numerator >= 0) {
+        return numerator / denominator;
+      }
+      return -((-numerator + denominator - 1) / denominator);
+    };
+    for(auto y = min_y; y <= max_y; ++y) {
+      auto start_x = static_cast<std::int64_t>(min_x);
+      auto end_x = static_cast<std::int64_t>(max_x);
+      for(auto i = 0; i != 3; ++i) {
+        auto& edge = setup.m_edges[i];
+        auto step = static_cast<std::int64_t>(edge.m_a) * SUBPIXEL_SCALE;
+        auto w = evaluate(edge, get_pixel_center(0, y)) + setup.m_biases[i];
+        if(step > 0) {
+          start_x = std::max(start_x, -floor_divide(w, step));
+        } else if(step < 0) {
+          end_x = std::min(end_x, floor_divide(w, -step));
+        } else if(w < 0) {
+          end_x = start_x - 1;
+        }
+      }
+      auto span_start_x = start_x;
+      while(start_x <= end_x) {
+        auto block_end = std::min<std::int64_t>(end_x,
+          start_x + block_size - 1 - (start_x - left) % block_size);
+        if(!is_occluded(static_cast<int>(start_x), y,
+            static_cast<int>(block_end), y)) {
+          break;
+        }
+        start_x = block_end + 1;
+      }
+      while(end_x >= start_x) {
+        auto block_start = std::max<std::int64_t>(
+          start_x, end_x - (end_x - left) % block_size);
+        if(!is_occluded(static_cast<int>(block_start), y,
+            static_cast<int>(end_x), y)) {
+          break;
+        }
+        end_x = block_start - 1;
+      }
+      if(start_x > end_x) {
+        continue;
+      }
+
+      // Attributes are stepped from the start of the untrimmed span, so that
+      // every pass over the triangle interpolates the same values at a pixel
+      // however much of the span its occlusion test trims.
+      auto attributes = evaluate(setup, static_cast<int>(span_start_x), y);
+      auto x = static_cast<int>(span_start_x);
+      for(; x + LANE_COUNT <= start_x; x += LANE_COUNT) {
+        advance(attributes, lane_step);
+      }
+      for(; x <= end_x; x += LANE_COUNT) {
+        auto count = std::min(LANE_COUNT, static_cast<int>(end_x) - x + 1);
+        shader(attributes, make_mask(count), count, x, y);
+        advance(attributes, lane_step);
+      }
+    }
+  }
+
+  /**
+   * Walks the pixels of a triangle that lie within a window of the screen one
+   * row at a time, without any occlusion test.
+   * @param setup The setup of the triangle to traverse.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param width The width of the window.
+   * @param height The height of the window.
+   * @param shader The callable invoked as shader(attributes, coverage, count,
+   *        x, y) for a run of count pixels starting at screen pixel (x, y).
+   */
+  template<typename S>
+  void traverse_spans(const TriangleSetup& setup, int left, int top,
+      int width, int height, S&& shader) {
+    traverse_spans(setup, left, top, width, height,
+      [] (int, int, int, int) { return false; }, shader);
+  }
+
+  /**
+   * The screen area in square pixels at or above which triangles are
+   * traversed by traverse_spans rather than by traverse_blocks.
+   */
+  const auto SPAN_AREA_THRESHOLD = 64;
+
+  /**
+   * Walks the pixels of a triangle that lie within a window of the screen,
+   * passing every run of up to LANE_COUNT pixels that may be covered to a
+   * shader. Large triangles are traversed a span at a time and all others a
+   * block at a time.
+   * @param setup The setup of the triangle to traverse.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param width The width of the window.
+   * @param height The height of the window.
+   * @param is_occluded The callable invoked as is_occluded(min_x, min_y,
+   *        max_x, max_y) to test whether the triangle's pixels within a
+   *        rectangle of the screen can be skipped.
+   * @param shader The callable invoked as shader(attributes, coverage, count,
+   *        x, y) for a run of count pixels starting at screen pixel (x, y).
+   */
+  template<typename O, typename S>
+  void traverse(const TriangleSetup& setup, int left, int top, int width,
+      int height, O&& is_occluded, S&& shader) {
+    if(setup.m_area >= static_cast<std::int64_t>(2 * SPAN_AREA_THRESHOLD) *
+        SUBPIXEL_SCALE * SUBPIXEL_SCALE) {
+      traverse_spans(setup, left, top, width, height, is_occluded, shader);
+    } else {
+      traverse_blocks(setup, left, top, width, height, is_occluded, shader);
+    }
+  }
+
+  /**
+   * Walks the pixels of a triangle that lie within a window of the screen,
+   * without any occlusion test.
+   * @param setup The setup of the triangle to traverse.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param width The width of the window.
+   * @param height The height of the window.
+   * @param shader The callable invoked as shader(attributes, coverage, count,
+   *        x, y) for a run of count pixels starting at screen pixel (x, y).
+   */
+  template<typename S>
+  void traverse(const TriangleSetup& setup, int left, int top, int width,
+      int height, S&& shader) {
+    traverse(setup, left, top, width, height,
+      [] (int, int, int, int) { return false; }, shader);
+  }
+
+  /**
+   * Resolves the cleared tiles of a window's raster that a triangle's bounding
+   * box overlaps, so that runs of the raster's elements covered by the
+   * triangle can be addressed from a base pointer.
+   * @param setup The setup of the triangle.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param raster The raster storing the window.
+   */
+  template<typename T>
+  void resolve_bounds(
+      const TriangleSetup& setup, int left, int top, Raster<T>& raster) {
+    auto min_x = std::max(setup.m_min_x - left, 0);
+    auto max_x = std::min(setup.m_max_x - left, raster.get_width() - 1);
+    auto min_y = std::max(setup.m_min_y - top, 0);
+    auto max_y = std::min(setup.m_max_y - top, raster.get_height() - 1);
+    raster.resolve(min_x, min_y, max_x - min_x + 1, max_y - min_y + 1);
+  }
+
+  /**
+   * Rasterizes the part of a triangle that lies within a window of the screen
+   * a block at a time, shading every covered pixel that passes the depth
+   * test.
+   * @param setup The setup of the triangle to rasterize.
+   * @param material The material used to shade the triangle.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param frame_buffer The raster storing the window's colors.
+   * @param depth_buffer The raster storing the window's depths.
+   */
+  inline void rasterize_blocks(const TriangleSetup& setup,
+      const Material& material, int left, int top, FrameBuffer& frame_buffer,
+      DepthBuffer& depth_buffer) {
+    auto& sampler = material.get_diffuseness();
+    auto span = AffineSpan();
+    resolve_bounds(setup, left, top, frame_buffer);
+    resolve_bounds(setup, left, top, depth_buffer);
+    traverse_blocks(setup, left, top, frame_buffer.get_width(),
+      frame_buffer.get_height(), [&] (const AttributeLanes& attributes,
+          MaskLanes coverage, int count, int x, int y) {
+        shade_pixels(sampler, setup, span, attributes, coverage, count, x, y,
+          &depth_buffer(x - left, y - top), &frame_buffer(x - left, y - top));
+      });
+  }
+
+  /**
+   * Rasterizes the part of a triangle that lies within a window of the screen
+   * a span at a time, shading every covered pixel that passes the depth test.
+   * @param setup The setup of the triangle to rasterize.
+   * @param material The material used to shade the triangle.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param frame_buffer The raster storing the window's colors.
+   * @param depth_buffer The raster storing the window's depths.
+   */
+  inline void rasterize_spans(const TriangleSetup& setup,
+      const Material& material, int left, int top, FrameBuffer& frame_buffer,
+      DepthBuffer& depth_buffer) {
+    auto& sampler = material.get_diffuseness();
+    auto span = AffineSpan();
+    resolve_bounds(setup, left, top, frame_buffer);
+    resolve_bounds(setup, left, top, depth_buffer);
+    traverse_spans(setup, left, top, frame_buffer.get_width(),
+      frame_buffer.get_height(), [&] (const AttributeLanes& attributes,
+          MaskLanes coverage, int count, int x, int y) {
+        shade_pixels(sampler, setup, span, attributes, coverage, count, x, y,
+          &depth_buffer(x - left, y - top), &frame_buffer(x - left, y - top));
+      });
+  }
+
+  /**
+   * Rasterizes the part of a triangle that lies within a window of the screen,
+   * shading every covered pixel that passes the depth test.
+   * @param setup The setup of the triangle to rasterize.
+   * @param material The material used to shade the triangle.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param frame_buffer The raster storing the window's colors.
+   * @param depth_buffer The raster storing the window's depths.
+   */
+  inline void rasterize(const TriangleSetup& setup, const Material& material,
+      int left, int top, FrameBuffer& frame_buffer, DepthBuffer& depth_buffer) {
+    auto& sampler = material.get_diffuseness();
+    auto span = AffineSpan();
+    resolve_bounds(setup, left, top, frame_buffer);
+    resolve_bounds(setup, left, top, depth_buffer);
+    traverse(setup, left, top, frame_buffer.get_width(),
+      frame_buffer.get_height(), [&] (const AttributeLanes& attributes,
+          MaskLanes coverage, int count, int x, int y) {
+        shade_pixels(sampler, setup, span, attributes, coverage, count, x, y,
+          &depth_buffer(x - left, y - top), &frame_buffer(x - left, y - top));
+      });
+  }
+
+  /**
+   * Rasterizes the part of a triangle that lies within a window of the screen,
+   * shading every covered pixel that passes the depth test. Parts of the
+   * triangle lying behind the bounds of a HierarchicalDepthBuffer are skipped,
+   * and the bounds are raised afterwards.
+   * @param setup The setup of the triangle to rasterize.
+   * @param material The material used to shade the triangle.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param frame_buffer The raster storing the window's colors.
+   * @param depth_buffer The raster storing the window's depths.
+   * @param hierarchical_depth_buffer The bounds on the window's depths.
+   */
+  inline void rasterize(const TriangleSetup& setup, const Material& material,
+      int left, int top, FrameBuffer& frame_buffer, DepthBuffer& depth_buffer,
+      HierarchicalDepthBuffer& hierarchical_depth_buffer) {
+    auto& sampler = material.get_diffuseness();
+    auto span = AffineSpan();
+    resolve_bounds(setup, left, top, frame_buffer);
+    resolve_bounds(setup, left, top, depth_buffer);
+    traverse(setup, left, top, frame_buffer.get_width(),
+      frame_buffer.get_height(),
+      [&] (int min_x, int min_y, int max_x, int max_y) {
+        return is_occluded(setup, hierarchical_depth_buffer, left, top, min_x,
+          min_y, max_x, max_y);
+      }, [&] (const AttributeLanes& attributes, MaskLanes coverage, int count,
+          int x, int y) {
+        shade_pixels(sampler, setup, span, attributes, coverage, count, x, y,
+          &depth_buffer(x - left, y - top), &frame_buffer(x - left, y - top));
+      });
+    raise(hierarchical_depth_buffer, setup, left, top);
+  }
+
+  /**
+   * Rasterizes the part of a triangle that lies within a window of the screen
+   * without shading it, storing the depth of every covered pixel that passes
+   * the depth test. Only the triangle's depth is used, so no texture sampling
+   * or lighting is done.
+   * @param setup The setup of the triangle to rasterize.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param depth_buffer The raster storing the window's depths.
+   */
+  inline void rasterize_depth(const TriangleSetup& setup, int left, int top,
+      DepthBuffer& depth_buffer) {
+    resolve_bounds(setup, left, top, depth_buffer);
+    traverse(setup, left, top, depth_buffer.get_width(),
+      depth_buffer.get_height(), [&] (const AttributeLanes& attributes,
+          MaskLanes coverage, int count, int x, int y) {
+        test_depth(attributes.m_inverse_z, coverage, count,
+          &depth_buffer(x - left, y - top));
+      });
+  }
+
+  /**
+   * Rasterizes the part of a triangle that lies within a window of the screen
+   * without shading it, storing the depth of every covered pixel that passes
+   * the depth test. Parts of the triangle lying behind the bounds of a
+   * HierarchicalDepthBuffer are skipped, and the bounds are raised afterwards.
+   * @param setup The setup of the triangle to rasterize.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param depth_buffer The raster storing the window's depths.
+   * @param hierarchical_depth_buffer The bounds on the window's depths.
+   */
+  inline void rasterize_depth(const TriangleSetup& setup, int left, int top,
+      DepthBuffer& depth_buffer,
+      HierarchicalDepthBuffer& hierarchical_depth_buffer) {
+    resolve_bounds(setup, left, top, depth_buffer);
+    traverse(setup, left, top, depth_buffer.get_width(),
+      depth_buffer.get_height(),
+      [&] (int min_x, int min_y, int max_x, int max_y) {
+        return is_occluded(setup, hierarchical_depth_buffer, left, top, min_x,
+          min_y, max_x, max_y);
+      }, [&] (const AttributeLanes& attributes, MaskLanes coverage, int count,
+          int x, int y) {
+        test_depth(attributes.m_inverse_z, coverage, count,
+          &depth_buffer(x - left, y - top));
+      });
+    raise(hierarchical_depth_buffer, setup, left, top);
+  }
+
+  /**
+   * Rasterizes the part of a triangle that lies within a window of the screen,
+   * shading only the covered pixels whose depth equals the stored depth. Used
+   * after rasterize_depth has resolved the nearest depth of every pixel, so
+   * that only the visible pixels are shaded. Both passes interpolate depth
+   * identically, so a triangle's visible pixels compare exactly equal.
+   * @param setup The setup of the triangle to rasterize.
+   * @param material The material used to shade the triangle.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param frame_buffer The raster storing the window's colors.
+   * @param depth_buffer The raster storing the window's resolved depths.
+   */
+  inline void rasterize_visible(const TriangleSetup& setup,
+      const Material& material, int left, int top, FrameBuffer& frame_buffer,
+      const DepthBuffer& depth_buffer) {
+    auto& sampler = material.get_diffuseness();
+    auto span = AffineSpan();
+    auto depths = depth_buffer.data();
+    resolve_bounds(setup, left, top, frame_buffer);
+    traverse(setup, left, top, frame_buffer.get_width(),
+      frame_buffer.get_height(), [&] (const AttributeLanes& attributes,
+          MaskLanes coverage, int count, int x, int y) {
+        auto stored_depth = load(
+          depths + (y - top) * depth_buffer.get_width() + x - left, count);
+        auto mask = coverage & (attributes.m_inverse_z == stored_depth);
+        if(to_bits(mask) != 0) {
+          shade_colors(sampler, setup, span, attributes, mask, count, x, y,
+            &frame_buffer(x - left, y - top));
+        }
+      });
+  }
+
+  /**
+   * Rasterizes the part of a triangle that lies within a window of the screen,
+   * shading only the covered pixels whose depth equals the stored depth, and
+   * skipping the parts of the triangle lying behind the bounds of a
+   * HierarchicalDepthBuffer.
+   * @param setup The setup of the triangle to rasterize.
+   * @param material The material used to shade the triangle.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param frame_buffer The raster storing the window's colors.
+   * @param depth_buffer The raster storing the window's resolved depths.
+   * @param hierarchical_depth_buffer The bounds on the window's depths.
+   */
+  inline void rasterize_visible(const TriangleSetup& setup,
+      const Material& material, int left, int top, FrameBuffer& frame_buffer,
+      const DepthBuffer& depth_buffer,
+      const HierarchicalDepthBuffer& hierarchical_depth_buffer) {
+    auto& sampler = material.get_diffuseness();
+    auto span = AffineSpan();
+    auto depths = depth_buffer.data();
+    resolve_bounds(setup, left, top, frame_buffer);
+    traverse(setup, left, top, frame_buffer.get_width(),
+      frame_buffer.get_height(),
+      [&] (int min_x, int min_y, int max_x, int max_y) {
+        return is_occluded(setup, hierarchical_depth_buffer, left, top, min_x,
+          min_y, max_x, max_y);
+      }, [&] (const AttributeLanes& attributes, MaskLanes coverage, int count,
+          int x, int y) {
+        auto stored_depth = load(
+          depths + (y - top) * depth_buffer.get_width() + x - left, count);
+        auto mask = coverage & (attributes.m_inverse_z == stored_depth);
+        if(to_bits(mask) != 0) {
+          shade_colors(sampler, setup, span, attributes, mask, count, x, y,
+            &frame_buffer(x - left, y - top));
+        }
+      });
+  }
+
+  /**
+   * Marks the pixels of a run that were drawn to so that they can be shaded
+   * later.
+   * @param mask The mask of pixels drawn to.
+   * @param count The number of pixels in the run.
+   * @param coverage The marks stored at the pixels.
+   */
+  inline void mark(MaskLanes mask, int count, std::uint8_t* coverage) {
+    auto bits = to_bits(mask);
+    for(auto i = 0; i != count; ++i) {
+      coverage[i] |= static_cast<std::uint8_t>((bits >> i) & 1);
+    }
+  }
+
+  /**
+   * Shades the pixels of a window that a triangle has marked in a
+   * CoverageBuffer, evaluating the triangle's shading once per aligned block
+   * of pixels at the block's first marked pixel, which unlike the block's
+   * center always lies within the triangle, and writing the resulting color
+   * to every marked pixel of the block. Shading is evaluated for up to
+   * LANE_COUNT horizontally adjacent blocks at once, and the marks are
+   * cleared as the pixels are shaded.
+   * @param setup The setup of the triangle.
+   * @param sampler The sampler providing the triangle's diffuse color.
+   * @param rate The rate at which the triangle is shaded.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param coverage_buffer The marks of the pixels to shade.
+   * @param frame_buffer The raster storing the window's colors.
+   */
+  inline void shade_blocks(const TriangleSetup& setup,
+      const ColorSampler& sampler, ShadingRate rate, int left, int top,
+      CoverageBuffer& coverage_buffer, FrameBuffer& frame_buffer) {
+    auto min_x = std::max(setup.m_min_x, left);
+    auto max_x = std::min(setup.m_max_x, left + frame_buffer.get_width() - 1);
+    auto min_y = std::max(setup.m_min_y, top);
+    auto max_y =
+      std::min(setup.m_max_y, top + frame_buffer.get_height() - 1);
+    if(min_x > max_x || min_y > max_y) {
+      return;
+    }
+    auto size = get_size(rate);
+    auto colors = std::array<Color, LANE_COUNT>();
+    auto positions_x = std::array<float, LANE_COUNT>();
+    auto positions_y = std::array<float, LANE_COUNT>();
+    for(auto block_y = min_y / size; block_y <= max_y / size; ++block_y) {
+      auto start_y = std::max(block_y * size, min_y);
+      auto end_y = std::min(block_y * size + size - 1, max_y);
+      for(auto first_block_x = min_x / size; first_block_x <= max_x / size;
+          first_block_x += LANE_COUNT) {
+        auto count = std::min(LANE_COUNT, max_x / size - first_block_x + 1);
+        auto bits = 0;
+        for(auto i = 0; i != count; ++i) {
+          auto start_x = std::max((first_block_x + i) * size, min_x);
+          auto end_x = std::min((first_block_x + i) * size + size - 1, max_x);
+          for(auto j = start_y; j <= end_y && !(bits & (1 << i)); ++j) {
+            auto marks = &coverage_buffer(start_x - left, j - top);
+            auto first_mark = std::find_if(marks,
+              marks + (end_x - start_x + 1),
+              [] (std::uint8_t mark) { return mark != 0; });
+            if(first_mark != marks + (end_x - start_x + 1)) {
+              bits |= 1 << i;
+              positions_x[i] =
+                static_cast<float>(start_x + (first_mark - marks));
+              positions_y[i] = static_cast<float>(j);
+            }
+          }
+        }
+        if(bits == 0) {
+          continue;
+        }
+        auto x = load(positions_x.data());
+        auto y = load(positions_y.data());
+        auto evaluate_lanes = [&] (const AttributePlane& plane) {
+          return FloatLanes(plane.m_value) + plane.m_dx * x + plane.m_dy * y;
+        };
+        auto attributes = AttributeLanes(evaluate_lanes(setup.m_inverse_z),
+          evaluate_lanes(setup.m_u_over_z), evaluate_lanes(setup.m_v_over_z),
+          evaluate_lanes(setup.m_red), evaluate_lanes(setup.m_green),
+          evaluate_lanes(setup.m_blue), evaluate_lanes(setup.m_intensity));
+        shade_colors(sampler, attributes, to_mask(bits), count, colors.data());
+        for(auto i = 0; i != count; ++i) {
+          if(!(bits & (1 << i))) {
+            continue;
+          }
+          auto start_x = std::max((first_block_x + i) * size, min_x);
+          auto end_x = std::min((first_block_x + i) * size + size - 1, max_x);
+          for(auto j = start_y; j <= end_y; ++j) {
+            for(auto k = start_x; k <= end_x; ++k) {
+              auto& mark = coverage_buffer(k - left, j - top);
+              if(mark != 0) {
+                frame_buffer(k - left, j - top) = colors[i];
+                mark = 0;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  /**
+   * Rasterizes the part of a triangle that lies within a window of the screen
+   * at a coarse shading rate. Coverage and depth are resolved per pixel, and
+   * the pixels that pass the depth test are then shaded once per block.
+   * Parts of the triangle lying behind the bounds of a
+   * HierarchicalDepthBuffer are skipped, and the bounds are raised
+   * afterwards.
+   * @param setup The setup of the triangle to rasterize.
+   * @param material The material used to shade the triangle.
+   * @param rate The rate at which the triangle is shaded.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param frame_buffer The raster storing the window's colors.
+   * @param depth_buffer The raster storing the window's depths.
+   * @param hierarchical_depth_buffer The bounds on the window's depths.
+   * @param coverage_buffer A raster the size of the window with no pixels
+   *        marked, which is left with no pixels marked.
+   */
+  inline void rasterize(const TriangleSetup& setup, const Material& material,
+      ShadingRate rate, int left, int top, FrameBuffer& frame_buffer,
+      DepthBuffer& depth_buffer,
+      HierarchicalDepthBuffer& hierarchical_depth_buffer,
+      CoverageBuffer& coverage_buffer) {
+    resolve_bounds(setup, left, top, frame_buffer);
+    resolve_bounds(setup, left, top, depth_buffer);
+    resolve_bounds(setup, left, top, coverage_buffer);
+    traverse(setup, left, top, frame_buffer.get_width(),
+      frame_buffer.get_height(),
+      [&] (int min_x, int min_y, int max_x, int max_y) {
+        return is_occluded(setup, hierarchical_depth_buffer, left, top, min_x,
+          min_y, max_x, max_y);
+      }, [&] (const AttributeLanes& attributes, MaskLanes coverage, int count,
+          int x, int y) {
+        mark(test_depth(attributes.m_inverse_z, coverage, count,
+          &depth_buffer(x - left, y - top)), count,
+          &coverage_buffer(x - left, y - top));
+      });
+    shade_blocks(setup, material.get_diffuseness(), rate, left, top,
+      coverage_buffer, frame_buffer);
+    raise(hierarchical_depth_buffer, setup, left, top);
+  }
+
+  /**
+   * Rasterizes the part of a triangle that lies within a window of the screen
+   * at a coarse shading rate, shading only the covered pixels whose depth
+   * equals the stored depth, once per block.
+   * @param setup The setup of the triangle to rasterize.
+   * @param material The material used to shade the triangle.
+   * @param rate The rate at which the triangle is shaded.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param frame_buffer The raster storing the window's colors.
+   * @param depth_buffer The raster storing the window's resolved depths.
+   * @param hierarchical_depth_buffer The bounds on the window's depths.
+   * @param coverage_buffer A raster the size of the window with no pixels
+   *        marked, which is left with no pixels marked.
+   */
+  inline void rasterize_visible(const TriangleSetup& setup,
+      const Material& material, ShadingRate rate, int left, int top,
+      FrameBuffer& frame_buffer, const DepthBuffer& depth_buffer,
+      const HierarchicalDepthBuffer& hierarchical_depth_buffer,
+      CoverageBuffer& coverage_buffer) {
+    auto depths = depth_buffer.data();
+    resolve_bounds(setup, left, top, frame_buffer);
+    resolve_bounds(setup, left, top, coverage_buffer);
+    traverse(setup, left, top, frame_buffer.get_width(),
+      frame_buffer.get_height(),
+      [&] (int min_x, int min_y, int max_x, int max_y) {
+        return is_occluded(setup, hierarchical_depth_buffer, left, top, min_x,
+          min_y, max_x, max_y);
+      }, [&] (const AttributeLanes& attributes, MaskLanes coverage, int count,
+          int x, int y) {
+        auto stored_depth = load(
+          depths + (y - top) * depth_buffer.get_width() + x - left, count);
+        mark(coverage & (attributes.m_inverse_z == stored_depth), count,
+          &coverage_buffer(x - left, y - top));
+      });
+    shade_blocks(setup, material.get_diffuseness(), rate, left, top,
+      coverage_buffer, frame_buffer);
+  }
+
+  /** The visibility of a pixel that isn't covered by any triangle. */
+  const auto NO_VISIBILITY = ~std::uint64_t(0);
+
+  /**
+   * Packs the identity of a triangle into the value stored by a
+   * VisibilityBuffer.
+   * @param draw The index of the draw the triangle belongs to.
+   * @param triangle The index of the triangle within its draw.
+   * @return The packed visibility.
+   */
+  inline std::uint64_t make_visibility(int draw, int triangle) {
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(draw)) <<
+      32) | static_cast<std::uint32_t>(triangle);
+  }
+
+  /** Returns the index of the draw a packed visibility refers to. */
+  inline int get_draw(std::uint64_t visibility) {
+    return static_cast<int>(visibility >> 32);
+  }
+
+  /**
+   * Returns the index within its draw of the triangle a packed visibility
+   * refers to.
+   */
+  inline int get_triangle(std::uint64_t visibility) {
+    return static_cast<int>(visibility & 0xFFFFFFFF);
+  }
+
+  /**
+   * Rasterizes the part of a triangle that lies within a window of the screen
+   * without shading it, storing the triangle's identity and depth at every
+   * covered pixel that passes the depth test.
+   * @param setup The setup of the triangle to rasterize.
+   * @param visibility The packed identity of the triangle.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param visibility_buffer The raster storing the window's visibilities.
+   * @param depth_buffer The raster storing the window's depths.
+   */
+  inline void rasterize_visibility(const TriangleSetup& setup,
+      std::uint64_t visibility, int left, int top,
+      VisibilityBuffer& visibility_buffer, DepthBuffer& depth_buffer) {
+    resolve_bounds(setup, left, top, visibility_buffer);
+    resolve_bounds(setup, left, top, depth_buffer);
+    traverse(setup, left, top, visibility_buffer.get_width(),
+      visibility_buffer.get_height(), [&] (const AttributeLanes& attributes,
+          MaskLanes coverage, int count, int x, int y) {
+        auto bits = to_bits(test_depth(attributes.m_inverse_z, coverage,
+          count, &depth_buffer(x - left, y - top)));
+        auto visibilities = &visibility_buffer(x - left, y - top);
+        for(auto i = 0; i != count; ++i) {
+          if(bits & (1 << i)) {
+            visibilities[i] = visibility;
+          }
+        }
+      });
+  }
+
+  /**
+   * Rasterizes the part of a triangle that lies within a window of the screen
+   * without shading it, storing the triangle's identity and depth at every
+   * covered pixel that passes the depth test. Parts of the triangle lying
+   * behind the bounds of a HierarchicalDepthBuffer are skipped, and the bounds
+   * are raised afterwards.
+   * @param setup The setup of the triangle to rasterize.
+   * @param visibility The packed identity of the triangle.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param visibility_buffer The raster storing the window's visibilities.
+   * @param depth_buffer The raster storing the window's depths.
+   * @param hierarchical_depth_buffer The bounds on the window's depths.
+   */
+  inline void rasterize_visibility(const TriangleSetup& setup,
+      std::uint64_t visibility, int left, int top,
+      VisibilityBuffer& visibility_buffer, DepthBuffer& depth_buffer,
+      HierarchicalDepthBuffer& hierarchical_depth_buffer) {
+    resolve_bounds(setup, left, top, visibility_buffer);
+    resolve_bounds(setup, left, top, depth_buffer);
+    traverse(setup, left, top, visibility_buffer.get_width(),
+      visibility_buffer.get_height(),
+      [&] (int min_x, int min_y, int max_x, int max_y) {
+        return is_occluded(setup, hierarchical_depth_buffer, left, top, min_x,
+          min_y, max_x, max_y);
+      }, [&] (const AttributeLanes& attributes, MaskLanes coverage, int count,
+          int x, int y) {
+        auto bits = to_bits(test_depth(attributes.m_inverse_z, coverage,
+          count, &depth_buffer(x - left, y - top)));
+        auto visibilities = &visibility_buffer(x - left, y - top);
+        for(auto i = 0; i != count; ++i) {
+          if(bits & (1 << i)) {
+            visibilities[i] = visibility;
+          }
+        }
+      });
+    raise(hierarchical_depth_buffer, setup, left, top);
+  }
+
+  /**
+   * Shades a horizontal run of up to LANE_COUNT pixels that are all covered by
+   * the same triangle, without depth testing them.
+   * @param setup The setup of the triangle covering the pixels.
+   * @param material The material used to shade the triangle.
+   * @param x The screen column of the run's left most pixel.
+   * @param y The screen row of the run.
+   * @param count The number of pixels in the run.
+   * @param colors The colors stored at the pixels.
+   */
+  inline void shade_run(const TriangleSetup& setup, const Material& material,
+      int x, int y, int count, Color* colors) {
+    shade_colors(material.get_diffuseness(), evaluate(setup, x, y),
+      make_mask(count), count, colors);
+  }
+
+  /**
+   * Rasterizes the part of a triangle that lies within a window of the screen
+   * with multisampling. Each pixel stores SAMPLE_COUNT color and depth
+   * samples, where sample s of the window's pixel (x, y) is stored at
+   * (x, y * SAMPLE_COUNT + s) of the sample rasters. Coverage and depth are
+   * tested at every sample, but the triangle is shaded only once per pixel,
+   * at the pixel's center, and the color is written to every sample that
+   * passed.
+   * @param setup The setup of the triangle to rasterize, as computed by
+   *        make_multisample_triangle_setup.
+   * @param material The material used to shade the triangle.
+   * @param left The screen column of the window's left most pixel.
+   * @param top The screen row of the window's top most pixel.
+   * @param color_samples The raster storing the window's color samples.
+   * @param depth_samples The raster storing the window's depth samples.
+   */
+  inline void rasterize_multisample(const TriangleSetup& setup,
+      const Material& material, int left, int top, FrameBuffer& color_samples,
+      DepthBuffer& depth_samples) {
+    auto min_x = std::max(setup.m_min_x, left);
+    auto max_x = std::min(setup.m_max_x, left + color_samples.get_width() - 1);
+    auto min_y = std::max(setup.m_min_y, top);
+    auto max_y = std::min(
+      setup.m_max_y, top + color_samples.get_height() / SAMPLE_COUNT - 1);
+    color_samples.resolve(min_x - left, (min_y - top) * SAMPLE_COUNT,
+      max_x - min_x + 1, (max_y - min_y + 1) * SAMPLE_COUNT);
+    depth_samples.resolve(min_x - left, (min_y - top) * SAMPLE_COUNT,
+      max_x - min_x + 1, (max_y - min_y + 1) * SAMPLE_COUNT);
+    auto& sampler = material.get_diffuseness();
+    auto ramp = to_int(make_ramp());
+    auto step_w = std::array<IntLanes, 3>();
+    auto thresholds = std::array<IntLanes, 3>();
+    for(auto i = 0; i != 3; ++i) {
+      step_w[i] = IntLanes(setup.m_edges[i].m_a * SUBPIXEL_SCALE) * ramp;
+      thresholds[i] = IntLanes(-setup.m_biases[i]);
+    }
+    auto depth_offsets = std::array<FloatLanes, SAMPLE_COUNT>();
+    for(auto i = 0; i != SAMPLE_COUNT; ++i) {
+      auto& offset = SAMPLE_OFFSETS[i];
+      depth_offsets[i] = FloatLanes((setup.m_inverse_z.m_dx *
+        static_cast<float>(offset.m_x - SUBPIXEL_SCALE / 2) +
+        setup.m_inverse_z.m_dy *
+          static_cast<float>(offset.m_y - SUBPIXEL_SCALE / 2)) /
+        SUBPIXEL_SCALE);
+    }
+    auto lane_step = get_step(setup, LANE_COUNT, 0);
+    for(auto y = min_y; y <= max_y; ++y) {
+      auto attributes = evaluate(setup, min_x, y);
+      for(auto x = min_x; x <= max_x; x += LANE_COUNT) {
+        auto count = std::min(LANE_COUNT, max_x - x + 1);
+        auto masks = std::array<MaskLanes, SAMPLE_COUNT>();
+        auto shaded = make_mask(0);
+        for(auto i = 0; i != SAMPLE_COUNT; ++i) {
+          auto position = SubpixelCoordinate(x * SUBPIXEL_SCALE +
+            SAMPLE_OFFSETS[i].m_x, y * SUBPIXEL_SCALE + SAMPLE_OFFSETS[i].m_y);
+          auto coverage = make_mask(count);
+          for(auto j = 0; j != 3; ++j) {
+            auto w = IntLanes(narrow_edge(
+              evaluate(setup.m_edges[j], position))) + step_w[j];
+            coverage = coverage & (w >= thresholds[j]);
+          }
+          masks[i] = test_depth(attributes.m_inverse_z + depth_offsets[i],
+            coverage, count,
+            &depth_samples(x - left, (y - top) * SAMPLE_COUNT + i));
+          shaded = shaded | masks[i];
+        }
+        if(to_bits(shaded) != 0) {
+          auto colors = std::array<Color, LANE_COUNT>();
+          shade_colors(sampler, attributes, shaded, count, colors.data());
+          auto color =
+            load(reinterpret_cast<const std::int32_t*>(colors.data()), count);
+          for(auto i = 0; i != SAMPLE_COUNT; ++i) {
+            if(to_bits(masks[i]) != 0) {
+              auto stored_colors = reinterpret_cast<std::int32_t*>(
+                &color_samples(x - left, (y - top) * SAMPLE_COUNT + i));
+              store(select(masks[i], color, load(stored_colors, count)),
+                stored_colors, count);
+            }
+          }
+        }
+        advance(attributes, lane_step);
+      }
+    }
+  }
+
+  /**
+   * Resolves a row of multisampled pixels into their colors by averaging
+   * each pixel's color samples.
+   * @param color_samples The raster storing the color samples, laid out as
+   *        in rasterize_multisample.
+   * @param y The row to resolve.
+   * @param count The number of pixels to resolve, starting from column 0.
+   * @param colors The colors to write the resolved pixels to.
+   */
+  inline void resolve(
+      const FrameBuffer& color_samples, int y, int count, Color* colors) {
+    auto width = color_samples.get_width();
+    auto samples = reinterpret_cast<const std::int32_t*>(
+      color_samples.data() + y * SAMPLE_COUNT * width);
+    auto destination = reinterpret_cast<std::int32_t*>(colors);
+    for(auto x = 0; x < count; x += LANE_COUNT) {
+      auto run = std::min(LANE_COUNT, count - x);
+      auto sums = std::array{IntLanes(0), IntLanes(0), IntLanes(0),
+        IntLanes(0)};
+      for(auto i = 0; i != SAMPLE_COUNT; ++i) {
+        auto sample = load(samples + i * width + x, run);
+        for(auto j = 0; j != 4; ++j) {
+          sums[j] = sums[j] + ((sample >> (8 * j)) & 0xFF);
+        }
+      }
+      auto color = IntLanes(0);
+      for(auto j = 0; j != 4; ++j) {
+        color = color | ((to_int((to_float(sums[j]) + SAMPLE_COUNT / 2.f) *
+          (1.f / SAMPLE_COUNT)) & 0xFF) << (8 * j));
+      }
+      store(color, destination + x, run);
+    }
+  }
+
+  /**
+   * Resolves a row of multisampled pixels into their depths by keeping the
+   * farthest of each pixel's depth samples, so that anything drawn into the
+   * resolved pixels later is tested against every surface covering them.
+   * @param depth_samples The raster storing the depth samples, laid out as in
+   *        rasterize_multisample.
+   * @param y The row to resolve.
+   * @param count The number of pixels to resolve, starting from column 0.
+   * @param depths The reciprocal depths to write the resolved pixels to.
+   */
+  inline void resolve(
+      const DepthBuffer& depth_samples, int y, int count, float* depths) {
+    auto width = depth_samples.get_width();
+    auto samples = depth_samples.data() + y * SAMPLE_COUNT * width;
+    for(auto x = 0; x < count; x += LANE_COUNT) {
+      auto run = std::min(LANE_COUNT, count - x);
+      auto depth = load(samples + x, run);
+      for(auto i = 1; i != SAMPLE_COUNT; ++i) {
+        depth = min(depth, load(samples + i * width + x, run));
+      }
+      store(depth, depths + x, run);
+    }
+  }
+
+  /**
+   * Rasterizes a triangle in camera space with multisampling.
+   * @param a The first vertex of the triangle.
+   * @param b The second vertex of the triangle.
+   * @param c The third vertex of the triangle.
+   * @param material The material used to shade the triangle.
+   * @param camera The camera used to project the triangle onto the screen.
+   * @param color_samples The raster storing the color samples, laid out as in
+   *        rasterize_multisample.
+   * @param depth_samples The raster storing the depth samples, laid out as in
+   *        rasterize_multisample.
+   */
+  inline void rasterize_multisample(const ShadedVertex& a,
+      const ShadedVertex& b, const ShadedVertex& c, const Material& material,
+      const Camera& camera, FrameBuffer& color_samples,
+      DepthBuffer& depth_samples) {
+    if(auto setup = make_multisample_triangle_setup(a, b, c, camera,
+        color_samples.get_width(),
+        color_samples.get_height() / SAMPLE_COUNT)) {
+      rasterize_multisample(
+        *setup, material, 0, 0, color_samples, depth_samples);
+    }
+  }
+
+  /**
+   * Rasterizes a triangle that has already been set up, shading every covered
+   * pixel that passes the depth test.
+   * @param setup The setup of the triangle to rasterize.
+   * @param material The material used to shade the triangle.
+   * @param frame_buffer The raster to write colors to.
+   * @param depth_buffer The raster used to perform depth testing.
+   */
+  inline void rasterize(const TriangleSetup& setup, const Material& material,
+      FrameBuffer& frame_buffer, DepthBuffer& depth_buffer) {
+    rasterize(setup, material, 0, 0, frame_buffer, depth_buffer);
+  }
+
+  /**
+   * Rasterizes a triangle in camera space, shading every covered pixel that
+   * passes the depth test.
+   * @param a The first vertex of the triangle.
+   * @param b The second vertex of the triangle.
+   * @param c The third vertex of the triangle.
+   * @param material The material used to shade the triangle.
+   * @param camera The camera used to project the triangle onto the screen.
+   * @param frame_buffer The raster to write colors to.
+   * @param depth_buffer The raster used to perform depth testing.
+   */
+  inline void rasterize(const ShadedVertex& a, const ShadedVertex& b,
+      const ShadedVertex& c, const Material& material, const Camera& camera,
+      FrameBuffer& frame_buffer, DepthBuffer& depth_buffer) {
+    if(auto setup = make_triangle_setup(a, b, c, camera,
+        frame_buffer.get_width(), frame_buffer.get_height())) {
+      rasterize(*setup, material, frame_buffer, depth_buffer);
+    }
+  }
+}
+
+#endif
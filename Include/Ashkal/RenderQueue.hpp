@@ -0,0 +1,156 @@
+#ifndef ASHKAL_RENDER_QUEUE_HPP
+#define ASHKAL_RENDER_QUEUE_HPP
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "Ashkal/BoundingBox.hpp"
+#include "Ashkal/Camera.hpp"
+#include "Ashkal/Fragment.hpp"
+#include "Ashkal/Material.hpp"
+#include "Ashkal/Matrix.hpp"
+#include "Ashkal/Model.hpp"
+
+namespace Ashkal {
+
+  /** Stores everything needed to draw one Fragment of a Model. */
+  struct DrawItem {
+
+    /** The model the fragment belongs to. */
+    const Model* m_model;
+
+    /** The fragment to draw. */
+    const Fragment* m_fragment;
+
+    /** The transformation from the fragment's model space to world space. */
+    Matrix m_transformation;
+
+    /**
+     * The distance from the camera to the nearest point of the fragment's
+     * bounding box.
+     */
+    float m_depth;
+
+    /**
+     * Whether the fragment's bounding box extends outside of the frustum, in
+     * which case its triangles need to be clipped.
+     */
+    bool m_is_clipped;
+
+    /** The key that draw items are sorted by. */
+    std::uint64_t m_key;
+  };
+
+  /** The number of low bits of a sort key that identify its material. */
+  const auto MATERIAL_KEY_BITS = 32;
+
+  /**
+   * Makes the key ordering draw items front to back, and then by material
+   * among draw items at similar depths. Depths are compared by their sign,
+   * exponent and leading mantissa bits, so that depths within about one
+   * percent of each other compare equal and are grouped by material.
+   * @param depth The distance from the camera to the draw item.
+   * @param material The index identifying the draw item's material.
+   * @return The draw item's sort key.
+   */
+  inline std::uint64_t make_sort_key(float depth, int material) {
+    auto depth_bits = std::bit_cast<std::uint32_t>(std::max(depth, 0.f));
+    return static_cast<std::uint64_t>(depth_bits >> 16) << MATERIAL_KEY_BITS |
+      static_cast<std::uint32_t>(material);
+  }
+
+  /**
+   * Returns the distance along the view direction from a camera to the
+   * nearest point of a bounding box, or 0 if the box extends behind the
+   * camera.
+   * @param box The bounding box in world space.
+   * @param camera The camera to measure the distance from.
+   */
+  inline float get_depth(const BoundingBox& box, const Camera& camera) {
+    auto& minimum = box.get_minimum();
+    auto& maximum = box.get_maximum();
+    auto depth = -world_to_view(minimum, camera).m_z;
+    for(auto i = 1; i != 8; ++i) {
+      auto corner = Point(i & 1 ? maximum.m_x : minimum.m_x,
+        i & 2 ? maximum.m_y : minimum.m_y, i & 4 ? maximum.m_z : minimum.m_z);
+      depth = std::min(depth, -world_to_view(corner, camera).m_z);
+    }
+    return std::max(depth, 0.f);
+  }
+
+  /**
+   * Collects the fragments to draw in a frame so that they can be drawn in
+   * the order of their sort keys rather than in the order they are found.
+   */
+  class RenderQueue {
+    public:
+
+      /** Constructs an empty RenderQueue. */
+      RenderQueue() = default;
+
+      /** Returns the number of draw items queued. */
+      int get_size() const;
+
+      /** Returns the queued draw item at a given index. */
+      const DrawItem& get(int index) const;
+
+      /**
+       * Queues a fragment to be drawn, keyed by its depth and material.
+       * @param model The model the fragment belongs to.
+       * @param fragment The fragment to draw.
+       * @param transformation The transformation from the fragment's model
+       *        space to world space.
+       * @param depth The distance from the camera to the fragment.
+       * @param is_clipped Whether the fragment's triangles need clipping.
+       */
+      void add(const Model& model, const Fragment& fragment,
+        const Matrix& transformation, float depth, bool is_clipped);
+
+      /**
+       * Sorts the queued draw items by their keys, keeping the order in which
+       * items with equal keys were queued.
+       */
+      void sort();
+
+      /** Removes all draw items. */
+      void clear();
+
+    private:
+      std::vector<DrawItem> m_items;
+      std::unordered_map<const Material*, int> m_materials;
+
+      RenderQueue(const RenderQueue&) = delete;
+      RenderQueue& operator =(const RenderQueue&) = delete;
+  };
+
+  inline int RenderQueue::get_size() const {
+    return static_cast<int>(m_items.size());
+  }
+
+  inline const DrawItem& RenderQueue::get(int index) const {
+    return m_items[index];
+  }
+
+  inline void RenderQueue::add(const Model& model, const Fragment& fragment,
+      const Matrix& transformation, float depth, bool is_clipped) {
+    auto material = m_materials.try_emplace(&fragment.get_material(),
+      static_cast<int>(m_materials.size())).first->second;
+    m_items.push_back(DrawItem(&model, &fragment, transformation, depth,
+      is_clipped, make_sort_key(depth, material)));
+  }
+
+  inline void RenderQueue::sort() {
+    std::stable_sort(m_items.begin(), m_items.end(),
+      [] (const DrawItem& left, const DrawItem& right) {
+        return left.m_key < right.m_key;
+      });
+  }
+
+  inline void RenderQueue::clear() {
+    m_items.clear();
+    m_materials.clear();
+  }
+}
+
+#endif
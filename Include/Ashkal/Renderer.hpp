@@ -26,16 +26,36 @@ namespace Ashkal {
     float m_y;
   };
 
+  /** The number of fractional bits used by a SubpixelCoordinate. */
+  const auto SUBPIXEL_BITS = 4;
+
+  /** The number of subpixel steps within a single pixel. */
+  const auto SUBPIXEL_SCALE = 1 << SUBPIXEL_BITS;
+
   /**
-   * Projects a 3D point in camera space onto a 2D screen.
+   * Stores screen coordinates in fixed point, with SUBPIXEL_BITS fractional
+   * bits, so that vertices are not snapped to whole pixels and edge functions
+   * can be evaluated exactly.
+   */
+  struct SubpixelCoordinate {
+
+    /** The x coordinate in subpixels. */
+    int m_x;
+
+    /** The y coordinate in subpixels. */
+    int m_y;
+  };
+
+  /**
+   * Projects a 3D point in camera space onto a 2D screen without rounding.
    * @param point  The 3D point in camera space to project.
    * @param camera The camera in whose space is being projected onto a 2D
    *        screen.
    * @param width The width of the viewport in pixels.
    * @param height The height of the viewport in pixels.
-   * @return A ScreenCoordinate containing the projected pixel coordinates.
+   * @return A FloatScreenCoordinate containing the projected coordinates.
    */
-  inline ScreenCoordinate project_to_screen(
+  inline FloatScreenCoordinate project_to_float_screen(
       const Point& point, const Camera& camera, int width, int height) {
     const auto THRESHOLD = 1e-5f;
     auto near_z = -point.m_z;
@@ -49,7 +69,63 @@ namespace Ashkal {
     auto normalized_y = clip_y * perspective_divide;
     auto fx = (normalized_x + 1) * 0.5f * (width - 1);
     auto fy = (1 - (normalized_y + 1) * 0.5f) * (height - 1);
-    return ScreenCoordinate(int(fx), int(fy));
+    return FloatScreenCoordinate(fx, fy);
+  }
+
+  /**
+   * Projects a 3D point in camera space onto a 2D screen.
+   * @param point  The 3D point in camera space to project.
+   * @param camera The camera in whose space is being projected onto a 2D
+   *        screen.
+   * @param width The width of the viewport in pixels.
+   * @param height The height of the viewport in pixels.
+   * @return A ScreenCoordinate containing the projected pixel coordinates.
+   */
+  inline ScreenCoordinate project_to_screen(
+      const Point& point, const Camera& camera, int width, int height) {
+    auto screen = project_to_float_screen(point, camera, width, height);
+    return ScreenCoordinate(int(screen.m_x), int(screen.m_y));
+  }
+
+  /**
+   * Projects a 3D point in camera space onto a 2D screen, rounding to the
+   * nearest subpixel.
+   * @param point  The 3D point in camera space to project.
+   * @param camera The camera in whose space is being projected onto a 2D
+   *        screen.
+   * @param width The width of the viewport in pixels.
+   * @param height The height of the viewport in pixels.
+   * @return A SubpixelCoordinate containing the projected coordinates.
+   */
+  inline SubpixelCoordinate project_to_subpixel(
+      const Point& point, const Camera& camera, int width, int height) {
+    auto screen = project_to_float_screen(point, camera, width, height);
+    return SubpixelCoordinate(
+      static_cast<int>(std::lround(screen.m_x * SUBPIXEL_SCALE)),
+      static_cast<int>(std::lround(screen.m_y * SUBPIXEL_SCALE)));
+  }
+
+  /**
+   * Tests whether a point in camera space projects within the guard band
+   * along the axis of one of the frustum's left, right, bottom or top planes.
+   * Triangles whose vertices all lie within the guard band can be rasterized
+   * without being clipped against that plane.
+   * @param point The point in camera space, in front of the near plane.
+   * @param camera The camera in whose space the point is given.
+   * @param plane The side plane whose axis is tested.
+   * @param guard_band The extent of the guard band as a multiple of the
+   *        viewport's extent, where 1 is the viewport itself.
+   * @return True iff the point projects within the guard band.
+   */
+  inline bool is_in_guard_band(const Point& point, const Camera& camera,
+      Frustum::ClippingPlane plane, float guard_band) {
+    auto limit = -guard_band * point.m_z;
+    if(plane == Frustum::ClippingPlane::LEFT ||
+        plane == Frustum::ClippingPlane::RIGHT) {
+      return std::abs(camera.get_horizontal_focal_length() * point.m_x) <=
+        limit;
+    }
+    return std::abs(camera.get_focal_length() * point.m_y) <= limit;
   }
 }
 
@@ -0,0 +1,37 @@
+#ifndef ASHKAL_SHADING_RATE_HPP
+#define ASHKAL_SHADING_RATE_HPP
+#include <algorithm>
+
+namespace Ashkal {
+
+  /**
+   * Specifies how many pixels share a single evaluation of the shading
+   * pipeline. Coverage and depth are always resolved per pixel.
+   */
+  enum class ShadingRate {
+
+    /** Every pixel is shaded individually. */
+    ONE_BY_ONE,
+
+    /** Each aligned block of 2x2 pixels is shaded once. */
+    TWO_BY_TWO,
+
+    /** Each aligned block of 4x4 pixels is shaded once. */
+    FOUR_BY_FOUR
+  };
+
+  /**
+   * Returns the width and height in pixels of the blocks shaded once at a
+   * given shading rate.
+   */
+  inline int get_size(ShadingRate rate) {
+    return 1 << static_cast<int>(rate);
+  }
+
+  /** Returns the coarser of two shading rates. */
+  inline ShadingRate get_coarsest(ShadingRate left, ShadingRate right) {
+    return std::max(left, right);
+  }
+}
+
+#endif
@@ -0,0 +1,803 @@
+#ifndef ASHKAL_TILE_RENDERER_HPP
+#define ASHKAL_TILE_RENDERER_HPP
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Ashkal/Camera.hpp"
+#include "Ashkal/Culling.hpp"
+#include "Ashkal/OcclusionBuffer.hpp"
+#include "Ashkal/Raster.hpp"
+#include "Ashkal/Rasterizer.hpp"
+#include "Ashkal/RenderQueue.hpp"
+#include "Ashkal/Scene.hpp"
+#include "Ashkal/ShadedVertex.hpp"
+#include "Ashkal/VertexCache.hpp"
+
+namespace Ashkal {
+
+  /** Specifies how the pixels of a tile are shaded. */
+  enum class ShadingMode {
+
+    /** Every pixel that passes the depth test is shaded as it's drawn. */
+    FORWARD,
+
+    /**
+     * The tile's depths are resolved by a depth-only pass and only the pixels
+     * whose depth equals the resolved depth are then shaded.
+     */
+    DEPTH_PRE_PASS,
+
+    /**
+     * The tile's nearest triangles are resolved into a visibility buffer and
+     * every covered pixel is then shaded once.
+     */
+    VISIBILITY_BUFFER
+  };
+
+  /**
+   * Renders scenes using sort-middle tile binning. Triangles are first
+   * transformed, clipped and set up on the calling thread and binned into
+   * fixed size screen tiles. Each tile is then rasterized as a whole by one of
+   * a pool of threads into tile-local color and depth storage, which is
+   * resolved into the output rasters once the tile is complete.
+   * Triangles are culled as soon as they are transformed into camera space,
+   * before any lighting or clipping is done for them.
+   * Triangles are always clipped against the near and far planes, but are only
+   * clipped against the left, right, bottom and top planes when they extend
+   * past a guard band surrounding the viewport, otherwise the rasterizer's
+   * scissoring to the viewport discards the pixels outside of it.
+   * The fragments of the visible models are collected into a RenderQueue and
+   * drawn front to back, so that the depth tests reject as much as possible,
+   * and grouped by material among fragments at similar depths.
+   * When the scene has occluders, they are first rasterized into a low
+   * resolution OcclusionBuffer, and every segment of every model is tested
+   * against it before any of its vertices are transformed.
+   * Each tile keeps a HierarchicalDepthBuffer bounding its depths, which is
+   * used to skip triangles, and blocks of triangles, hidden behind what the
+   * tile has already drawn.
+   * Outside of the FORWARD shading mode, each tile's visibility is resolved
+   * before it is shaded, either by a depth pre-pass or into a visibility
+   * buffer recording the identity of the nearest triangle, so that overdraw
+   * only costs depth testing.
+   * Materials and screen regions may be shaded at a coarse ShadingRate, in
+   * which case depth is still resolved per pixel but each block of pixels
+   * drawn by a triangle is shaded once, except in the VISIBILITY_BUFFER
+   * shading mode or when multisampling.
+   * When multisampling, each tile instead stores SAMPLE_COUNT color and depth
+   * samples per pixel, is always shaded forward, once per pixel per triangle,
+   * and is resolved into the output rasters by averaging its color samples.
+   */
+  class TileRenderer {
+    public:
+
+      /**
+       * The width and height of a tile in pixels, chosen so that a tile's
+       * color and depth storage fits within a core's L2 cache.
+       */
+      static constexpr auto TILE_SIZE = 64;
+
+      /** The default extent of the guard band as a multiple of the viewport. */
+      static constexpr auto DEFAULT_GUARD_BAND = 2.f;
+
+      /**
+       * The factor by which the resolution of the occlusion buffer is reduced
+       * from the resolution of the frame.
+       */
+      static constexpr auto OCCLUSION_SCALE = 4;
+
+      /**
+       * Constructs a TileRenderer using one thread per hardware thread.
+       */
+      TileRenderer();
+
+      /**
+       * Constructs a TileRenderer.
+       * @param thread_count The number of threads used to rasterize tiles,
+       *        including the thread calling render.
+       */
+      explicit TileRenderer(int thread_count);
+
+      ~TileRenderer();
+
+      /** Returns the number of threads used to rasterize tiles. */
+      int get_thread_count() const;
+
+      /**
+       * Returns the extent of the guard band as a multiple of the viewport's
+       * extent.
+       */
+      float get_guard_band() const;
+
+      /**
+       * Sets the extent of the guard band.
+       * @param guard_band The extent of the guard band as a multiple of the
+       *        viewport's extent. A value of 1 clips every triangle that
+       *        crosses the edge of the viewport, larger values must keep the
+       *        projected vertices within SubpixelCoordinate's range.
+       */
+      void set_guard_band(float guard_band);
+
+      /** Returns which triangles are culled based on the way they face. */
+      CullMode get_cull_mode() const;
+
+      /**
+       * Sets which triangles are culled based on the way they face.
+       * Triangles using a double-sided Material are never culled based on the
+       * way they face.
+       * @param mode The directions of the triangles to cull.
+       */
+      void set_cull_mode(CullMode mode);
+
+      /** Returns how the pixels of a tile are shaded. */
+      ShadingMode get_shading_mode() const;
+
+      /**
+       * Sets how the pixels of a tile are shaded.
+       * @param mode The shading mode.
+       */
+      void set_shading_mode(ShadingMode mode);
+
+      /**
+       * Returns the shading rate of each tile, where rates(column, row) is
+       * the rate of the tile at that column and row.
+       */
+      const Raster<ShadingRate>& get_shading_rates() const;
+
+      /**
+       * Sets the shading rate of each screen region, which coarsens the
+       * shading rate of every Material drawn within it, for example to shade
+       * the periphery of the screen coarsely.
+       * @param rates The shading rate of each tile, where rates(column, row)
+       *        is the rate of the tile at that column and row of TILE_SIZE
+       *        tiles. Tiles outside of the raster are shaded at the rates of
+       *        their materials.
+       */
+      void set_shading_rates(Raster<ShadingRate> rates);
+
+      /**
+       * Returns <code>true</code> iff tiles are rendered with multisampling.
+       */
+      bool is_multisampled() const;
+
+      /**
+       * Sets whether tiles are rendered with multisampling, which takes
+       * precedence over the shading mode.
+       * @param is_multisampled Whether to store SAMPLE_COUNT samples per
+       *        pixel.
+       */
+      void set_multisampled(bool is_multisampled);
+
+      /**
+       * Returns how often texture coordinates are corrected for perspective.
+       */
+      const PerspectiveCorrection& get_perspective_correction() const;
+
+      /**
+       * Sets how often texture coordinates are corrected for perspective
+       * along a row of pixels.
+       * @param correction The perspective correction to use.
+       */
+      void set_perspective_correction(const PerspectiveCorrection& correction);
+
+      /**
+       * Returns the number of triangles the last render loaded into its
+       * vertex cache, which excludes the triangles of every meshlet culled.
+       */
+      int get_loaded_triangle_count() const;
+
+      /**
+       * Renders a scene.
+       * @param scene The scene to render.
+       * @param camera The camera to render the scene from.
+       * @param frame_buffer The raster to write colors to.
+       * @param depth_buffer The raster used to perform depth testing.
+       */
+      void render(const Scene& scene, const Camera& camera,
+        FrameBuffer& frame_buffer, DepthBuffer& depth_buffer);
+
+    private:
+      static constexpr auto CLIPPING_ORDER = std::array{
+        Frustum::ClippingPlane::NEAR, Frustum::ClippingPlane::FAR,
+        Frustum::ClippingPlane::LEFT, Frustum::ClippingPlane::RIGHT,
+        Frustum::ClippingPlane::BOTTOM, Frustum::ClippingPlane::TOP};
+      struct Draw {
+        const Material* m_material;
+        int m_first_triangle;
+      };
+      struct BinnedTriangle {
+        TriangleSetup m_setup;
+        int m_draw;
+      };
+      struct TileStorage {
+        FrameBuffer m_frame_buffer;
+        DepthBuffer m_depth_buffer;
+        VisibilityBuffer m_visibility_buffer;
+        HierarchicalDepthBuffer m_hierarchical_depth_buffer;
+        FrameBuffer m_color_samples;
+        DepthBuffer m_depth_samples;
+        CoverageBuffer m_coverage_buffer;
+
+        TileStorage();
+      };
+      std::vector<Draw> m_draws;
+      std::vector<BinnedTriangle> m_triangles;
+      std::vector<std::vector<int>> m_bins;
+      int m_column_count;
+      int m_row_count;
+      float m_guard_band;
+      CullMode m_cull_mode;
+      ShadingMode m_shading_mode;
+      Raster<ShadingRate> m_shading_rates;
+      bool m_is_multisampled;
+      PerspectiveCorrection m_perspective_correction;
+      OcclusionBuffer m_occlusion_buffer;
+      RenderQueue m_queue;
+      VertexCache m_vertex_cache;
+      std::vector<VertexTriangle> m_visible_triangles;
+      int m_loaded_triangle_count;
+      bool m_has_occluders;
+      std::vector<TileStorage> m_storage;
+      std::vector<std::thread> m_threads;
+      std::mutex m_mutex;
+      std::condition_variable m_work_condition;
+      std::condition_variable m_completion_condition;
+      std::atomic_int m_next_tile;
+      int m_generation;
+      int m_pending_thread_count;
+      bool m_is_running;
+      FrameBuffer* m_frame_buffer;
+      DepthBuffer* m_depth_buffer;
+
+      TileRenderer(const TileRenderer&) = delete;
+      TileRenderer& operator =(const TileRenderer&) = delete;
+      void add_occluders(const Model& model, const MeshNode& node,
+        const Camera& camera, const Matrix& parent_transformation);
+      void bin(const Scene& scene, const Camera& camera, int width, int height);
+      void enqueue(const Model& model, const MeshNode& node,
+        const Camera& camera, const Matrix& parent_transformation);
+      const std::vector<VertexTriangle>& cull_meshlets(
+        const Fragment& fragment, const Camera& camera,
+        const Matrix& transformation, bool is_clipped);
+      void bin(const Model& model, const Fragment& fragment,
+        const Scene& scene, const Camera& camera, const Matrix& transformation,
+        int width, int height, int plane_index);
+      void bin(const ShadedVertex& a, const ShadedVertex& b,
+        const ShadedVertex& c, int draw, const Camera& camera, int width,
+        int height, int plane_index);
+      void rasterize_tiles(TileStorage& storage);
+      void rasterize_tile(int tile, TileStorage& storage);
+      void rasterize_visibility_tile(
+        int tile, int left, int top, int width, int height,
+        TileStorage& storage);
+      void rasterize_multisample_tile(
+        int tile, int left, int top, int width, int height,
+        TileStorage& storage);
+      void run(int index);
+  };
+
+  // Each tile's copies into and out of the screen buffers touch only the
+  // clear tiles it contains, so tiles can be copied concurrently.
+  static_assert(TileRenderer::TILE_SIZE % FrameBuffer::CLEAR_TILE_SIZE == 0);
+
+  inline TileRenderer::TileStorage::TileStorage()
+    : m_frame_buffer(TILE_SIZE, TILE_SIZE),
+      m_depth_buffer(TILE_SIZE, TILE_SIZE),
+      m_visibility_buffer(TILE_SIZE, TILE_SIZE),
+      m_hierarchical_depth_buffer(TILE_SIZE, TILE_SIZE),
+      m_color_samples(TILE_SIZE, TILE_SIZE * SAMPLE_COUNT),
+      m_depth_samples(TILE_SIZE, TILE_SIZE * SAMPLE_COUNT),
+      m_coverage_buffer(TILE_SIZE, TILE_SIZE) {
+    m_coverage_buffer.fill(0);
+  }
+
+  inline TileRenderer::TileRenderer()
+    : TileRenderer(
+        std::max(1, static_cast<int>(std::thread::hardware_concurrency()))) {}
+
+  inline TileRenderer::TileRenderer(int thread_count)
+      : m_column_count(0),
+        m_row_count(0),
+        m_guard_band(DEFAULT_GUARD_BAND),
+        m_cull_mode(CullMode::BACK),
+        m_shading_mode(ShadingMode::FORWARD),
+        m_shading_rates(0, 0),
+        m_is_multisampled(false),
+        m_perspective_correction(EXACT_PERSPECTIVE_CORRECTION),
+        m_occlusion_buffer(0, 0),
+        m_loaded_triangle_count(0),
+        m_has_occluders(false),
+        m_storage(std::max(1, thread_count)),
+        m_next_tile(0),
+        m_generation(0),
+        m_pending_thread_count(0),
+        m_is_running(true),
+        m_frame_buffer(nullptr),
+        m_depth_buffer(nullptr) {
+    for(auto i = 1; i < thread_count; ++i) {
+      m_threads.emplace_back([=, this] {
+        run(i);
+      });
+    }
+  }
+
+  inline TileRenderer::~TileRenderer() {
+    {
+      auto lock = std::lock_guard(m_mutex);
+      m_is_running = false;
+    }
+    m_work_condition.notify_all();
+    for(auto& thread : m_threads) {
+      thread.join();
+    }
+  }
+
+  inline int TileRenderer::get_thread_count() const {
+    return static_cast<int>(m_storage.size());
+  }
+
+  inline float TileRenderer::get_guard_band() const {
+    return m_guard_band;
+  }
+
+  inline void TileRenderer::set_guard_band(float guard_band) {
+    m_guard_band = guard_band;
+  }
+
+  inline CullMode TileRenderer::get_cull_mode() const {
+    return m_cull_mode;
+  }
+
+  inline void TileRenderer::set_cull_mode(CullMode mode) {
+    m_cull_mode = mode;
+  }
+
+  inline ShadingMode TileRenderer::get_shading_mode() const {
+    return m_shading_mode;
+  }
+
+  inline void TileRenderer::set_shading_mode(ShadingMode mode) {
+    m_shading_mode = mode;
+  }
+
+  inline const Raster<ShadingRate>& TileRenderer::get_shading_rates() const {
+    return m_shading_rates;
+  }
+
+  inline void TileRenderer::set_shading_rates(Raster<ShadingRate> rates) {
+    m_shading_rates = std::move(rates);
+  }
+
+  inline bool TileRenderer::is_multisampled() const {
+    return m_is_multisampled;
+  }
+
+  inline void TileRenderer::set_multisampled(bool is_multisampled) {
+    m_is_multisampled = is_multisampled;
+  }
+
+  inline const PerspectiveCorrection&
+      TileRenderer::get_perspective_correction() const {
+    return m_perspective_correction;
+  }
+
+  inline void TileRenderer::set_perspective_correction(
+      const PerspectiveCorrection& correction) {
+    m_perspective_correction = correction;
+  }
+
+  inline int TileRenderer::get_loaded_triangle_count() const {
+    return m_loaded_triangle_count;
+  }
+
+  inline void TileRenderer::render(const Scene& scene, const Camera& camera,
+      FrameBuffer& frame_buffer, DepthBuffer& depth_buffer) {
+    auto width = frame_buffer.get_width();
+    auto height = frame_buffer.get_height();
+    m_column_count = (width + TILE_SIZE - 1) / TILE_SIZE;
+    m_row_count = (height + TILE_SIZE - 1) / TILE_SIZE;
+    m_bins.resize(m_column_count * m_row_count);
+    for(auto& bin : m_bins) {
+      bin.clear();
+    }
+    m_draws.clear();
+    m_triangles.clear();
+    m_loaded_triangle_count = 0;
+    bin(scene, camera, width, height);
+    m_frame_buffer = &frame_buffer;
+    m_depth_buffer = &depth_buffer;
+    m_next_tile = 0;
+    {
+      auto lock = std::lock_guard(m_mutex);
+      ++m_generation;
+      m_pending_thread_count = static_cast<int>(m_threads.size());
+    }
+    m_work_condition.notify_all();
+    rasterize_tiles(m_storage.front());
+    auto lock = std::unique_lock(m_mutex);
+    m_completion_condition.wait(lock, [&] {
+      return m_pending_thread_count == 0;
+    });
+    m_frame_buffer = nullptr;
+    m_depth_buffer = nullptr;
+  }
+
+  inline void TileRenderer::add_occluders(const Model& model,
+      const MeshNode& node, const Camera& camera,
+      const Matrix& parent_transformation) {
+    auto transformation =
+      parent_transformation * model.get_segment(node).get_transformation();
+    if(node.get_type() == MeshNode::Type::CHUNK) {
+      for(auto& child : node.as_chunk()) {
+        add_occluders(model, child, camera, transformation);
+      }
+      return;
+    }
+    m_vertex_cache.load(node.as_fragment().get_triangles(),
+      model.get_mesh().m_vertices, transformation, camera);
+    for(auto& triangle : m_vertex_cache.get_triangles()) {
+      m_occlusion_buffer.add(m_vertex_cache.get_position(triangle.m_a),
+        m_vertex_cache.get_position(triangle.m_b),
+        m_vertex_cache.get_position(triangle.m_c), camera);
+    }
+  }
+
+  inline void TileRenderer::bin(
+      const Scene& scene, const Camera& camera, int width, int height) {
+    auto occlusion_width = (width + OCCLUSION_SCALE - 1) / OCCLUSION_SCALE;
+    auto occlusion_height = (height + OCCLUSION_SCALE - 1) / OCCLUSION_SCALE;
+    if(m_occlusion_buffer.get_width() != occlusion_width ||
+        m_occlusion_buffer.get_height() != occlusion_height) {
+      m_occlusion_buffer = OcclusionBuffer(occlusion_width, occlusion_height);
+    } else {
+      m_occlusion_buffer.clear();
+    }
+    m_has_occluders = false;
+    for(auto i = 0; i != scene.get_model_count(); ++i) {
+      auto& model = scene.get_model(i);
+      if(model.is_occluder() && intersects(camera.get_frustum(),
+          model.get_segment(model.get_mesh().m_root).get_bounding_box())) {
+        add_occluders(model, model.get_mesh().m_root, camera,
+          Matrix::IDENTITY());
+        m_has_occluders = true;
+      }
+    }
+    m_queue.clear();
+    for(auto i = 0; i != scene.get_model_count(); ++i) {
+      auto& model = scene.get_model(i);
+      if(intersects(camera.get_frustum(),
+          model.get_segment(model.get_mesh().m_root).get_bounding_box())) {
+        enqueue(model, model.get_mesh().m_root, camera, Matrix::IDENTITY());
+      }
+    }
+    m_queue.sort();
+    for(auto i = 0; i != m_queue.get_size(); ++i) {
+      auto& item = m_queue.get(i);
+      bin(*item.m_model, *item.m_fragment, scene, camera,
+        item.m_transformation, width, height, item.m_is_clipped ? 0 :
+          static_cast<int>(CLIPPING_ORDER.size()));
+    }
+  }
+
+  inline void TileRenderer::enqueue(const Model& model, const MeshNode& node,
+      const Camera& camera, const Matrix& parent_transformation) {
+    auto& segment = model.get_segment(node);
+    auto bounding_box = segment.get_bounding_box();
+    bounding_box.apply(parent_transformation);
+    if(!intersects(camera.get_frustum(), bounding_box) || (m_has_occluders &&
+        m_occlusion_buffer.is_occluded(bounding_box, camera))) {
+      return;
+    }
+    auto transformation = parent_transformation * segment.get_transformation();
+    if(node.get_type() == MeshNode::Type::CHUNK) {
+      for(auto& child : node.as_chunk()) {
+        enqueue(model, child, camera, transformation);
+      }
+    } else {
+      m_queue.add(model, node.as_fragment(), transformation,
+        get_depth(bounding_box, camera),
+        !contains(camera.get_frustum(), bounding_box));
+    }
+  }
+
+  inline const std::vector<VertexTriangle>& TileRenderer::cull_meshlets(
+      const Fragment& fragment, const Camera& camera,
+      const Matrix& transformation, bool is_clipped) {
+    auto& meshlets = fragment.get_meshlets();
+    auto is_facing_culled = !fragment.get_material().is_double_sided() &&
+      m_cull_mode != CullMode::NONE;
+    if(meshlets.empty() || (!is_clipped && !is_facing_culled)) {
+      return fragment.get_triangles();
+    }
+
+    // The facing of a meshlet is tested in model space, where its normal
+    // cone is defined, by moving the camera into model space. A mirroring
+    // transformation reverses the winding of the triangles on screen, so the
+    // meshlets facing away from the eye in model space are then the front
+    // facing ones.
+    auto eye = invert(transformation) * camera.get_position();
+    auto is_back_culled =
+      (m_cull_mode == CullMode::BACK) != is_mirroring(transformation);
+    auto& triangles = fragment.get_triangles();
+    m_visible_triangles.clear();
+    for(auto& meshlet : meshlets) {
+      if(is_facing_culled && (is_back_culled ?
+          is_back_facing(meshlet, eye) : is_front_facing(meshlet, eye))) {
+        continue;
+      }
+      if(is_clipped) {
+        auto bounding_box = meshlet.m_bounding_box;
+        bounding_box.apply(transformation);
+        if(!intersects(camera.get_frustum(), bounding_box)) {
+          continue;
+        }
+      }
+      m_visible_triangles.insert(m_visible_triangles.end(),
+        triangles.begin() + meshlet.m_offset,
+        triangles.begin() + meshlet.m_offset + meshlet.m_count);
+    }
+    return m_visible_triangles;
+  }
+
+  inline void TileRenderer::bin(const Model& model, const Fragment& fragment,
+      const Scene& scene, const Camera& camera, const Matrix& transformation,
+      int width, int height, int plane_index) {
+    auto& material = fragment.get_material();
+    auto draw = static_cast<int>(m_draws.size());
+    m_draws.push_back(
+      Draw(&material, static_cast<int>(m_triangles.size())));
+    auto is_clipped =
+      plane_index != static_cast<int>(CLIPPING_ORDER.size());
+    m_vertex_cache.load(
+      cull_meshlets(fragment, camera, transformation, is_clipped),
+      model.get_mesh().m_vertices, transformation, camera);
+    m_loaded_triangle_count +=
+      static_cast<int>(m_vertex_cache.get_triangles().size());
+    for(auto& triangle : m_vertex_cache.get_triangles()) {
+      auto result = cull(m_vertex_cache.get_position(triangle.m_a),
+        m_vertex_cache.get_position(triangle.m_b),
+        m_vertex_cache.get_position(triangle.m_c), camera.get_local_frustum(),
+        m_cull_mode, material.is_double_sided());
+      if(result == CullResult::CULLED) {
+        continue;
+      }
+      auto& shaded_a = m_vertex_cache.get_shaded(triangle.m_a, scene);
+      auto& shaded_b = m_vertex_cache.get_shaded(triangle.m_b, scene);
+      auto& shaded_c = m_vertex_cache.get_shaded(triangle.m_c, scene);
+      if(result == CullResult::FRONT_FACING) {
+        bin(shaded_a, shaded_b, shaded_c, draw, camera, width, height,
+          plane_index);
+      } else {
+        bin(shaded_a, shaded_c, shaded_b, draw, camera, width, height,
+          plane_index);
+      }
+    }
+  }
+
+  inline void TileRenderer::bin(const ShadedVertex& a, const ShadedVertex& b,
+      const ShadedVertex& c, int draw, const Camera& camera, int width,
+      int height, int plane_index) {
+    if(plane_index == static_cast<int>(CLIPPING_ORDER.size())) {
+      auto setup = [&] {
+        if(m_is_multisampled) {
+          return make_multisample_triangle_setup(
+            a, b, c, camera, width, height);
+        }
+        return make_triangle_setup(a, b, c, camera, width, height);
+      }();
+      if(!setup) {
+        return;
+      }
+      correct_perspective(*setup, m_perspective_correction);
+      auto index = static_cast<int>(m_triangles.size());
+      m_triangles.push_back(BinnedTriangle(*setup, draw));
+      for(auto row = setup->m_min_y / TILE_SIZE;
+          row <= setup->m_max_y / TILE_SIZE; ++row) {
+        for(auto column = setup->m_min_x / TILE_SIZE;
+            column <= setup->m_max_x / TILE_SIZE; ++column) {
+          m_bins[row * m_column_count + column].push_back(index);
+        }
+      }
+      return;
+    }
+    auto clipping_plane = CLIPPING_ORDER[plane_index];
+    auto& plane = camera.get_local_frustum().get_plane(clipping_plane);
+    auto is_a_inside = is_in_front(plane, a.m_position);
+    auto is_b_inside = is_in_front(plane, b.m_position);
+    auto is_c_inside = is_in_front(plane, c.m_position);
+    if(!is_a_inside && !is_b_inside && !is_c_inside) {
+      return;
+    }
+    auto is_guarded = [&] (const ShadedVertex& vertex, bool is_inside) {
+      return is_inside || is_in_guard_band(
+        vertex.m_position, camera, clipping_plane, m_guard_band);
+    };
+    if((is_a_inside && is_b_inside && is_c_inside) ||
+        (clipping_plane != Frustum::ClippingPlane::NEAR &&
+          clipping_plane != Frustum::ClippingPlane::FAR &&
+          is_guarded(a, is_a_inside) && is_guarded(b, is_b_inside) &&
+          is_guarded(c, is_c_inside))) {
+      bin(a, b, c, draw, camera, width, height, plane_index + 1);
+      return;
+    }
+    auto clipped_a = ShadedVertex();
+    auto clipped_b = ShadedVertex();
+    auto clipped_vertices = clip(a, b, c, clipped_a, clipped_b, plane);
+    if(!clipped_vertices.front()) {
+      return;
+    }
+    bin(*clipped_vertices[0], *clipped_vertices[1], *clipped_vertices[2],
+      draw, camera, width, height, plane_index + 1);
+    if(clipped_vertices.back()) {
+      bin(*clipped_vertices[0], *clipped_vertices[2], *clipped_vertices[3],
+        draw, camera, width, height, plane_index + 1);
+    }
+  }
+
+  inline void TileRenderer::rasterize_tiles(TileStorage& storage) {
+    auto tile_count = static_cast<int>(m_bins.size());
+    while(true) {
+      auto tile = m_next_tile.fetch_add(1);
+      if(tile >= tile_count) {
+        return;
+      }
+      rasterize_tile(tile, storage);
+    }
+  }
+
+  inline void TileRenderer::rasterize_tile(int tile, TileStorage& storage) {
+    auto& bin = m_bins[tile];
+    if(bin.empty()) {
+      return;
+    }
+    auto left = (tile % m_column_count) * TILE_SIZE;
+    auto top = (tile / m_column_count) * TILE_SIZE;
+    auto width = std::min(TILE_SIZE, m_frame_buffer->get_width() - left);
+    auto height = std::min(TILE_SIZE, m_frame_buffer->get_height() - top);
+    if(m_is_multisampled) {
+      rasterize_multisample_tile(tile, left, top, width, height, storage);
+      return;
+    }
+    m_frame_buffer->copy_to(left, top, width, height, storage.m_frame_buffer);
+    m_depth_buffer->copy_to(left, top, width, height, storage.m_depth_buffer);
+    storage.m_hierarchical_depth_buffer.build(storage.m_depth_buffer);
+    auto column = tile % m_column_count;
+    auto row = tile / m_column_count;
+    auto tile_rate = ShadingRate::ONE_BY_ONE;
+    if(column < m_shading_rates.get_width() &&
+        row < m_shading_rates.get_height()) {
+      tile_rate = m_shading_rates(column, row);
+    }
+    if(m_shading_mode == ShadingMode::VISIBILITY_BUFFER) {
+      rasterize_visibility_tile(tile, left, top, width, height, storage);
+    } else if(m_shading_mode == ShadingMode::DEPTH_PRE_PASS) {
+      for(auto index : bin) {
+        rasterize_depth(m_triangles[index].m_setup, left, top,
+          storage.m_depth_buffer, storage.m_hierarchical_depth_buffer);
+      }
+      for(auto index : bin) {
+        auto& triangle = m_triangles[index];
+        auto& material = *m_draws[triangle.m_draw].m_material;
+        auto rate = get_coarsest(material.get_shading_rate(), tile_rate);
+        if(rate == ShadingRate::ONE_BY_ONE) {
+          rasterize_visible(triangle.m_setup, material, left, top,
+            storage.m_frame_buffer, storage.m_depth_buffer,
+            storage.m_hierarchical_depth_buffer);
+        } else {
+          rasterize_visible(triangle.m_setup, material, rate, left, top,
+            storage.m_frame_buffer, storage.m_depth_buffer,
+            storage.m_hierarchical_depth_buffer, storage.m_coverage_buffer);
+        }
+      }
+    } else {
+      for(auto index : bin) {
+        auto& triangle = m_triangles[index];
+        auto& material = *m_draws[triangle.m_draw].m_material;
+        auto rate = get_coarsest(material.get_shading_rate(), tile_rate);
+        if(rate == ShadingRate::ONE_BY_ONE) {
+          rasterize(triangle.m_setup, material, left, top,
+            storage.m_frame_buffer, storage.m_depth_buffer,
+            storage.m_hierarchical_depth_buffer);
+        } else {
+          rasterize(triangle.m_setup, material, rate, left, top,
+            storage.m_frame_buffer, storage.m_depth_buffer,
+            storage.m_hierarchical_depth_buffer, storage.m_coverage_buffer);
+        }
+      }
+    }
+    m_frame_buffer->copy_from(
+      storage.m_frame_buffer, left, top, width, height);
+    m_depth_buffer->copy_from(
+      storage.m_depth_buffer, left, top, width, height);
+  }
+
+  inline void TileRenderer::rasterize_visibility_tile(int tile, int left,
+      int top, int width, int height, TileStorage& storage) {
+    auto& visibility_buffer = storage.m_visibility_buffer;
+    visibility_buffer.fill(NO_VISIBILITY);
+    for(auto index : m_bins[tile]) {
+      auto& triangle = m_triangles[index];
+      rasterize_visibility(triangle.m_setup, make_visibility(triangle.m_draw,
+        index - m_draws[triangle.m_draw].m_first_triangle), left, top,
+        visibility_buffer, storage.m_depth_buffer,
+        storage.m_hierarchical_depth_buffer);
+    }
+    for(auto y = 0; y != height; ++y) {
+      auto x = 0;
+      while(x != width) {
+        auto visibility = visibility_buffer(x, y);
+        auto count = 1;
+        while(count != LANE_COUNT && x + count != width &&
+            visibility_buffer(x + count, y) == visibility) {
+          ++count;
+        }
+        if(visibility != NO_VISIBILITY) {
+          auto& draw = m_draws[get_draw(visibility)];
+          auto& triangle =
+            m_triangles[draw.m_first_triangle + get_triangle(visibility)];
+          shade_run(triangle.m_setup, *draw.m_material, left + x, top + y,
+            count, &storage.m_frame_buffer(x, y));
+        }
+        x += count;
+      }
+    }
+  }
+
+  inline void TileRenderer::rasterize_multisample_tile(int tile, int left,
+      int top, int width, int height, TileStorage& storage) {
+    auto& color_samples = storage.m_color_samples;
+    auto& depth_samples = storage.m_depth_samples;
+    m_frame_buffer->copy_to(left, top, width, height, storage.m_frame_buffer);
+    m_depth_buffer->copy_to(left, top, width, height, storage.m_depth_buffer);
+    for(auto y = 0; y != height; ++y) {
+      for(auto i = 0; i != SAMPLE_COUNT; ++i) {
+        std::copy_n(&storage.m_frame_buffer(0, y), width,
+          &color_samples(0, y * SAMPLE_COUNT + i));
+        std::copy_n(&storage.m_depth_buffer(0, y), width,
+          &depth_samples(0, y * SAMPLE_COUNT + i));
+      }
+    }
+    for(auto index : m_bins[tile]) {
+      auto& triangle = m_triangles[index];
+      rasterize_multisample(triangle.m_setup,
+        *m_draws[triangle.m_draw].m_material, left, top, color_samples,
+        depth_samples);
+    }
+    for(auto y = 0; y != height; ++y) {
+      resolve(color_samples, y, width, &storage.m_frame_buffer(0, y));
+      resolve(depth_samples, y, width, &storage.m_depth_buffer(0, y));
+    }
+    m_frame_buffer->copy_from(
+      storage.m_frame_buffer, left, top, width, height);
+    m_depth_buffer->copy_from(
+      storage.m_depth_buffer, left, top, width, height);
+  }
+
+  inline void TileRenderer::run(int index) {
+    auto generation = 0;
+    while(true) {
+      {
+        auto lock = std::unique_lock(m_mutex);
+        m_work_condition.wait(lock, [&] {
+          return !m_is_running || m_generation != generation;
+        });
+        if(!m_is_running) {
+          return;
+        }
+        generation = m_generation;
+      }
+      rasterize_tiles(m_storage[index]);
+      auto lock = std::lock_guard(m_mutex);
+      --m_pending_thread_count;
+      if(m_pending_thread_count == 0) {
+        m_completion_condition.notify_one();
+      }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,193 @@
+#ifndef ASHKAL_VERTEX_BATCH_HPP
+#define ASHKAL_VERTEX_BATCH_HPP
+#include <array>
+#include <vector>
+#include "Ashkal/Camera.hpp"
+#include "Ashkal/Lanes.hpp"
+#include "Ashkal/Matrix.hpp"
+#include "Ashkal/Point.hpp"
+#include "Ashkal/Scene.hpp"
+#include "Ashkal/Vector.hpp"
+
+namespace Ashkal {
+
+  /**
+   * Stores the positions and normals of a batch of vertices with each
+   * component in its own array, so that vertices are transformed and lit
+   * LANE_COUNT at a time. The arrays are padded to a whole number of lanes.
+   */
+  struct VertexBatch {
+
+    /** The number of vertices in the batch. */
+    int m_size;
+
+    /** The x coordinate of each vertex's position. */
+    std::vector<float> m_x;
+
+    /** The y coordinate of each vertex's position. */
+    std::vector<float> m_y;
+
+    /** The z coordinate of each vertex's position. */
+    std::vector<float> m_z;
+
+    /** The x component of each vertex's normal. */
+    std::vector<float> m_normal_x;
+
+    /** The y component of each vertex's normal. */
+    std::vector<float> m_normal_y;
+
+    /** The z component of each vertex's normal. */
+    std::vector<float> m_normal_z;
+
+    /** The intensity of the light reaching each vertex. */
+    std::vector<float> m_intensity;
+  };
+
+  /**
+   * Resizes a batch, padding its arrays to a whole number of lanes.
+   * @param batch The batch to resize.
+   * @param size The number of vertices to store.
+   */
+  inline void resize(VertexBatch& batch, int size) {
+    auto padded_size = static_cast<std::size_t>(
+      (size + LANE_COUNT - 1) / LANE_COUNT * LANE_COUNT);
+    batch.m_size = size;
+    batch.m_x.resize(padded_size);
+    batch.m_y.resize(padded_size);
+    batch.m_z.resize(padded_size);
+    batch.m_normal_x.resize(padded_size);
+    batch.m_normal_y.resize(padded_size);
+    batch.m_normal_z.resize(padded_size);
+    batch.m_intensity.resize(padded_size);
+  }
+
+  /**
+   * Stores a vertex's position and normal in a batch.
+   * @param batch The batch to store the vertex in.
+   * @param index The index of the vertex within the batch.
+   * @param position The vertex's position.
+   * @param normal The vertex's normal.
+   */
+  inline void set(VertexBatch& batch, int index, const Point& position,
+      const Vector& normal) {
+    batch.m_x[index] = position.m_x;
+    batch.m_y[index] = position.m_y;
+    batch.m_z[index] = position.m_z;
+    batch.m_normal_x[index] = normal.m_x;
+    batch.m_normal_y[index] = normal.m_y;
+    batch.m_normal_z[index] = normal.m_z;
+  }
+
+  /** Returns the position of a vertex in a batch. */
+  inline Point get_position(const VertexBatch& batch, int index) {
+    return Point(batch.m_x[index], batch.m_y[index], batch.m_z[index]);
+  }
+
+  /** Returns the normal of a vertex in a batch. */
+  inline Vector get_normal(const VertexBatch& batch, int index) {
+    return Vector(batch.m_normal_x[index], batch.m_normal_y[index],
+      batch.m_normal_z[index]);
+  }
+
+  /**
+   * Transforms the position of every vertex in a batch by a matrix using
+   * homogeneous coordinates, equivalent to multiplying each by the matrix.
+   * @param batch The batch whose positions are transformed in place.
+   * @param transformation The transformation to apply.
+   */
+  inline void transform_positions(
+      VertexBatch& batch, const Matrix& transformation) {
+    auto row = [&] (int y) {
+      return std::array{FloatLanes(transformation.get(0, y)),
+        FloatLanes(transformation.get(1, y)),
+        FloatLanes(transformation.get(2, y)),
+        FloatLanes(transformation.get(3, y))};
+    };
+    auto row_x = row(0);
+    auto row_y = row(1);
+    auto row_z = row(2);
+    for(auto i = 0; i < batch.m_size; i += LANE_COUNT) {
+      auto x = load(batch.m_x.data() + i);
+      auto y = load(batch.m_y.data() + i);
+      auto z = load(batch.m_z.data() + i);
+      store(row_x[0] * x + row_x[1] * y + row_x[2] * z + row_x[3],
+        batch.m_x.data() + i);
+      store(row_y[0] * x + row_y[1] * y + row_y[2] * z + row_y[3],
+        batch.m_y.data() + i);
+      store(row_z[0] * x + row_z[1] * y + row_z[2] * z + row_z[3],
+        batch.m_z.data() + i);
+    }
+  }
+
+  /**
+   * Lights every vertex in a batch, transforming its normal into world space
+   * and storing the intensity of the scene's lights reaching it, equivalent
+   * to the shading computed by shade for a single vertex.
+   * @param batch The batch whose normals are transformed in place.
+   * @param transformation The transformation from model space to world space,
+   *        applied to the normals as by linear_transform.
+   * @param scene The scene providing the lighting.
+   */
+  inline void shade(
+      VertexBatch& batch, const Matrix& transformation, const Scene& scene) {
+    auto column = [&] (int x) {
+      return std::array{FloatLanes(transformation.get(x, 0)),
+        FloatLanes(transformation.get(x, 1)),
+        FloatLanes(transformation.get(x, 2))};
+    };
+    auto column_x = column(0);
+    auto column_y = column(1);
+    auto column_z = column(2);
+    auto& light = scene.get_directional_light();
+    auto direction_x = FloatLanes(-light.m_direction.m_x);
+    auto direction_y = FloatLanes(-light.m_direction.m_y);
+    auto direction_z = FloatLanes(-light.m_direction.m_z);
+    auto ambient_intensity =
+      FloatLanes(scene.get_ambient_light().m_intensity);
+    for(auto i = 0; i < batch.m_size; i += LANE_COUNT) {
+      auto x = load(batch.m_normal_x.data() + i);
+      auto y = load(batch.m_normal_y.data() + i);
+      auto z = load(batch.m_normal_z.data() + i);
+      auto normal_x = column_x[0] * x + column_x[1] * y + column_x[2] * z;
+      auto normal_y = column_y[0] * x + column_y[1] * y + column_y[2] * z;
+      auto normal_z = column_z[0] * x + column_z[1] * y + column_z[2] * z;
+      auto length = sqrt(
+        normal_x * normal_x + normal_y * normal_y + normal_z * normal_z);
+      normal_x = normal_x / length;
+      normal_y = normal_y / length;
+      normal_z = normal_z / length;
+      store(normal_x, batch.m_normal_x.data() + i);
+      store(normal_y, batch.m_normal_y.data() + i);
+      store(normal_z, batch.m_normal_z.data() + i);
+      auto intensity = max(normal_x * direction_x + normal_y * direction_y +
+        normal_z * direction_z, FloatLanes(0));
+      store(ambient_intensity + intensity, batch.m_intensity.data() + i);
+    }
+  }
+
+  /**
+   * Returns the color of the light reaching every vertex lit by shade, whose
+   * intensity varies from vertex to vertex.
+   */
+  inline Color get_light_color(const Scene& scene) {
+    return scene.get_ambient_light().m_color +
+      scene.get_directional_light().m_color;
+  }
+
+  /**
+   * Transforms every vertex in a batch from model space to a camera's space
+   * and lights it.
+   * @param batch The batch of vertices to transform in place.
+   * @param transformation The transformation from model space to world space.
+   * @param scene The scene providing the lighting.
+   * @param camera The camera whose space the vertices are transformed into.
+   */
+  inline void transform(VertexBatch& batch, const Matrix& transformation,
+      const Scene& scene, const Camera& camera) {
+    transform_positions(batch, make_view_transformation(camera) *
+      transformation);
+    shade(batch, transformation, scene);
+  }
+}
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef ASHKAL_VERTEX_CACHE_HPP
+#define ASHKAL_VERTEX_CACHE_HPP
+#include <cstdint>
+#include <vector>
+#include "Ashkal/Camera.hpp"
+#include "Ashkal/Matrix.hpp"
+#include "Ashkal/Point.hpp"
+#include "Ashkal/Scene.hpp"
+#include "Ashkal/ShadedVertex.hpp"
+#include "Ashkal/Vertex.hpp"
+#include "Ashkal/VertexBatch.hpp"
+#include "Ashkal/VertexTriangle.hpp"
+
+namespace Ashkal {
+
+  /**
+   * Shades a vertex of a model whose position has already been transformed
+   * into camera space.
+   * @param vertex The vertex to shade.
+   * @param position The vertex's position in camera space.
+   * @param transformation The transformation from model space to world space.
+   * @param scene The scene providing the lighting.
+   * @return The shaded vertex in camera space.
+   */
+  inline ShadedVertex shade(const Vertex& vertex, const Point& position,
+      const Matrix& transformation, const Scene& scene) {
+    return ShadedVertex(position, vertex.m_uv,
+      calculate_shading(scene.get_ambient_light()) +
+        calculate_shading(scene.get_directional_light(),
+          normalize(linear_transform(transformation, vertex.m_normal))));
+  }
+
+  /**
+   * Shades a vertex of a model, transforming it into camera space.
+   * @param vertex The vertex to shade.
+   * @param transformation The transformation from model space to world space.
+   * @param scene The scene providing the lighting.
+   * @param camera The camera whose space the vertex is transformed into.
+   * @return The shaded vertex in camera space.
+   */
+  inline ShadedVertex shade(const Vertex& vertex, const Matrix& transformation,
+      const Scene& scene, const Camera& camera) {
+    return shade(vertex,
+      world_to_view(transformation * vertex.m_position, camera),
+      transformation, scene);
+  }
+
+  /**
+   * Stores the vertices referenced by a set of triangles once they have been
+   * transformed into camera space and shaded, so that a vertex shared by
+   * several triangles is processed only once. Each distinct vertex is given a
+   * slot in the order it is first referenced, and the triangles are
+   * re-indexed by slot. Vertices are transformed as a VertexBatch when
+   * loaded, but lit only once a shaded vertex is first requested, so that
+   * fragments whose triangles are all culled are never lit.
+   */
+  class VertexCache {
+    public:
+
+      /** Constructs an empty VertexCache. */
+      VertexCache() = default;
+
+      /** Returns the number of distinct vertices loaded. */
+      int get_size() const;
+
+      /** Returns the loaded triangles, indexing vertices by slot. */
+      const std::vector<VertexTriangle>& get_triangles() const;
+
+      /** Returns the index into the mesh of the vertex in a slot. */
+      int get_index(int slot) const;
+
+      /** Returns the camera space position of the vertex in a slot. */
+      Point get_position(int slot) const;
+
+      /**
+       * Loads the vertices referenced by a set of triangles, transforming
+       * each into camera space.
+       * @param triangles The triangles to load, indexing into vertices.
+       * @param vertices The vertices of the mesh the triangles belong to.
+       * @param transformation The transformation from model space to world
+       *        space.
+       * @param camera The camera whose space the vertices are transformed
+       *        into.
+       */
+      void load(const std::vector<VertexTriangle>& triangles,
+        const std::vector<Vertex>& vertices, const Matrix& transformation,
+        const Camera& camera);
+
+      /**
+       * Returns the shaded vertex in a slot, shading it on its first request.
+       * @param slot The slot of the vertex.
+       * @param scene The scene providing the lighting.
+       */
+      const ShadedVertex& get_shaded(int slot, const Scene& scene);
+
+    private:
+      std::vector<int> m_slots;
+      std::vector<int> m_indices;
+      std::vector<VertexTriangle> m_triangles;
+      VertexBatch m_batch;
+      std::vector<ShadedVertex> m_shaded_vertices;
+      std::vector<std::uint8_t> m_is_shaded;
+      const std::vector<Vertex>* m_vertices;
+      Matrix m_transformation;
+      bool m_is_lit;
+
+      VertexCache(const VertexCache&) = delete;
+      VertexCache& operator =(const VertexCache&) = delete;
+  };
+
+  inline int VertexCache::get_size() const {
+    return static_cast<int>(m_indices.size());
+  }
+
+  inline const std::vector<VertexTriangle>&
+      VertexCache::get_triangles() const {
+    return m_triangles;
+  }
+
+  inline int VertexCache::get_index(int slot) const {
+    return m_indices[slot];
+  }
+
+  inline Point VertexCache::get_position(int slot) const {
+    return Ashkal::get_position(m_batch, slot);
+  }
+
+  inline void VertexCache::load(const std::vector<VertexTriangle>& triangles,
+      const std::vector<Vertex>& vertices, const Matrix& transformation,
+      const Camera& camera) {
+    if(m_slots.size() < vertices.size()) {
+      m_slots.resize(vertices.size(), -1);
+    }
+    m_indices.clear();
+    m_triangles.clear();
+    auto get_slot = [&] (int index) {
+      auto& slot = m_slots[index];
+      if(slot == -1) {
+        slot = static_cast<int>(m_indices.size());
+        m_indices.push_back(index);
+      }
+      return slot;
+    };
+    for(auto& triangle : triangles) {
+      auto a = get_slot(triangle.m_a);
+      auto b = get_slot(triangle.m_b);
+      auto c = get_slot(triangle.m_c);
+      m_triangles.push_back(VertexTriangle(a, b, c));
+    }
+    resize(m_batch, get_size());
+    for(auto i = 0; i != get_size(); ++i) {
+      auto& vertex = vertices[m_indices[i]];
+      m_slots[m_indices[i]] = -1;
+      set(m_batch, i, vertex.m_position, vertex.m_normal);
+    }
+    transform_positions(
+      m_batch, make_view_transformation(camera) * transformation);
+    m_shaded_vertices.resize(m_indices.size());
+    m_is_shaded.assign(m_indices.size(), 0);
+    m_vertices = &vertices;
+    m_transformation = transformation;
+    m_is_lit = false;
+  }
+
+  inline const ShadedVertex& VertexCache::get_shaded(
+      int slot, const Scene& scene) {
+    if(!m_is_shaded[slot]) {
+      if(!m_is_lit) {
+        shade(m_batch, m_transformation, scene);
+        m_is_lit = true;
+      }
+      m_shaded_vertices[slot] = ShadedVertex(get_position(slot),
+        (*m_vertices)[m_indices[slot]].m_uv, ShadingTerm(
+          get_light_color(scene), m_batch.m_intensity[slot]));
+      m_is_shaded[slot] = 1;
+    }
+    return m_shaded_vertices[slot];
+  }
+}
+
+#endif
@@ -0,0 +1,152 @@
+#include <array>
+#include <cmath>
+#include <memory>
+#include <doctest/doctest.h>
+#include "Ashkal/CompressedDepthBuffer.hpp"
+#include "Ashkal/SolidColorSampler.hpp"
+
+using namespace Ashkal;
+
+namespace {
+  const auto WIDTH = 36;
+  const auto HEIGHT = 28;
+
+  ShadedVertex make_vertex(float x, float y, float z) {
+    return ShadedVertex(Point(x, y, z), TextureCoordinate(0, 0),
+      ShadingTerm(Color(255, 255, 255), 1));
+  }
+
+  Material make_material(Color color) {
+    return Material(std::make_shared<SolidColorSampler>(color));
+  }
+
+  TriangleSetup make_setup(const Point& a, const Point& b, const Point& c) {
+    return *make_triangle_setup(make_vertex(a.m_x, a.m_y, a.m_z),
+      make_vertex(b.m_x, b.m_y, b.m_z), make_vertex(c.m_x, c.m_y, c.m_z),
+      Camera(static_cast<float>(WIDTH) / HEIGHT), WIDTH, HEIGHT);
+  }
+
+  bool is_equal(const CompressedDepthBuffer& depth_buffer,
+      const DepthBuffer& expected) {
+    auto decompressed = DepthBuffer(WIDTH, HEIGHT);
+    depth_buffer.decompress(decompressed);
+    for(auto y = 0; y != HEIGHT; ++y) {
+      for(auto x = 0; x != WIDTH; ++x) {
+        if(std::abs(decompressed(x, y) - expected(x, y)) > 1e-6f ||
+            decompressed(x, y) != depth_buffer(x, y)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+}
+
+TEST_SUITE("CompressedDepthBuffer") {
+  TEST_CASE("clear") {
+    auto depth_buffer = CompressedDepthBuffer(WIDTH, HEIGHT);
+    CHECK(depth_buffer.get_column_count() == 5);
+    CHECK(depth_buffer.get_row_count() == 4);
+    CHECK(depth_buffer.get_plane_count(4, 3) == 1);
+    CHECK(depth_buffer(WIDTH - 1, HEIGHT - 1) == 0);
+  }
+
+  TEST_CASE("planes") {
+    auto wall = std::array{
+      make_setup(Point(-8, -8, -4), Point(-8, 8, -4), Point(8, 8, -6)),
+      make_setup(Point(-8, -8, -4), Point(8, 8, -6), Point(8, -8, -6))};
+    auto depth_buffer = CompressedDepthBuffer(WIDTH, HEIGHT);
+    auto expected = DepthBuffer(WIDTH, HEIGHT);
+    expected.fill(0);
+    for(auto& setup : wall) {
+      rasterize_depth(setup, 0, 0, depth_buffer);
+      rasterize_depth(setup, 0, 0, expected);
+    }
+    CHECK(is_equal(depth_buffer, expected));
+    auto plane_counts = std::array<int, 3>();
+    for(auto row = 0; row != depth_buffer.get_row_count(); ++row) {
+      for(auto column = 0; column != depth_buffer.get_column_count();
+          ++column) {
+        ++plane_counts[depth_buffer.get_plane_count(column, row)];
+      }
+    }
+    CHECK(plane_counts[0] == 0);
+    CHECK(plane_counts[1] != 0);
+    CHECK(plane_counts[2] != 0);
+    auto hidden = make_setup(Point(-8, -8, -8), Point(-8, 8, -8),
+      Point(8, 8, -8));
+    rasterize_depth(hidden, 0, 0, depth_buffer);
+    CHECK(is_equal(depth_buffer, expected));
+  }
+
+  TEST_CASE("per_pixel_fallback") {
+    auto triangles = std::array{
+      make_setup(Point(-8, -8, -6), Point(-8, 8, -6), Point(8, 8, -6)),
+      make_setup(Point(-8, -8, -5), Point(0, 8, -4), Point(8, -8, -5)),
+      make_setup(Point(-1, -8, -3), Point(-1, 8, -3), Point(8, 0, -5))};
+    auto depth_buffer = CompressedDepthBuffer(WIDTH, HEIGHT);
+    auto expected = DepthBuffer(WIDTH, HEIGHT);
+    expected.fill(0);
+    for(auto& setup : triangles) {
+      rasterize_depth(setup, 0, 0, depth_buffer);
+      rasterize_depth(setup, 0, 0, expected);
+    }
+    CHECK(is_equal(depth_buffer, expected));
+    auto raw_count = 0;
+    for(auto row = 0; row != depth_buffer.get_row_count(); ++row) {
+      for(auto column = 0; column != depth_buffer.get_column_count();
+          ++column) {
+        raw_count += depth_buffer.get_plane_count(column, row) == 0;
+      }
+    }
+    CHECK(raw_count != 0);
+    auto cover = make_setup(Point(-20, -20, -2), Point(-20, 40, -2),
+      Point(40, -20, -2));
+    rasterize_depth(cover, 0, 0, depth_buffer);
+    rasterize_depth(cover, 0, 0, expected);
+    CHECK(is_equal(depth_buffer, expected));
+    auto is_compressed = true;
+    for(auto row = 0; row != depth_buffer.get_row_count(); ++row) {
+      for(auto column = 0; column != depth_buffer.get_column_count();
+          ++column) {
+        is_compressed =
+          is_compressed && depth_buffer.get_plane_count(column, row) == 1;
+      }
+    }
+    CHECK(is_compressed);
+    depth_buffer.clear();
+    CHECK(depth_buffer.get_plane_count(2, 2) == 1);
+    CHECK(depth_buffer(WIDTH / 2, HEIGHT / 2) == 0);
+  }
+
+  TEST_CASE("shading") {
+    auto triangles = std::array{
+      make_setup(Point(-8, -8, -6), Point(-8, 8, -6), Point(8, 8, -6)),
+      make_setup(Point(-3, -3, -4), Point(0, 3, -4), Point(3, -3, -4)),
+      make_setup(Point(-8, -8, -9), Point(8, 8, -9), Point(8, -8, -9))};
+    auto materials = std::array{make_material(Color(255, 0, 0)),
+      make_material(Color(0, 255, 0)), make_material(Color(0, 0, 255))};
+    auto frame_buffer = FrameBuffer(WIDTH, HEIGHT);
+    frame_buffer.fill(Color(0));
+    auto depth_buffer = CompressedDepthBuffer(WIDTH, HEIGHT);
+    auto expected_frame_buffer = FrameBuffer(WIDTH, HEIGHT);
+    expected_frame_buffer.fill(Color(0));
+    auto expected_depth_buffer = DepthBuffer(WIDTH, HEIGHT);
+    expected_depth_buffer.fill(0);
+    for(auto i = 0; i != 3; ++i) {
+      rasterize(triangles[i], materials[i], 0, 0, frame_buffer, depth_buffer);
+      rasterize(triangles[i], materials[i], 0, 0, expected_frame_buffer,
+        expected_depth_buffer);
+    }
+    auto is_identical = true;
+    for(auto y = 0; y != HEIGHT; ++y) {
+      for(auto x = 0; x != WIDTH; ++x) {
+        is_identical =
+          is_identical && frame_buffer(x, y) == expected_frame_buffer(x, y);
+      }
+    }
+    CHECK(is_identical);
+    CHECK(is_equal(depth_buffer, expected_depth_buffer));
+    CHECK(frame_buffer(WIDTH / 2, HEIGHT / 2) == Color(0, 255, 0));
+  }
+}
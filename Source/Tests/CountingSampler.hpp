@@ -0,0 +1,26 @@
+#ifndef ASHKAL_COUNTING_SAMPLER_HPP
+#define ASHKAL_COUNTING_SAMPLER_HPP
+#include <atomic>
+#include "Ashkal/ColorSampler.hpp"
+
+namespace Ashkal {
+
+  /**
+   * A ColorSampler returning a solid color that counts the number of times it
+   * is sampled, so that tests can measure how often a triangle is shaded.
+   * The count is atomic so that it can be sampled from multiple threads.
+   */
+  class CountingSampler : public ColorSampler {
+    public:
+
+      /** The number of times the sampler has been sampled. */
+      mutable std::atomic<int> m_count = 0;
+
+      Color sample(const TextureCoordinate&) const override {
+        ++m_count;
+        return Color(0, 255, 0);
+      }
+  };
+}
+
+#endif
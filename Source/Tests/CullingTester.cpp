@@ -0,0 +1,51 @@
+#include <doctest/doctest.h>
+#include "Ashkal/Camera.hpp"
+#include "Ashkal/Culling.hpp"
+
+using namespace Ashkal;
+
+TEST_SUITE("Culling") {
+  TEST_CASE("facing") {
+    auto a = Point(-1, -1, -2);
+    auto b = Point(0, 1, -2);
+    auto c = Point(1, -1, -2);
+    CHECK(get_facing(a, b, c) > 0);
+    CHECK(get_facing(a, c, b) < 0);
+    CHECK(get_facing(a, b, Point(1, 3, -2)) == 0);
+  }
+
+  TEST_CASE("back_face") {
+    auto camera = Camera(1);
+    auto& frustum = camera.get_local_frustum();
+    auto a = Point(-1, -1, -2);
+    auto b = Point(0, 1, -2);
+    auto c = Point(1, -1, -2);
+    CHECK(cull(a, b, c, frustum, CullMode::BACK, false) ==
+      CullResult::FRONT_FACING);
+    CHECK(cull(a, c, b, frustum, CullMode::BACK, false) == CullResult::CULLED);
+    CHECK(cull(a, c, b, frustum, CullMode::BACK, true) ==
+      CullResult::BACK_FACING);
+    CHECK(cull(a, c, b, frustum, CullMode::NONE, false) ==
+      CullResult::BACK_FACING);
+    CHECK(cull(a, b, c, frustum, CullMode::FRONT, false) ==
+      CullResult::CULLED);
+  }
+
+  TEST_CASE("degenerate") {
+    auto camera = Camera(1);
+    CHECK(cull(Point(-1, -1, -2), Point(0, 0, -2), Point(1, 1, -2),
+      camera.get_local_frustum(), CullMode::NONE, true) ==
+        CullResult::CULLED);
+  }
+
+  TEST_CASE("outside_frustum") {
+    auto camera = Camera(1);
+    auto& frustum = camera.get_local_frustum();
+    CHECK(cull(Point(9, -1, -2), Point(10, 1, -2), Point(11, -1, -2), frustum,
+      CullMode::BACK, false) == CullResult::CULLED);
+    CHECK(cull(Point(-1, -1, 2), Point(0, 1, 2), Point(1, -1, 2), frustum,
+      CullMode::NONE, false) == CullResult::CULLED);
+    CHECK(cull(Point(-1, -1, -2), Point(0, 1, -2), Point(9, -1, -2), frustum,
+      CullMode::BACK, false) == CullResult::FRONT_FACING);
+  }
+}
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <doctest/doctest.h>
+#include "Ashkal/DepthFormat.hpp"
+#include "Ashkal/SolidColorSampler.hpp"
+
+using namespace Ashkal;
+
+namespace {
+  const auto WIDTH = 32;
+  const auto HEIGHT = 32;
+
+  ShadedVertex make_vertex(float x, float y, float z) {
+    return ShadedVertex(Point(x, y, z), TextureCoordinate(0, 0),
+      ShadingTerm(Color(255, 255, 255), 1));
+  }
+
+  Material make_material(Color color) {
+    return Material(std::make_shared<SolidColorSampler>(color));
+  }
+
+  template<typename T>
+  FrameBuffer render(Raster<T>& depth_buffer, const Camera& camera) {
+    auto range = make_depth_range(camera);
+    auto frame_buffer = FrameBuffer(WIDTH, HEIGHT);
+    frame_buffer.fill(Color(0));
+    auto near_material = make_material(Color(255, 0, 0));
+    auto far_material = make_material(Color(0, 0, 255));
+    auto near_triangle = make_triangle_setup(make_vertex(-3, -3, -4),
+      make_vertex(0, 3, -4), make_vertex(3, -3, -4), camera, WIDTH, HEIGHT);
+    auto far_triangle = make_triangle_setup(make_vertex(-6, -2, -4.5f),
+      make_vertex(-6, 6, -4.5f), make_vertex(6, 2, -6), camera, WIDTH,
+      HEIGHT);
+    rasterize(*near_triangle, near_material, 0, 0, frame_buffer, depth_buffer,
+      range);
+    rasterize(*far_triangle, far_material, 0, 0, frame_buffer, depth_buffer,
+      range);
+    return frame_buffer;
+  }
+}
+
+TEST_SUITE("DepthFormat") {
+  TEST_CASE("depth_range") {
+    auto camera = Camera(1);
+    auto range = make_depth_range(camera);
+    auto near_inverse_z = -1 / (camera.get_near_plane() - 1);
+    auto far_inverse_z = -1 / (camera.get_far_plane() - 1);
+    auto quantize_one = [&] (float inverse_z, int maximum) {
+      auto values = std::array<std::int32_t, LANE_COUNT>();
+      store(quantize(range, inverse_z, maximum), values.data());
+      return values[0];
+    };
+    CHECK(quantize_one(near_inverse_z, DEPTH16_MAX) == DEPTH16_MAX);
+    CHECK(quantize_one(far_inverse_z, DEPTH16_MAX) == 0);
+    CHECK(quantize_one(2 * near_inverse_z, DEPTH24_MAX) == DEPTH24_MAX);
+    CHECK(quantize_one(0, DEPTH24_MAX) == 0);
+    CHECK(quantize_one(0.2f, DEPTH16_MAX) > quantize_one(0.19f, DEPTH16_MAX));
+    auto depth16 =
+      static_cast<std::uint16_t>(quantize_one(0.2f, DEPTH16_MAX));
+    CHECK(to_inverse_z(range, depth16) == doctest::Approx(0.2f).epsilon(1e-4));
+    auto depth24 = static_cast<std::uint32_t>(
+      quantize_one(0.2f, DEPTH24_MAX) << STENCIL_BITS);
+    CHECK(to_inverse_z(range, depth24) == doctest::Approx(0.2f).epsilon(1e-6));
+  }
+
+  TEST_CASE("stencil") {
+    auto depths = std::array<std::uint32_t, LANE_COUNT>();
+    depths.fill(set_stencil(0, 5));
+    CHECK(get_stencil(depths[0]) == 5);
+    auto range = make_depth_range(Camera(1));
+    auto mask =
+      test_depth(FloatLanes(0.2f), to_mask(0b1), 2, range, depths.data());
+    CHECK(to_bits(mask) == 0b1);
+    CHECK(depths[0] >> STENCIL_BITS != 0);
+    CHECK(get_stencil(depths[0]) == 5);
+    CHECK(depths[1] == set_stencil(0, 5));
+    mask = test_depth(FloatLanes(0.1f), to_mask(0b11), 2, range, depths.data());
+    CHECK(to_bits(mask) == 0b10);
+    CHECK(get_stencil(set_stencil(depths[0], 9)) == 9);
+    CHECK(set_stencil(depths[0], 9) >> STENCIL_BITS ==
+      depths[0] >> STENCIL_BITS);
+  }
+
+  TEST_CASE("formats") {
+    auto camera = Camera(1);
+    auto depth_buffer = DepthBuffer(WIDTH, HEIGHT);
+    depth_buffer.fill(0);
+    auto expected = render(depth_buffer, camera);
+    auto depth16_buffer = Depth16Buffer(WIDTH, HEIGHT);
+    depth16_buffer.fill(0);
+    auto depth16_frame = render(depth16_buffer, camera);
+    auto depth24_buffer = Depth24Buffer(WIDTH, HEIGHT);
+    depth24_buffer.fill(0);
+    auto depth24_frame = render(depth24_buffer, camera);
+    auto range = make_depth_range(camera);
+    auto is_identical = true;
+    for(auto y = 0; y != HEIGHT; ++y) {
+      for(auto x = 0; x != WIDTH; ++x) {
+        is_identical = is_identical &&
+          depth16_frame(x, y) == expected(x, y) &&
+          depth24_frame(x, y) == expected(x, y) &&
+          std::abs(to_inverse_z(range, depth16_buffer(x, y)) -
+            std::max(depth_buffer(x, y), range.m_far_inverse_z)) < 1e-4f;
+      }
+    }
+    CHECK(is_identical);
+    CHECK(expected(WIDTH / 2, HEIGHT / 2) == Color(255, 0, 0));
+    CHECK(expected(2, 8) == Color(0, 0, 255));
+  }
+}
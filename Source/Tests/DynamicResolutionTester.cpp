@@ -0,0 +1,90 @@
+#include <chrono>
+#include <doctest/doctest.h>
+#include "Ashkal/DynamicResolution.hpp"
+
+using namespace Ashkal;
+using namespace std::chrono_literals;
+
+TEST_SUITE("DynamicResolution") {
+  TEST_CASE("upscale_same_size") {
+    auto source = FrameBuffer(13, 5);
+    for(auto y = 0; y != source.get_height(); ++y) {
+      for(auto x = 0; x != source.get_width(); ++x) {
+        source(x, y) = Color(x * 19, y * 50, 7, 255);
+      }
+    }
+    auto destination = FrameBuffer(13, 5);
+    upscale(source, destination);
+    auto is_identical = true;
+    for(auto y = 0; y != source.get_height(); ++y) {
+      for(auto x = 0; x != source.get_width(); ++x) {
+        is_identical = is_identical && destination(x, y) == source(x, y);
+      }
+    }
+    CHECK(is_identical);
+  }
+
+  TEST_CASE("upscale_bilinear") {
+    auto source = FrameBuffer(2, 1);
+    source(0, 0) = Color(255, 0, 0, 255);
+    source(1, 0) = Color(0, 0, 255, 255);
+    auto destination = FrameBuffer(8, 2);
+    upscale(source, destination);
+    CHECK(destination(0, 0) == Color(255, 0, 0, 255));
+    CHECK(destination(7, 1) == Color(0, 0, 255, 255));
+    CHECK(destination(3, 0) == destination(3, 1));
+    CHECK(destination(3, 0).get_red() > destination(3, 0).get_blue());
+    CHECK(destination(4, 0).get_red() < destination(4, 0).get_blue());
+    CHECK(destination(3, 0).get_red() + destination(3, 0).get_blue() >= 254);
+    CHECK(destination(3, 0).get_alpha() == 255);
+  }
+
+  TEST_CASE("scale_bounds") {
+    auto resolution = DynamicResolution(640, 480, 10ms, 0.5f, 1);
+    CHECK(resolution.get_scale() == 1);
+    CHECK(resolution.get_min_scale() == 0.5f);
+    CHECK(resolution.get_max_scale() == 1);
+    CHECK(resolution.get_render_width() == 640);
+    CHECK(resolution.get_render_height() == 480);
+    for(auto i = 0; i != 20; ++i) {
+      resolution.update(100ms);
+    }
+    CHECK(resolution.get_scale() == 0.5f);
+    CHECK(resolution.get_render_width() == 320);
+    CHECK(resolution.get_render_height() == 240);
+    for(auto i = 0; i != 20; ++i) {
+      resolution.update(1ms);
+    }
+    CHECK(resolution.get_scale() == 1);
+  }
+
+  TEST_CASE("target_frame_time") {
+    auto resolution = DynamicResolution(640, 480, 10ms, 0.25f, 1);
+    for(auto i = 0; i != 40; ++i) {
+      // Simulates a frame time proportional to the number of pixels rendered.
+      auto scale = resolution.get_scale();
+      resolution.update(20ms * scale * scale);
+    }
+    auto scale = resolution.get_scale();
+    CHECK(20ms * scale * scale <= 10ms);
+    CHECK(scale >= 0.5f);
+  }
+
+  TEST_CASE("render") {
+    auto resolution = DynamicResolution(64, 32, 1h, 0.5f, 0.5f);
+    auto frame_buffer = FrameBuffer(64, 32);
+    auto width = 0;
+    auto height = 0;
+    resolution.render([&] (FrameBuffer& frame_buffer,
+        DepthBuffer& depth_buffer) {
+      width = frame_buffer.get_width();
+      height = depth_buffer.get_height();
+      frame_buffer.fill(Color(0, 255, 0, 255));
+    }, frame_buffer);
+    CHECK(width == 32);
+    CHECK(height == 16);
+    CHECK(frame_buffer(0, 0) == Color(0, 255, 0, 255));
+    CHECK(frame_buffer(63, 31) == Color(0, 255, 0, 255));
+    CHECK(&resolution.get_frame_buffer() == &resolution.get_frame_buffer());
+  }
+}
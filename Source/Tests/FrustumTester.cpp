@@ -61,6 +61,17 @@ TEST_SUITE("Frustum") {
     CHECK(intersects(frustum, box));
   }
 
+  TEST_CASE("contains") {
+    auto camera = Camera(1);
+    auto& frustum = camera.get_frustum();
+    CHECK(contains(
+      frustum, BoundingBox(Point(-0.1f, -0.1f, 2), Point(0.1f, 0.1f, 3))));
+    CHECK(!contains(
+      frustum, BoundingBox(Point(-1, -0.5f, 1), Point(2, 0.5f, 3))));
+    CHECK(!contains(frustum,
+      BoundingBox(Point(-0.5f, -0.5f, -0.05f), Point(0.5f, 0.5f, 0.05f))));
+  }
+
   TEST_CASE("near_plane_maps_to_screen") {
     auto width  = 800;
     auto height = 600;
@@ -0,0 +1,38 @@
+#include <doctest/doctest.h>
+#include "Ashkal/HierarchicalDepthBuffer.hpp"
+
+using namespace Ashkal;
+
+TEST_SUITE("HierarchicalDepthBuffer") {
+  TEST_CASE("construct") {
+    auto buffer = HierarchicalDepthBuffer(20, 12);
+    CHECK(buffer.get_width() == 20);
+    CHECK(buffer.get_height() == 12);
+    CHECK(buffer.get_farthest(0, 0, 19, 11) == 0);
+  }
+
+  TEST_CASE("build") {
+    auto depth_buffer = DepthBuffer(20, 12);
+    depth_buffer.fill(0.5f);
+    depth_buffer(3, 2) = 0.25f;
+    depth_buffer(19, 11) = 0.75f;
+    auto buffer = HierarchicalDepthBuffer(20, 12);
+    buffer.build(depth_buffer);
+    CHECK(buffer.get_farthest(0, 0, 7, 7) == 0.25f);
+    CHECK(buffer.get_farthest(8, 0, 15, 7) == 0.5f);
+    CHECK(buffer.get_farthest(16, 8, 19, 11) == 0.5f);
+    CHECK(buffer.get_farthest(7, 0, 8, 0) == 0.25f);
+    depth_buffer.fill(0.75f);
+    buffer.build(depth_buffer);
+    CHECK(buffer.get_farthest(16, 8, 19, 11) == 0.75f);
+  }
+
+  TEST_CASE("raise") {
+    auto buffer = HierarchicalDepthBuffer(16, 16);
+    buffer.raise(9, 1, 0.5f);
+    CHECK(buffer.get_farthest(8, 0, 15, 7) == 0.5f);
+    CHECK(buffer.get_farthest(0, 0, 15, 7) == 0);
+    buffer.raise(9, 1, 0.25f);
+    CHECK(buffer.get_farthest(8, 0, 15, 7) == 0.5f);
+  }
+}
@@ -0,0 +1,113 @@
+#include <array>
+#include <cstdint>
+#include <doctest/doctest.h>
+#include "Ashkal/Lanes.hpp"
+
+using namespace Ashkal;
+
+namespace {
+  std::array<float, LANE_COUNT> to_array(FloatLanes lanes) {
+    auto values = std::array<float, LANE_COUNT>();
+    store(lanes, values.data());
+    return values;
+  }
+
+  std::array<std::int32_t, LANE_COUNT> to_array(IntLanes lanes) {
+    auto values = std::array<std::int32_t, LANE_COUNT>();
+    store(lanes, values.data());
+    return values;
+  }
+}
+
+TEST_SUITE("Lanes") {
+  TEST_CASE("ramp") {
+    auto ramp = to_array(make_ramp());
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      CHECK(ramp[i] == i);
+    }
+  }
+
+  TEST_CASE("arithmetic") {
+    auto ramp = make_ramp();
+    auto values = to_array((ramp + 1.f) * 2.f - ramp / 2.f);
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      CHECK(values[i] == doctest::Approx((i + 1) * 2 - i / 2.f));
+    }
+    auto minimum = to_array(min(ramp, FloatLanes(2)));
+    auto maximum = to_array(max(ramp, FloatLanes(2)));
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      CHECK(minimum[i] == std::min<float>(i, 2));
+      CHECK(maximum[i] == std::max<float>(i, 2));
+    }
+    auto roots = to_array(sqrt(ramp * ramp));
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      CHECK(roots[i] == doctest::Approx(i));
+    }
+  }
+
+  TEST_CASE("masks") {
+    auto ramp = make_ramp();
+    CHECK(to_bits(ramp < 2.f) == 0b11);
+    CHECK(to_bits(ramp <= 2.f) == 0b111);
+    CHECK(to_bits(ramp >= 1.f) == ((1 << LANE_COUNT) - 2));
+    CHECK(to_bits(ramp == 1.f) == 0b10);
+    CHECK(to_bits(make_mask(3)) == 0b111);
+    CHECK(to_bits(make_mask(LANE_COUNT)) == (1 << LANE_COUNT) - 1);
+    CHECK(to_bits((ramp < 2.f) | (ramp > 2.f)) == ((1 << LANE_COUNT) - 1 - 4));
+    CHECK(to_bits((ramp < 2.f) & (ramp > 0.f)) == 0b10);
+    CHECK(to_bits(to_mask(0b101)) == 0b101);
+    CHECK(to_bits(to_mask(0)) == 0);
+    CHECK(to_bits(to_mask((1 << LANE_COUNT) - 1)) == (1 << LANE_COUNT) - 1);
+    auto selected = to_array(select(ramp < 2.f, ramp, FloatLanes(-1)));
+    CHECK(selected[0] == 0);
+    CHECK(selected[1] == 1);
+    CHECK(selected[2] == -1);
+  }
+
+  TEST_CASE("partial_load_store") {
+    auto values = std::array<float, LANE_COUNT>();
+    values.fill(5);
+    store(make_ramp(), values.data(), 2);
+    CHECK(values[0] == 0);
+    CHECK(values[1] == 1);
+    CHECK(values[2] == 5);
+    auto loaded = to_array(load(values.data(), 1));
+    CHECK(loaded[0] == 0);
+    CHECK(loaded[1] == 0);
+  }
+
+  TEST_CASE("integers") {
+    auto ramp = to_int(make_ramp() + 0.75f);
+    auto values = to_array(((ramp * 3 + 1) << 4) >> 2);
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      CHECK(values[i] == (i * 3 + 1) * 4);
+    }
+    CHECK(to_array(IntLanes(-1) >> 28)[0] == 0xF);
+    CHECK(to_array(IntLanes(0xF0F) & 0xFF)[0] == 0xF);
+    CHECK(to_bits(ramp < IntLanes(1)) == 0b1);
+    CHECK(to_bits(ramp <= IntLanes(1)) == 0b11);
+    CHECK(to_array(to_float(IntLanes(-3)))[0] == -3);
+    auto selected = to_array(select(ramp >= IntLanes(1), IntLanes(7), ramp));
+    CHECK(selected[0] == 0);
+    CHECK(selected[1] == 7);
+  }
+
+  TEST_CASE("unsigned_16_bit") {
+    auto values = std::array<std::uint16_t, LANE_COUNT>();
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      values[i] = static_cast<std::uint16_t>(65535 - i);
+    }
+    auto loaded = to_array(load(values.data(), LANE_COUNT));
+    CHECK(loaded[0] == 65535);
+    CHECK(loaded[LANE_COUNT - 1] == 65536 - LANE_COUNT);
+    CHECK(to_array(load(values.data(), 1))[1] == 0);
+    auto ramp = to_int(make_ramp()) * 9000;
+    store(ramp + 1, values.data(), LANE_COUNT);
+    for(auto i = 0; i != LANE_COUNT; ++i) {
+      CHECK(values[i] == i * 9000 + 1);
+    }
+    store(IntLanes(7), values.data(), 2);
+    CHECK(values[1] == 7);
+    CHECK(values[2] == 18001);
+  }
+}
@@ -255,4 +255,12 @@ TEST_SUITE("Matrix") {
     CHECK(result.m_y == doctest::Approx(0));
     CHECK(result.m_z == doctest::Approx(0));
   }
+
+  TEST_CASE("is_mirroring") {
+    CHECK(!is_mirroring(Matrix::IDENTITY()));
+    CHECK(!is_mirroring(translate(Vector(1, 2, 3)) * yaw(1) * scale(2)));
+    CHECK(is_mirroring(scale_x(-1)));
+    CHECK(is_mirroring(yaw(1) * scale_z(-2)));
+    CHECK(!is_mirroring(scale_x(-1) * scale_y(-1)));
+  }
 }
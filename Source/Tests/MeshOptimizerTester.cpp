@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <tuple>
+#include <doctest/doctest.h>
+#include "Ashkal/MeshOptimizer.hpp"
+#include "Ashkal/SolidColorSampler.hpp"
+
+using namespace Ashkal;
+
+namespace {
+  const auto GRID_SIZE = 24;
+
+  using Corner = std::tuple<float, float, float>;
+
+  Vertex make_vertex(float x, float y, float z) {
+    return Vertex(Point(x, y, z), TextureCoordinate(0, 0), Vector(0, 0, 1));
+  }
+
+  std::shared_ptr<Material> make_material() {
+    return std::make_shared<Material>(
+      std::make_shared<SolidColorSampler>(Color(255, 255, 255)));
+  }
+
+  Mesh make_grid() {
+    auto vertices = std::vector<Vertex>();
+    for(auto y = 0; y <= GRID_SIZE; ++y) {
+      for(auto x = 0; x <= GRID_SIZE; ++x) {
+        vertices.push_back(make_vertex(static_cast<float>(x),
+          static_cast<float>(y), 0));
+      }
+    }
+    auto triangles = std::vector<VertexTriangle>();
+    for(auto y = 0; y != GRID_SIZE; ++y) {
+      for(auto x = 0; x != GRID_SIZE; ++x) {
+        auto a = x + (GRID_SIZE + 1) * y;
+        auto b = a + 1;
+        auto c = a + GRID_SIZE + 2;
+        auto d = a + GRID_SIZE + 1;
+        triangles.push_back({a, b, c});
+        triangles.push_back({a, c, d});
+      }
+    }
+
+    // Scatters the triangles so that neighbouring triangles are drawn far
+    // apart, defeating the cache.
+    auto scattered = std::vector<VertexTriangle>();
+    auto count = static_cast<int>(triangles.size());
+    for(auto i = 0; i != count; ++i) {
+      scattered.push_back(triangles[(i * 97) % count]);
+    }
+    return Mesh(std::move(vertices),
+      MeshNode(Fragment(std::move(scattered), make_material())));
+  }
+
+  std::vector<Corner> get_corners(const Mesh& mesh) {
+    auto corners = std::vector<Corner>();
+    for_each_fragment(mesh.m_root,
+      [&] (const std::vector<VertexTriangle>& triangles) {
+        for(auto& triangle : triangles) {
+          for(auto index : {triangle.m_a, triangle.m_b, triangle.m_c}) {
+            auto& position = mesh.m_vertices[index].m_position;
+            corners.emplace_back(position.m_x, position.m_y, position.m_z);
+          }
+        }
+      });
+    return corners;
+  }
+
+  std::vector<std::array<Corner, 3>> get_sorted_triangles(const Mesh& mesh) {
+    auto corners = get_corners(mesh);
+    auto triangles = std::vector<std::array<Corner, 3>>();
+    for(auto i = std::size_t(0); i != corners.size(); i += 3) {
+      triangles.push_back({corners[i], corners[i + 1], corners[i + 2]});
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+  }
+}
+
+TEST_SUITE("MeshOptimizer") {
+  TEST_CASE("cache_misses") {
+    auto triangles = std::vector<VertexTriangle>();
+    triangles.push_back({0, 1, 2});
+    triangles.push_back({2, 1, 3});
+    triangles.push_back({4, 5, 0});
+    CHECK(count_cache_misses(triangles, 6, 16) == 6);
+    CHECK(count_cache_misses(triangles, 6, 3) == 7);
+  }
+
+  TEST_CASE("compact_vertices") {
+    auto triangles = std::vector<VertexTriangle>();
+    triangles.push_back({7, 3, 9});
+    triangles.push_back({9, 3, 1});
+    auto remapping = std::vector<int>(10, -1);
+    auto indices = std::vector<int>();
+    auto compacted = compact_vertices(triangles, remapping, indices);
+    REQUIRE(compacted.size() == 2);
+    CHECK(compacted[0].m_a == 0);
+    CHECK(compacted[0].m_b == 1);
+    CHECK(compacted[0].m_c == 2);
+    CHECK(compacted[1].m_a == 2);
+    CHECK(compacted[1].m_b == 1);
+    CHECK(compacted[1].m_c == 3);
+    CHECK(indices == std::vector{7, 3, 9, 1});
+    CHECK(std::count(remapping.begin(), remapping.end(), -1) == 10);
+  }
+
+  TEST_CASE("vertex_cache") {
+    auto mesh = make_grid();
+    auto& triangles = mesh.m_root.as_fragment().get_triangles();
+    auto vertex_count = static_cast<int>(mesh.m_vertices.size());
+    auto optimized =
+      optimize_vertex_cache(triangles, vertex_count, VERTEX_CACHE_SIZE);
+    REQUIRE(optimized.size() == triangles.size());
+    auto misses =
+      count_cache_misses(triangles, vertex_count, VERTEX_CACHE_SIZE);
+    auto optimized_misses =
+      count_cache_misses(optimized, vertex_count, VERTEX_CACHE_SIZE);
+    CHECK(optimized_misses < misses / 2);
+    auto acmr = static_cast<float>(optimized_misses) /
+      static_cast<float>(optimized.size());
+    CHECK(acmr < 1);
+  }
+
+  TEST_CASE("overdraw") {
+    auto vertices = std::vector<Vertex>();
+    vertices.push_back(make_vertex(0, 0, 0));
+    vertices.push_back(make_vertex(1, 0, 0));
+    vertices.push_back(make_vertex(1, 1, 0));
+    vertices.push_back(make_vertex(0, 1, 0));
+    vertices.push_back(make_vertex(0, 0, 1));
+    vertices.push_back(make_vertex(1, 0, 1));
+    vertices.push_back(make_vertex(1, 1, 1));
+    vertices.push_back(make_vertex(0, 1, 1));
+    auto triangles = std::vector<VertexTriangle>();
+    triangles.push_back({0, 1, 2});
+    triangles.push_back({0, 2, 3});
+    triangles.push_back({4, 5, 6});
+    triangles.push_back({4, 6, 7});
+    CHECK(calculate_overdraw(triangles, vertices) == doctest::Approx(2));
+    auto optimized =
+      optimize_overdraw(triangles, vertices, VERTEX_CACHE_SIZE, 1.05f);
+    REQUIRE(optimized.size() == 4);
+    CHECK(optimized[0].m_a == 4);
+    CHECK(optimized[2].m_a == 0);
+    CHECK(calculate_overdraw(optimized, vertices) == doctest::Approx(1));
+  }
+
+  TEST_CASE("vertex_fetch") {
+    auto vertices = std::vector<Vertex>();
+    for(auto i = 0; i != 5; ++i) {
+      vertices.push_back(make_vertex(static_cast<float>(i), 0, 0));
+    }
+    auto triangles = std::vector<VertexTriangle>();
+    triangles.push_back({3, 1, 4});
+    auto other_triangles = std::vector<VertexTriangle>();
+    other_triangles.push_back({4, 0, 3});
+    auto children = std::vector<MeshNode>();
+    children.emplace_back(Fragment(std::move(triangles), make_material()));
+    children.emplace_back(
+      Fragment(std::move(other_triangles), make_material()));
+    auto mesh = Mesh(std::move(vertices), MeshNode(std::move(children)));
+    auto corners = get_corners(mesh);
+    optimize_vertex_fetch(mesh);
+    CHECK(get_corners(mesh) == corners);
+    REQUIRE(mesh.m_vertices.size() == 5);
+    CHECK(mesh.m_vertices[0].m_position.m_x == 3);
+    CHECK(mesh.m_vertices[1].m_position.m_x == 1);
+    CHECK(mesh.m_vertices[2].m_position.m_x == 4);
+    CHECK(mesh.m_vertices[3].m_position.m_x == 0);
+    CHECK(mesh.m_vertices[4].m_position.m_x == 2);
+    auto& second = mesh.m_root.as_chunk()[1].as_fragment().get_triangles();
+    CHECK(second[0].m_a == 2);
+    CHECK(second[0].m_b == 3);
+    CHECK(second[0].m_c == 0);
+  }
+
+  TEST_CASE("optimize") {
+    auto mesh = make_grid();
+    auto triangles = get_sorted_triangles(mesh);
+    auto before = analyze(mesh, VERTEX_CACHE_SIZE);
+    optimize(mesh);
+    auto after = analyze(mesh, VERTEX_CACHE_SIZE);
+    CHECK(after.m_acmr < before.m_acmr);
+    CHECK(after.m_acmr < 1);
+    CHECK(after.m_overdraw == doctest::Approx(before.m_overdraw));
+    CHECK(get_sorted_triangles(mesh) == triangles);
+  }
+}
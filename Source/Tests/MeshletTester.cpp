@@ -0,0 +1,105 @@
+#include <memory>
+#include <doctest/doctest.h>
+#include "Ashkal/MeshOptimizer.hpp"
+#include "Ashkal/SolidColorSampler.hpp"
+
+using namespace Ashkal;
+
+namespace {
+  Vertex make_vertex(float x, float y, float z) {
+    return Vertex(Point(x, y, z), TextureCoordinate(0, 0), Vector(0, 0, 1));
+  }
+
+  std::vector<Vertex> make_grid_vertices(int size) {
+    auto vertices = std::vector<Vertex>();
+    for(auto y = 0; y <= size; ++y) {
+      for(auto x = 0; x <= size; ++x) {
+        vertices.push_back(
+          make_vertex(static_cast<float>(x), static_cast<float>(y), 0));
+      }
+    }
+    return vertices;
+  }
+
+  std::vector<VertexTriangle> make_grid_triangles(int size) {
+    auto triangles = std::vector<VertexTriangle>();
+    for(auto y = 0; y != size; ++y) {
+      for(auto x = 0; x != size; ++x) {
+        auto a = x + (size + 1) * y;
+        auto b = a + 1;
+        auto c = a + size + 2;
+        auto d = a + size + 1;
+        triangles.push_back({a, b, c});
+        triangles.push_back({a, c, d});
+      }
+    }
+    return triangles;
+  }
+}
+
+TEST_SUITE("Meshlet") {
+  TEST_CASE("make_meshlets") {
+    auto vertices = make_grid_vertices(16);
+    auto triangles = make_grid_triangles(16);
+    auto meshlets = make_meshlets(triangles, vertices);
+    REQUIRE(meshlets.size() == 4);
+    for(auto i = 0; i != 4; ++i) {
+      auto& meshlet = meshlets[i];
+      CHECK(meshlet.m_offset == i * MAX_MESHLET_TRIANGLES);
+      CHECK(meshlet.m_count == MAX_MESHLET_TRIANGLES);
+      CHECK(meshlet.m_bounding_box.get_minimum() ==
+        Point(0, static_cast<float>(4 * i), 0));
+      CHECK(meshlet.m_bounding_box.get_maximum() ==
+        Point(16, static_cast<float>(4 * i + 4), 0));
+      CHECK(meshlet.m_cone_axis == Vector(0, 0, 1));
+      CHECK(meshlet.m_cone_cutoff == doctest::Approx(0));
+    }
+    CHECK(make_meshlets({}, vertices).empty());
+  }
+
+  TEST_CASE("split_on_facing") {
+    auto vertices = make_grid_vertices(8);
+    auto triangles = make_grid_triangles(8);
+    triangles.resize(MIN_MESHLET_TRIANGLES);
+    for(auto& triangle : make_grid_triangles(8)) {
+      triangles.push_back({triangle.m_a, triangle.m_c, triangle.m_b});
+    }
+    auto meshlets = make_meshlets(triangles, vertices);
+    REQUIRE(meshlets.size() == 2);
+    CHECK(meshlets[0].m_count == MIN_MESHLET_TRIANGLES);
+    CHECK(meshlets[0].m_cone_axis == Vector(0, 0, 1));
+    CHECK(meshlets[1].m_offset == MIN_MESHLET_TRIANGLES);
+    CHECK(meshlets[1].m_cone_axis == Vector(0, 0, -1));
+  }
+
+  TEST_CASE("facing") {
+    auto vertices = make_grid_vertices(4);
+    auto triangles = make_grid_triangles(4);
+    auto meshlet = make_meshlet(triangles, vertices, 0, 32);
+    CHECK(is_back_facing(meshlet, Point(2, 2, -10)));
+    CHECK(!is_front_facing(meshlet, Point(2, 2, -10)));
+    CHECK(is_front_facing(meshlet, Point(2, 2, 10)));
+    CHECK(!is_back_facing(meshlet, Point(2, 2, 10)));
+    CHECK(!is_back_facing(meshlet, Point(2, 2, -1)));
+    CHECK(!is_back_facing(meshlet, Point(100, 2, -0.5f)));
+    vertices.push_back(make_vertex(0, 0, 1));
+    triangles.push_back({0, 25, 1});
+    auto folded = make_meshlet(triangles, vertices, 0, 33);
+    CHECK(folded.m_cone_cutoff == 1);
+    CHECK(!is_back_facing(folded, Point(2, 2, -10)));
+  }
+
+  TEST_CASE("build_meshlets") {
+    auto triangles = make_grid_triangles(16);
+    auto mesh = Mesh(make_grid_vertices(16),
+      MeshNode(Fragment(triangles, std::make_shared<Material>(
+        std::make_shared<SolidColorSampler>(Color(255, 255, 255))))));
+    build_meshlets(mesh);
+    auto& fragment = mesh.m_root.as_fragment();
+    CHECK(fragment.get_meshlets().size() == 4);
+    optimize_vertex_fetch(mesh);
+    CHECK(mesh.m_root.as_fragment().get_meshlets().size() == 4);
+    optimize(mesh);
+    CHECK(mesh.m_root.as_fragment().get_meshlets().empty());
+  }
+}
@@ -0,0 +1,66 @@
+#include <doctest/doctest.h>
+#include "Ashkal/OcclusionBuffer.hpp"
+
+using namespace Ashkal;
+
+namespace {
+  OcclusionBuffer make_wall(const Camera& camera) {
+    auto buffer = OcclusionBuffer(32, 32);
+    auto a = Point(-4, -4, -5);
+    auto b = Point(-4, 4, -5);
+    auto c = Point(4, 4, -5);
+    auto d = Point(4, -4, -5);
+    buffer.add(a, b, c, camera);
+    buffer.add(a, c, d, camera);
+    return buffer;
+  }
+}
+
+TEST_SUITE("OcclusionBuffer") {
+  TEST_CASE("empty") {
+    auto camera = Camera(1);
+    auto buffer = OcclusionBuffer(32, 32);
+    CHECK(buffer.get_width() == 32);
+    CHECK(buffer.get_height() == 32);
+    CHECK(!buffer.is_occluded(
+      BoundingBox(Point(-1, -1, 9), Point(1, 1, 10)), camera));
+  }
+
+  TEST_CASE("conservative_coverage") {
+    auto camera = Camera(1);
+    auto buffer = make_wall(camera);
+    auto& depth_buffer = buffer.get_depth_buffer();
+    auto is_conservative = true;
+    for(auto y = 0; y != buffer.get_height(); ++y) {
+      for(auto x = 0; x != buffer.get_width(); ++x) {
+        is_conservative =
+          is_conservative && depth_buffer(x, y) <= 1 / 6.f;
+      }
+    }
+    CHECK(is_conservative);
+    CHECK(depth_buffer(16, 16) > 0);
+  }
+
+  TEST_CASE("occluded") {
+    auto camera = Camera(1);
+    auto buffer = make_wall(camera);
+    CHECK(buffer.is_occluded(
+      BoundingBox(Point(-1, -1, 9), Point(1, 1, 10)), camera));
+    CHECK(!buffer.is_occluded(
+      BoundingBox(Point(-1, -1, 2), Point(1, 1, 3)), camera));
+    CHECK(!buffer.is_occluded(
+      BoundingBox(Point(-1, -1, 4), Point(1, 1, 6)), camera));
+    CHECK(!buffer.is_occluded(
+      BoundingBox(Point(-10, -1, 9), Point(-5, 1, 10)), camera));
+    CHECK(!buffer.is_occluded(
+      BoundingBox(Point(-1, -1, -1), Point(1, 1, 10)), camera));
+  }
+
+  TEST_CASE("clear") {
+    auto camera = Camera(1);
+    auto buffer = make_wall(camera);
+    buffer.clear();
+    CHECK(!buffer.is_occluded(
+      BoundingBox(Point(-1, -1, 9), Point(1, 1, 10)), camera));
+  }
+}
@@ -0,0 +1,96 @@
+#include <doctest/doctest.h>
+#include "Ashkal/Raster.hpp"
+
+using namespace Ashkal;
+
+namespace {
+  const auto TILE_SIZE = DepthBuffer::CLEAR_TILE_SIZE;
+}
+
+TEST_SUITE("Raster") {
+  TEST_CASE("clear") {
+    auto raster = DepthBuffer(2 * TILE_SIZE + 5, TILE_SIZE + 3);
+    raster.fill(7);
+    raster.clear(1);
+    auto& view = static_cast<const DepthBuffer&>(raster);
+    CHECK(raster.get_clear_value() == 1);
+    CHECK(view(0, 0) == 1);
+    CHECK(view(2 * TILE_SIZE + 4, TILE_SIZE + 2) == 1);
+    CHECK(raster.is_cleared(0, 0, raster.get_width(), raster.get_height()));
+    CHECK(raster(TILE_SIZE, 0) == 1);
+    CHECK(!raster.is_cleared(TILE_SIZE, 0, 1, 1));
+    CHECK(raster.is_cleared(0, 0, TILE_SIZE, TILE_SIZE));
+    CHECK(view.data()[0] == 1);
+    CHECK(view.data()[raster.get_size() - 1] == 1);
+    CHECK(!raster.is_cleared(0, 0, 1, 1));
+    raster.clear(2);
+    CHECK(raster.data()[TILE_SIZE] == 2);
+    CHECK(!raster.is_cleared(TILE_SIZE, 0, 1, 1));
+    raster.fill(3);
+    CHECK(raster(0, 0) == 3);
+    CHECK(!raster.is_cleared(0, 0, 1, 1));
+  }
+
+  TEST_CASE("resolve") {
+    auto raster = DepthBuffer(2 * TILE_SIZE + 5, TILE_SIZE + 3);
+    raster.fill(7);
+    raster.clear(1);
+    raster.resolve(TILE_SIZE, 0, 1, 1);
+    auto& view = static_cast<const DepthBuffer&>(raster);
+    CHECK(view(TILE_SIZE, 0) == 1);
+    CHECK(view(2 * TILE_SIZE - 1, 0) == 1);
+    CHECK(!raster.is_cleared(TILE_SIZE, 0, 1, 1));
+    CHECK(raster.is_cleared(0, 0, TILE_SIZE, TILE_SIZE));
+    raster(TILE_SIZE, 0) = 4;
+    CHECK(raster(TILE_SIZE, 0) == 4);
+    CHECK(raster(0, 0) == 1);
+    raster.resolve();
+    auto is_resolved = true;
+    for(auto y = 0; y != raster.get_height(); ++y) {
+      for(auto x = 0; x != raster.get_width(); ++x) {
+        is_resolved = is_resolved &&
+          raster.data()[y * raster.get_width() + x] == raster(x, y) &&
+          (raster(x, y) == 1 || (x == TILE_SIZE && y == 0));
+      }
+    }
+    CHECK(is_resolved);
+  }
+
+  TEST_CASE("overwrite") {
+    auto raster = DepthBuffer(2 * TILE_SIZE + 5, TILE_SIZE + 3);
+    raster.fill(7);
+    raster.clear(1);
+    raster.overwrite(0, 0, TILE_SIZE + 1, TILE_SIZE);
+    auto& view = static_cast<const DepthBuffer&>(raster);
+    CHECK(!raster.is_cleared(0, 0, 1, 1));
+    CHECK(view(0, 0) == 7);
+    CHECK(!raster.is_cleared(TILE_SIZE, 0, 1, 1));
+    CHECK(view(TILE_SIZE + 1, 0) == 1);
+    CHECK(raster.is_cleared(0, TILE_SIZE, 1, 1));
+    raster.overwrite(2 * TILE_SIZE, TILE_SIZE, 5, 3);
+    CHECK(view(2 * TILE_SIZE, TILE_SIZE) == 7);
+    CHECK(raster.is_cleared(0, TILE_SIZE, 1, 1));
+  }
+
+  TEST_CASE("copy") {
+    auto raster = DepthBuffer(2 * TILE_SIZE + 5, TILE_SIZE + 3);
+    raster.fill(7);
+    raster.clear(1);
+    raster.overwrite(0, 0, TILE_SIZE, TILE_SIZE);
+    auto tile = DepthBuffer(TILE_SIZE + 2, 2);
+    raster.copy_to(TILE_SIZE - 1, 1, TILE_SIZE + 2, 2, tile);
+    CHECK(tile(0, 0) == 7);
+    CHECK(tile(1, 0) == 1);
+    CHECK(tile(TILE_SIZE + 1, 1) == 1);
+    CHECK(raster.is_cleared(TILE_SIZE, 0, TILE_SIZE, TILE_SIZE));
+    tile.fill(4);
+    raster.copy_from(tile, TILE_SIZE, TILE_SIZE, TILE_SIZE + 2, 2);
+    CHECK(raster.is_cleared(TILE_SIZE, 0, TILE_SIZE, TILE_SIZE));
+    CHECK(!raster.is_cleared(TILE_SIZE, TILE_SIZE, 1, 1));
+    auto& view = static_cast<const DepthBuffer&>(raster);
+    CHECK(view(TILE_SIZE, TILE_SIZE) == 4);
+    CHECK(view(2 * TILE_SIZE + 1, TILE_SIZE + 1) == 4);
+    CHECK(view(2 * TILE_SIZE + 2, TILE_SIZE + 1) == 1);
+    CHECK(view(TILE_SIZE, TILE_SIZE + 2) == 1);
+  }
+}
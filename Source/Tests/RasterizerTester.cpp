@@ -0,0 +1,714 @@
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <doctest/doctest.h>
+#include "Ashkal/Rasterizer.hpp"
+#include "Ashkal/SolidColorSampler.hpp"
+#include "CountingSampler.hpp"
+
+using namespace Ashkal;
+
+namespace {
+  const auto WIDTH = 32;
+  const auto HEIGHT = 32;
+
+  ShadedVertex make_vertex(float x, float y, float z) {
+    return ShadedVertex(Point(x, y, z), TextureCoordinate(0, 0),
+      ShadingTerm(Color(255, 255, 255), 1));
+  }
+
+  ShadedVertex make_vertex(float x, float y, float z, float u, float v) {
+    return ShadedVertex(Point(x, y, z), TextureCoordinate(u, v),
+      ShadingTerm(Color(255, 255, 255), 1));
+  }
+
+  Material make_material(Color color) {
+    return Material(std::make_shared<SolidColorSampler>(color));
+  }
+
+  class GradientSampler : public ColorSampler {
+    public:
+      Color sample(const TextureCoordinate& uv) const override {
+        return Color(
+          static_cast<std::uint8_t>(std::clamp(255 * uv.m_u, 0.f, 255.f)),
+          static_cast<std::uint8_t>(std::clamp(255 * uv.m_v, 0.f, 255.f)), 0);
+      }
+  };
+
+  DepthBuffer make_depth_buffer() {
+    auto depth_buffer = DepthBuffer(WIDTH, HEIGHT);
+    depth_buffer.fill(0);
+    return depth_buffer;
+  }
+
+  bool is_covered(SubpixelCoordinate a, SubpixelCoordinate b,
+      SubpixelCoordinate c, int x, int y) {
+    auto is_inside = [] (SubpixelCoordinate p1, SubpixelCoordinate p2,
+        SubpixelCoordinate p) {
+      auto dx = static_cast<std::int64_t>(p2.m_x - p1.m_x);
+      auto dy = static_cast<std::int64_t>(p2.m_y - p1.m_y);
+      auto cross = dx * (p.m_y - p1.m_y) - dy * (p.m_x - p1.m_x);
+      if(cross == 0) {
+        return dy < 0 || (dy == 0 && dx > 0);
+      }
+      return cross > 0;
+    };
+    auto point = SubpixelCoordinate(16 * x + 8, 16 * y + 8);
+    return is_inside(b, c, point) && is_inside(c, a, point) &&
+      is_inside(a, b, point);
+  }
+
+  bool is_interior(const FrameBuffer& frame_buffer, int x, int y) {
+    if(x == 0 || y == 0 || x == frame_buffer.get_width() - 1 ||
+        y == frame_buffer.get_height() - 1) {
+      return false;
+    }
+    for(auto dy = -1; dy <= 1; ++dy) {
+      for(auto dx = -1; dx <= 1; ++dx) {
+        if(frame_buffer(x + dx, y + dy) != frame_buffer(x, y)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  template<typename R>
+  bool test_coverage(const ShadedVertex& a, const ShadedVertex& b,
+      const ShadedVertex& c, R rasterizer) {
+    auto camera = Camera(1);
+    auto material = make_material(Color(255, 0, 0));
+    auto frame_buffer = FrameBuffer(WIDTH, HEIGHT);
+    frame_buffer.fill(Color(0));
+    auto depth_buffer = make_depth_buffer();
+    if(auto setup = make_triangle_setup(a, b, c, camera, WIDTH, HEIGHT)) {
+      rasterizer(*setup, material, 0, 0, frame_buffer, depth_buffer);
+    }
+    auto screen_a = project_to_subpixel(a.m_position, camera, WIDTH, HEIGHT);
+    auto screen_b = project_to_subpixel(b.m_position, camera, WIDTH, HEIGHT);
+    auto screen_c = project_to_subpixel(c.m_position, camera, WIDTH, HEIGHT);
+    auto count = 0;
+    for(auto y = 0; y != HEIGHT; ++y) {
+      for(auto x = 0; x != WIDTH; ++x) {
+        auto is_expected = is_covered(screen_a, screen_b, screen_c, x, y);
+        if((frame_buffer(x, y) != Color(0)) != is_expected ||
+            (depth_buffer(x, y) != 0) != is_expected) {
+          return false;
+        }
+        if(is_expected) {
+          ++count;
+        }
+      }
+    }
+    return count != 0;
+  }
+
+  bool test_coverage(
+      const ShadedVertex& a, const ShadedVertex& b, const ShadedVertex& c) {
+    return test_coverage(a, b, c, &rasterize_blocks) &&
+      test_coverage(a, b, c, &rasterize_spans);
+  }
+}
+
+TEST_SUITE("Rasterizer") {
+  TEST_CASE("edge_function") {
+    auto edge =
+      make_edge_function(SubpixelCoordinate(1, 2), SubpixelCoordinate(5, 4));
+    CHECK(evaluate(edge, SubpixelCoordinate(1, 2)) == 0);
+    CHECK(evaluate(edge, SubpixelCoordinate(5, 4)) == 0);
+    CHECK(evaluate(edge, SubpixelCoordinate(3, 5)) > 0);
+    CHECK(evaluate(edge, SubpixelCoordinate(3, 1)) < 0);
+    CHECK(evaluate(edge, SubpixelCoordinate(4, 3)) -
+      evaluate(edge, SubpixelCoordinate(3, 3)) == edge.m_a);
+    CHECK(evaluate(edge, SubpixelCoordinate(3, 4)) -
+      evaluate(edge, SubpixelCoordinate(3, 3)) == edge.m_b);
+  }
+
+  TEST_CASE("top_left") {
+    CHECK(is_top_left(
+      make_edge_function(SubpixelCoordinate(0, 8), SubpixelCoordinate(0, 0))));
+    CHECK(is_top_left(
+      make_edge_function(SubpixelCoordinate(0, 0), SubpixelCoordinate(8, 0))));
+    CHECK(!is_top_left(
+      make_edge_function(SubpixelCoordinate(0, 0), SubpixelCoordinate(0, 8))));
+    CHECK(!is_top_left(
+      make_edge_function(SubpixelCoordinate(8, 0), SubpixelCoordinate(0, 0))));
+  }
+
+  TEST_CASE("attribute_plane") {
+    auto a = get_pixel_center(0, 4);
+    auto b = get_pixel_center(2, 0);
+    auto c = get_pixel_center(4, 4);
+    auto edges = std::array{make_edge_function(b, c), make_edge_function(c, a),
+      make_edge_function(a, b)};
+    auto plane = make_attribute_plane(
+      edges, evaluate(edges[0], a), std::array{1.f, 2.f, 3.f});
+    CHECK(evaluate(plane, 0, 4) == doctest::Approx(1));
+    CHECK(evaluate(plane, 2, 0) == doctest::Approx(2));
+    CHECK(evaluate(plane, 4, 4) == doctest::Approx(3));
+    CHECK(evaluate(plane, 2, 4) - evaluate(plane, 1, 4) ==
+      doctest::Approx(plane.m_dx));
+    CHECK(evaluate(plane, 2, 3) - evaluate(plane, 2, 2) ==
+      doctest::Approx(plane.m_dy));
+  }
+
+  TEST_CASE("degenerate_triangle") {
+    auto camera = Camera(1);
+    auto a = make_vertex(-1, -1, -2);
+    auto b = make_vertex(0, 0, -2);
+    auto c = make_vertex(1, 1, -2);
+    CHECK(!make_triangle_setup(a, b, c, camera, WIDTH, HEIGHT));
+  }
+
+  TEST_CASE("opposite_winding") {
+    auto camera = Camera(1);
+    auto a = make_vertex(-1, -1, -2);
+    auto b = make_vertex(0, 1, -2);
+    auto c = make_vertex(1, -1, -2);
+    CHECK(make_triangle_setup(a, b, c, camera, WIDTH, HEIGHT));
+    CHECK(!make_triangle_setup(a, c, b, camera, WIDTH, HEIGHT));
+  }
+
+  TEST_CASE("coverage") {
+    CHECK(test_coverage(make_vertex(-1.5f, -1, -2),
+      make_vertex(0.3f, 1.7f, -2.5f), make_vertex(1, -0.8f, -3)));
+  }
+
+  TEST_CASE("large_triangle_coverage") {
+    CHECK(test_coverage(make_vertex(-3, -3, -2), make_vertex(-3, 3, -2),
+      make_vertex(3, 3, -2)));
+  }
+
+  TEST_CASE("thin_triangle_coverage") {
+    CHECK(test_coverage(make_vertex(-2, -1.9f, -2), make_vertex(-2, -1.6f, -2),
+      make_vertex(2, 1.9f, -2)));
+  }
+
+  TEST_CASE("long_edge_coverage") {
+
+    // Places vertices on exact subpixels, where the camera maps the origin to
+    // the center of pixel (15, 15) and a unit to 124 subpixels.
+    auto make_subpixel_vertex = [] (int x, int y) {
+      return make_vertex((x - 248) / 124.f, (248 - y) / 124.f, -2);
+    };
+
+    // The edge between the first two vertices passes a single unit from the
+    // center of pixel (15, 15), and its edge function exceeds 2^24 across
+    // the pixel's block.
+    auto d = 670648;
+    CHECK(test_coverage(make_subpixel_vertex(247 - d, 250 + d),
+      make_subpixel_vertex(248 + d, 247 - d),
+      make_subpixel_vertex(248 + d, 248 + d)));
+  }
+
+  TEST_CASE("shared_edges") {
+    auto camera = Camera(1);
+    auto center = make_vertex(0, 0, -2);
+    auto corners = std::array{make_vertex(-1, 0, -2), make_vertex(0, 1, -2),
+      make_vertex(1, 0, -2), make_vertex(0, -1, -2)};
+    auto frame_buffers = std::vector<FrameBuffer>();
+    for(auto i = 0; i != 4; ++i) {
+      auto& frame_buffer = frame_buffers.emplace_back(WIDTH, HEIGHT);
+      frame_buffer.fill(Color(0));
+      auto depth_buffer = make_depth_buffer();
+      rasterize(center, corners[i], corners[(i + 1) % 4],
+        make_material(Color(255, 255, 255)), camera, frame_buffer,
+        depth_buffer);
+    }
+    auto origin =
+      project_to_subpixel(center.m_position, camera, WIDTH, HEIGHT);
+    auto radius = project_to_subpixel(
+      corners[2].m_position, camera, WIDTH, HEIGHT).m_x - origin.m_x;
+    auto is_partitioned = true;
+    for(auto y = 0; y != HEIGHT; ++y) {
+      for(auto x = 0; x != WIDTH; ++x) {
+        auto count = 0;
+        for(auto& frame_buffer : frame_buffers) {
+          count += frame_buffer(x, y) != Color(0);
+        }
+        auto distance = std::abs(16 * x + 8 - origin.m_x) +
+          std::abs(16 * y + 8 - origin.m_y);
+        is_partitioned = is_partitioned && count <= 1 &&
+          (distance >= radius || count == 1) &&
+          (distance <= radius || count == 0);
+      }
+    }
+    CHECK(is_partitioned);
+  }
+
+  TEST_CASE("span_interpolation") {
+    auto camera = Camera(1);
+    auto setup = make_triangle_setup(make_vertex(-2, -1.5f, -2),
+      make_vertex(0.5f, 2, -3), make_vertex(1.5f, -1, -5), camera, WIDTH,
+      HEIGHT);
+    REQUIRE(setup);
+    auto material = make_material(Color(255, 255, 255));
+    auto block_frame_buffer = FrameBuffer(WIDTH, HEIGHT);
+    block_frame_buffer.fill(Color(0));
+    auto block_depth_buffer = make_depth_buffer();
+    rasterize_blocks(
+      *setup, material, 0, 0, block_frame_buffer, block_depth_buffer);
+    auto span_frame_buffer = FrameBuffer(WIDTH, HEIGHT);
+    span_frame_buffer.fill(Color(0));
+    auto span_depth_buffer = make_depth_buffer();
+    rasterize_spans(
+      *setup, material, 0, 0, span_frame_buffer, span_depth_buffer);
+    auto is_equal = true;
+    for(auto y = 0; y != HEIGHT; ++y) {
+      for(auto x = 0; x != WIDTH; ++x) {
+        is_equal = is_equal && block_depth_buffer(x, y) ==
+          doctest::Approx(span_depth_buffer(x, y)) &&
+          (block_frame_buffer(x, y) == Color(0)) ==
+            (span_frame_buffer(x, y) == Color(0));
+      }
+    }
+    CHECK(is_equal);
+  }
+
+  TEST_CASE("depth_test") {
+    auto camera = Camera(1);
+    auto near_material = make_material(Color(0, 255, 0));
+    auto far_material = make_material(Color(0, 0, 255));
+    auto frame_buffer = FrameBuffer(WIDTH, HEIGHT);
+    auto depth_buffer = make_depth_buffer();
+    rasterize(make_vertex(-1, -1, -2), make_vertex(0, 1, -2),
+      make_vertex(1, -1, -2), near_material, camera, frame_buffer,
+      depth_buffer);
+    rasterize(make_vertex(-2, -2, -4), make_vertex(0, 2, -4),
+      make_vertex(2, -2, -4), far_material, camera, frame_buffer,
+      depth_buffer);
+    CHECK(frame_buffer(WIDTH / 2, HEIGHT / 2) == Color(0, 255, 0));
+  }
+
+  TEST_CASE("cleared_raster") {
+    const auto SIZE = 3 * DepthBuffer::CLEAR_TILE_SIZE;
+    const auto LEFT = 5;
+    const auto TOP = 3;
+    auto camera = Camera(1);
+    auto setup = make_triangle_setup(make_vertex(-1.5f, -1, -2),
+      make_vertex(0.3f, 1.7f, -2.5f), make_vertex(1, -0.8f, -3), camera,
+      SIZE + LEFT, SIZE + TOP);
+    REQUIRE(setup);
+    auto material = make_material(Color(255, 0, 0));
+    auto frame_buffer = FrameBuffer(SIZE, SIZE);
+    frame_buffer.fill(Color(0));
+    auto depth_buffer = DepthBuffer(SIZE, SIZE);
+    depth_buffer.fill(0);
+    rasterize(*setup, material, LEFT, TOP, frame_buffer, depth_buffer);
+    auto cleared_frame_buffer = FrameBuffer(SIZE, SIZE);
+    cleared_frame_buffer.fill(Color(1, 2, 3));
+    cleared_frame_buffer.clear(Color(0));
+    auto cleared_depth_buffer = DepthBuffer(SIZE, SIZE);
+    cleared_depth_buffer.fill(100);
+    cleared_depth_buffer.clear(0);
+    rasterize(*setup, material, LEFT, TOP, cleared_frame_buffer,
+      cleared_depth_buffer);
+    auto is_equal = true;
+    for(auto y = 0; y != SIZE; ++y) {
+      for(auto x = 0; x != SIZE; ++x) {
+        is_equal = is_equal &&
+          cleared_frame_buffer(x, y) == frame_buffer(x, y) &&
+          cleared_depth_buffer(x, y) == depth_buffer(x, y);
+      }
+    }
+    CHECK(is_equal);
+    CHECK(frame_buffer(SIZE / 2, SIZE / 2) == Color(255, 0, 0));
+  }
+
+  TEST_CASE("visibility") {
+    auto visibility = make_visibility(3, 7);
+    CHECK(visibility != NO_VISIBILITY);
+    CHECK(get_draw(visibility) == 3);
+    CHECK(get_triangle(visibility) == 7);
+    auto camera = Camera(1);
+    auto near_setup = make_triangle_setup(make_vertex(-1, -1, -2),
+      make_vertex(0, 1, -2), make_vertex(1, -1, -2), camera, WIDTH, HEIGHT);
+    auto far_setup = make_triangle_setup(make_vertex(-3, -3, -4),
+      make_vertex(0, 3, -4), make_vertex(3, -3, -4), camera, WIDTH, HEIGHT);
+    REQUIRE(near_setup);
+    REQUIRE(far_setup);
+    auto visibility_buffer = VisibilityBuffer(WIDTH, HEIGHT);
+    visibility_buffer.fill(NO_VISIBILITY);
+    auto depth_buffer = make_depth_buffer();
+    rasterize_visibility(*near_setup, make_visibility(0, 0), 0, 0,
+      visibility_buffer, depth_buffer);
+    rasterize_visibility(*far_setup, make_visibility(1, 0), 0, 0,
+      visibility_buffer, depth_buffer);
+    CHECK(visibility_buffer(0, 0) == NO_VISIBILITY);
+    CHECK(visibility_buffer(WIDTH / 2, HEIGHT / 2) == make_visibility(0, 0));
+    CHECK(visibility_buffer(WIDTH / 2, HEIGHT - 6) == make_visibility(1, 0));
+    auto material = make_material(Color(0, 255, 0));
+    auto colors = std::array<Color, 2>();
+    shade_run(*near_setup, material, WIDTH / 2, HEIGHT / 2, 2, colors.data());
+    CHECK(colors[0] == Color(0, 255, 0));
+    CHECK(colors[1] == Color(0, 255, 0));
+  }
+
+  TEST_CASE("depth_pre_pass") {
+    auto camera = Camera(1);
+    auto near_setup = make_triangle_setup(make_vertex(-1, -1, -2),
+      make_vertex(0, 1, -2), make_vertex(1, -1, -2), camera, WIDTH, HEIGHT);
+    auto far_setup = make_triangle_setup(make_vertex(-3, -3, -4),
+      make_vertex(0, 3, -4), make_vertex(3, -3, -4), camera, WIDTH, HEIGHT);
+    REQUIRE(near_setup);
+    REQUIRE(far_setup);
+    auto depth_buffer = make_depth_buffer();
+    rasterize_depth(*near_setup, 0, 0, depth_buffer);
+    rasterize_depth(*far_setup, 0, 0, depth_buffer);
+    auto expected_frame_buffer = FrameBuffer(WIDTH, HEIGHT);
+    expected_frame_buffer.fill(Color(0));
+    auto expected_depth_buffer = make_depth_buffer();
+    auto near_material = make_material(Color(0, 255, 0));
+    auto far_material = make_material(Color(0, 0, 255));
+    rasterize(*near_setup, near_material, expected_frame_buffer,
+      expected_depth_buffer);
+    rasterize(*far_setup, far_material, expected_frame_buffer,
+      expected_depth_buffer);
+    auto frame_buffer = FrameBuffer(WIDTH, HEIGHT);
+    frame_buffer.fill(Color(0));
+    rasterize_visible(
+      *far_setup, far_material, 0, 0, frame_buffer, depth_buffer);
+    rasterize_visible(
+      *near_setup, near_material, 0, 0, frame_buffer, depth_buffer);
+    auto is_equal = true;
+    for(auto y = 0; y != HEIGHT; ++y) {
+      for(auto x = 0; x != WIDTH; ++x) {
+        is_equal = is_equal &&
+          frame_buffer(x, y) == expected_frame_buffer(x, y) &&
+          depth_buffer(x, y) == expected_depth_buffer(x, y);
+      }
+    }
+    CHECK(is_equal);
+    CHECK(frame_buffer(WIDTH / 2, HEIGHT / 2) == Color(0, 255, 0));
+    CHECK(frame_buffer(WIDTH / 2, HEIGHT - 6) == Color(0, 0, 255));
+  }
+
+  TEST_CASE("hierarchical_depth_pre_pass") {
+    const auto SIZE = 128;
+    auto camera = Camera(1);
+    auto make_setup = [&] (const ShadedVertex& a, const ShadedVertex& b,
+        const ShadedVertex& c) {
+      return make_triangle_setup(a, b, c, camera, SIZE, SIZE);
+    };
+
+    // Submitted back to front, with the nearest triangle covering the start
+    // of the farthest triangle's rows and a third triangle crossing both.
+    auto setups = std::array{
+      make_setup(make_vertex(-6, -6, -8), make_vertex(-6, 6, -8),
+        make_vertex(6, 0, -5)),
+      make_setup(make_vertex(-2, 1, -4), make_vertex(0, 3, -9),
+        make_vertex(2, -3, -6)),
+      make_setup(make_vertex(-4, -4, -3), make_vertex(-4, 4, -3),
+        make_vertex(0.5f, 0, -2.5f))};
+    for(auto& setup : setups) {
+      REQUIRE(setup);
+    }
+    auto materials = std::array{make_material(Color(255, 0, 0)),
+      make_material(Color(0, 255, 0)), make_material(Color(0, 0, 255))};
+    auto expected_frame_buffer = FrameBuffer(SIZE, SIZE);
+    expected_frame_buffer.fill(Color(0));
+    auto expected_depth_buffer = DepthBuffer(SIZE, SIZE);
+    expected_depth_buffer.fill(0);
+    for(auto i = 0; i != 3; ++i) {
+      rasterize(*setups[i], materials[i], expected_frame_buffer,
+        expected_depth_buffer);
+    }
+    auto hierarchical_depth_buffer = HierarchicalDepthBuffer(SIZE, SIZE);
+    auto depth_buffer = DepthBuffer(SIZE, SIZE);
+    depth_buffer.fill(0);
+    for(auto& setup : setups) {
+      rasterize_depth(*setup, 0, 0, depth_buffer, hierarchical_depth_buffer);
+    }
+    auto frame_buffer = FrameBuffer(SIZE, SIZE);
+    frame_buffer.fill(Color(0));
+    for(auto i = 0; i != 3; ++i) {
+      rasterize_visible(*setups[i], materials[i], 0, 0, frame_buffer,
+        depth_buffer, hierarchical_depth_buffer);
+    }
+    auto is_equal = true;
+    for(auto y = 0; y != SIZE; ++y) {
+      for(auto x = 0; x != SIZE; ++x) {
+        is_equal = is_equal &&
+          frame_buffer(x, y) == expected_frame_buffer(x, y) &&
+          depth_buffer(x, y) == expected_depth_buffer(x, y);
+      }
+    }
+    CHECK(is_equal);
+  }
+
+  TEST_CASE("hierarchical_depth") {
+    auto camera = Camera(1);
+    auto near_setup = make_triangle_setup(make_vertex(-3, -3, -2),
+      make_vertex(0, 3, -2), make_vertex(3, -3, -2), camera, WIDTH, HEIGHT);
+    auto far_setup = make_triangle_setup(make_vertex(-1, -1, -4),
+      make_vertex(0, 1, -4), make_vertex(1, -1, -4), camera, WIDTH, HEIGHT);
+    auto behind_setup = make_triangle_setup(make_vertex(-12, -12, -4),
+      make_vertex(0, 12, -4), make_vertex(12, -12, -4), camera, WIDTH,
+      HEIGHT);
+    REQUIRE(near_setup);
+    REQUIRE(far_setup);
+    REQUIRE(behind_setup);
+    auto hierarchical_depth_buffer = HierarchicalDepthBuffer(WIDTH, HEIGHT);
+    auto depth_buffer = make_depth_buffer();
+    auto frame_buffer = FrameBuffer(WIDTH, HEIGHT);
+    frame_buffer.fill(Color(0));
+    auto expected_depth_buffer = make_depth_buffer();
+    auto expected_frame_buffer = FrameBuffer(WIDTH, HEIGHT);
+    expected_frame_buffer.fill(Color(0));
+    auto materials = std::array{make_material(Color(255, 0, 0)),
+      make_material(Color(0, 255, 0)), make_material(Color(0, 0, 255))};
+    auto setups = std::array{&*near_setup, &*far_setup, &*behind_setup};
+    for(auto i = 0; i != 3; ++i) {
+      if(i != 0) {
+        CHECK(is_occluded(*setups[i], hierarchical_depth_buffer, 0, 0,
+          WIDTH / 2, HEIGHT / 2, WIDTH / 2, HEIGHT / 2));
+      }
+      rasterize(*setups[i], materials[i], 0, 0, frame_buffer, depth_buffer,
+        hierarchical_depth_buffer);
+      rasterize(*setups[i], materials[i], expected_frame_buffer,
+        expected_depth_buffer);
+    }
+    CHECK(is_occluded(*far_setup, hierarchical_depth_buffer, 0, 0,
+      far_setup->m_min_x, far_setup->m_min_y, far_setup->m_max_x,
+      far_setup->m_max_y));
+    CHECK(!is_occluded(*behind_setup, hierarchical_depth_buffer, 0, 0, 0, 0,
+      WIDTH - 1, HEIGHT - 1));
+    auto is_equal = true;
+    for(auto y = 0; y != HEIGHT; ++y) {
+      for(auto x = 0; x != WIDTH; ++x) {
+        is_equal = is_equal &&
+          frame_buffer(x, y) == expected_frame_buffer(x, y) &&
+          depth_buffer(x, y) == expected_depth_buffer(x, y);
+      }
+    }
+    CHECK(is_equal);
+    CHECK(frame_buffer(WIDTH / 2, HEIGHT / 2) == Color(255, 0, 0));
+    CHECK(frame_buffer(0, 0) == Color(0, 0, 255));
+  }
+
+  TEST_CASE("multisample") {
+    auto camera = Camera(1);
+    auto near_a = make_vertex(-1, -1, -2);
+    auto near_b = make_vertex(0, 1, -2);
+    auto near_c = make_vertex(1, -1, -2);
+    auto far_a = make_vertex(-3, -3, -4);
+    auto far_b = make_vertex(0, 3, -4);
+    auto far_c = make_vertex(3, -3, -4);
+    auto near_material = make_material(Color(0, 255, 0));
+    auto far_material = make_material(Color(0, 0, 255));
+    auto color_samples = FrameBuffer(WIDTH, HEIGHT * SAMPLE_COUNT);
+    color_samples.fill(Color(0));
+    auto depth_samples = DepthBuffer(WIDTH, HEIGHT * SAMPLE_COUNT);
+    depth_samples.fill(0);
+    rasterize_multisample(near_a, near_b, near_c, near_material, camera,
+      color_samples, depth_samples);
+    rasterize_multisample(far_a, far_b, far_c, far_material, camera,
+      color_samples, depth_samples);
+    auto frame_buffer = FrameBuffer(WIDTH, HEIGHT);
+    auto depth_buffer = make_depth_buffer();
+    for(auto y = 0; y != HEIGHT; ++y) {
+      resolve(color_samples, y, WIDTH, &frame_buffer(0, y));
+      resolve(depth_samples, y, WIDTH, &depth_buffer(0, y));
+    }
+    auto expected_frame_buffer = FrameBuffer(WIDTH, HEIGHT);
+    expected_frame_buffer.fill(Color(0));
+    auto expected_depth_buffer = make_depth_buffer();
+    rasterize(near_a, near_b, near_c, near_material, camera,
+      expected_frame_buffer, expected_depth_buffer);
+    rasterize(far_a, far_b, far_c, far_material, camera,
+      expected_frame_buffer, expected_depth_buffer);
+    auto is_interior_equal = true;
+    auto blended_count = 0;
+    for(auto y = 0; y != HEIGHT; ++y) {
+      for(auto x = 0; x != WIDTH; ++x) {
+        if(is_interior(expected_frame_buffer, x, y)) {
+          is_interior_equal = is_interior_equal &&
+            frame_buffer(x, y) == expected_frame_buffer(x, y) &&
+            depth_buffer(x, y) ==
+              doctest::Approx(expected_depth_buffer(x, y));
+        } else if(frame_buffer(x, y) != Color(0, 255, 0) &&
+            frame_buffer(x, y) != Color(0, 0, 255) &&
+            frame_buffer(x, y) != Color(0)) {
+          ++blended_count;
+        }
+      }
+    }
+    CHECK(is_interior_equal);
+    CHECK(blended_count != 0);
+    CHECK(frame_buffer(WIDTH / 2, HEIGHT / 2) == Color(0, 255, 0));
+    CHECK(frame_buffer(WIDTH / 2, HEIGHT - 6) == Color(0, 0, 255));
+  }
+
+  TEST_CASE("multisample_shared_edges") {
+    auto camera = Camera(1);
+    auto material = make_material(Color(255, 0, 0));
+    auto color_samples = FrameBuffer(WIDTH, HEIGHT * SAMPLE_COUNT);
+    color_samples.fill(Color(0));
+    auto depth_samples = DepthBuffer(WIDTH, HEIGHT * SAMPLE_COUNT);
+    depth_samples.fill(0);
+    auto a = make_vertex(-3, -3, -4);
+    auto b = make_vertex(-2, 3, -4);
+    auto c = make_vertex(3, 2, -4);
+    auto d = make_vertex(2, -3, -4);
+    rasterize_multisample(
+      a, b, c, material, camera, color_samples, depth_samples);
+    rasterize_multisample(
+      a, c, d, material, camera, color_samples, depth_samples);
+    auto frame_buffer = FrameBuffer(WIDTH, HEIGHT);
+    for(auto y = 0; y != HEIGHT; ++y) {
+      resolve(color_samples, y, WIDTH, &frame_buffer(0, y));
+    }
+    auto expected_frame_buffer = FrameBuffer(WIDTH, HEIGHT);
+    expected_frame_buffer.fill(Color(0));
+    auto expected_depth_buffer = make_depth_buffer();
+    rasterize(a, b, c, material, camera, expected_frame_buffer,
+      expected_depth_buffer);
+    rasterize(a, c, d, material, camera, expected_frame_buffer,
+      expected_depth_buffer);
+    auto has_gaps = false;
+    for(auto y = 0; y != HEIGHT; ++y) {
+      for(auto x = 0; x != WIDTH; ++x) {
+        has_gaps = has_gaps || (is_interior(expected_frame_buffer, x, y) &&
+          frame_buffer(x, y) != expected_frame_buffer(x, y));
+      }
+    }
+    CHECK(!has_gaps);
+    CHECK(frame_buffer(WIDTH / 2, HEIGHT / 2) == Color(255, 0, 0));
+  }
+
+  TEST_CASE("coarse_shading") {
+    auto camera = Camera(1);
+    auto setup = make_triangle_setup(make_vertex(-3, -3, -4),
+      make_vertex(0, 3, -4), make_vertex(3, -3, -4), camera, WIDTH, HEIGHT);
+    REQUIRE(setup);
+    auto sampler = std::make_shared<CountingSampler>();
+    auto material = Material(sampler);
+    auto expected_frame_buffer = FrameBuffer(WIDTH, HEIGHT);
+    expected_frame_buffer.fill(Color(0));
+    auto expected_depth_buffer = make_depth_buffer();
+    rasterize(*setup, material, expected_frame_buffer, expected_depth_buffer);
+    auto counts = std::array<int, 3>();
+    counts[0] = sampler->m_count;
+    auto coverage_buffer = CoverageBuffer(WIDTH, HEIGHT);
+    coverage_buffer.fill(0);
+    for(auto rate : {ShadingRate::TWO_BY_TWO, ShadingRate::FOUR_BY_FOUR}) {
+      sampler->m_count = 0;
+      auto frame_buffer = FrameBuffer(WIDTH, HEIGHT);
+      frame_buffer.fill(Color(0));
+      auto depth_buffer = make_depth_buffer();
+      auto hierarchical_depth_buffer = HierarchicalDepthBuffer(WIDTH, HEIGHT);
+      rasterize(*setup, material, rate, 0, 0, frame_buffer, depth_buffer,
+        hierarchical_depth_buffer, coverage_buffer);
+      counts[static_cast<int>(rate)] = sampler->m_count;
+      auto is_equal = true;
+      for(auto y = 0; y != HEIGHT; ++y) {
+        for(auto x = 0; x != WIDTH; ++x) {
+          is_equal = is_equal &&
+            frame_buffer(x, y) == expected_frame_buffer(x, y) &&
+            depth_buffer(x, y) == expected_depth_buffer(x, y) &&
+            coverage_buffer(x, y) == 0;
+        }
+      }
+      CHECK(is_equal);
+    }
+    CHECK(counts[0] != 0);
+    CHECK(2 * counts[1] < counts[0]);
+    CHECK(2 * counts[2] < counts[1]);
+  }
+
+  TEST_CASE("coarse_shading_position") {
+    auto camera = Camera(1);
+    auto setup = make_triangle_setup(make_vertex(-3, -3, -4, 0, 0),
+      make_vertex(-1, 3, -4, 0, 1), make_vertex(3, -2, -4, 1, 0), camera,
+      WIDTH, HEIGHT);
+    REQUIRE(setup);
+    auto material = Material(std::make_shared<GradientSampler>());
+    auto expected_frame_buffer = FrameBuffer(WIDTH, HEIGHT);
+    expected_frame_buffer.fill(Color(0));
+    auto expected_depth_buffer = make_depth_buffer();
+    rasterize(*setup, material, expected_frame_buffer, expected_depth_buffer);
+    auto frame_buffer = FrameBuffer(WIDTH, HEIGHT);
+    frame_buffer.fill(Color(0));
+    auto depth_buffer = make_depth_buffer();
+    auto hierarchical_depth_buffer = HierarchicalDepthBuffer(WIDTH, HEIGHT);
+    auto coverage_buffer = CoverageBuffer(WIDTH, HEIGHT);
+    coverage_buffer.fill(0);
+    rasterize(*setup, material, ShadingRate::FOUR_BY_FOUR, 0, 0,
+      frame_buffer, depth_buffer, hierarchical_depth_buffer, coverage_buffer);
+    auto error = 0;
+    for(auto block_y = 0; block_y != HEIGHT; block_y += 4) {
+      for(auto block_x = 0; block_x != WIDTH; block_x += 4) {
+        auto shaded = std::optional<Color>();
+        for(auto y = block_y; y != block_y + 4; ++y) {
+          for(auto x = block_x; x != block_x + 4; ++x) {
+            if(expected_frame_buffer(x, y) == Color(0)) {
+              continue;
+            }
+            if(!shaded) {
+              shaded = expected_frame_buffer(x, y);
+            }
+            error = std::max({error,
+              std::abs(frame_buffer(x, y).get_red() - shaded->get_red()),
+              std::abs(frame_buffer(x, y).get_green() - shaded->get_green())});
+          }
+        }
+      }
+    }
+    CHECK(error <= 1);
+  }
+
+  TEST_CASE("affine_perspective_correction") {
+    auto camera = Camera(1);
+    auto material = Material(std::make_shared<GradientSampler>());
+    auto render = [&] (const TriangleSetup& setup) {
+      auto frame_buffer = FrameBuffer(WIDTH, HEIGHT);
+      frame_buffer.fill(Color(0));
+      auto depth_buffer = make_depth_buffer();
+      rasterize(setup, material, frame_buffer, depth_buffer);
+      return frame_buffer;
+    };
+    auto get_error = [] (const FrameBuffer& left, const FrameBuffer& right) {
+      auto error = 0;
+      for(auto y = 0; y != HEIGHT; ++y) {
+        for(auto x = 0; x != WIDTH; ++x) {
+          error = std::max({error,
+            std::abs(left(x, y).get_red() - right(x, y).get_red()),
+            std::abs(left(x, y).get_green() - right(x, y).get_green())});
+        }
+      }
+      return error;
+    };
+    auto correction = PerspectiveCorrection(8, 0.1f);
+    auto flat = make_triangle_setup(make_vertex(-3, -3, -4, 0, 0),
+      make_vertex(0, 3, -4, 0.5f, 1), make_vertex(3, -3, -4, 1, 0), camera,
+      WIDTH, HEIGHT);
+    REQUIRE(flat);
+    CHECK(flat->m_affine_span == 1);
+    auto exact = render(*flat);
+    correct_perspective(*flat, correction);
+    CHECK(flat->m_affine_span == 8);
+    CHECK(get_error(render(*flat), exact) <= 1);
+    auto tilted = make_triangle_setup(make_vertex(-3, -3, -4, 0, 0),
+      make_vertex(0, 3, -4.5f, 0.5f, 1), make_vertex(3, -3, -5, 1, 0),
+      camera, WIDTH, HEIGHT);
+    REQUIRE(tilted);
+    exact = render(*tilted);
+    correct_perspective(*tilted, correction);
+    CHECK(tilted->m_affine_span == 8);
+    CHECK(get_error(render(*tilted), exact) <= 2);
+    auto steep = make_triangle_setup(make_vertex(-3, -3, -2, 0, 0),
+      make_vertex(0, 3, -10, 0.5f, 1), make_vertex(20, -3, -20, 1, 0),
+      camera, WIDTH, HEIGHT);
+    REQUIRE(steep);
+    exact = render(*steep);
+    correct_perspective(*steep, correction);
+    CHECK(steep->m_affine_span == 1);
+    CHECK(get_error(render(*steep), exact) == 0);
+    correct_perspective(*steep, EXACT_PERSPECTIVE_CORRECTION);
+    CHECK(steep->m_affine_span == 1);
+  }
+}
@@ -0,0 +1,55 @@
+#include <memory>
+#include <doctest/doctest.h>
+#include "Ashkal/RenderQueue.hpp"
+#include "Ashkal/SolidColorSampler.hpp"
+
+using namespace Ashkal;
+
+namespace {
+  std::shared_ptr<Material> make_material(Color color) {
+    return std::make_shared<Material>(
+      std::make_shared<SolidColorSampler>(color));
+  }
+}
+
+TEST_SUITE("RenderQueue") {
+  TEST_CASE("sort_key") {
+    CHECK(make_sort_key(1, 5) < make_sort_key(2, 0));
+    CHECK(make_sort_key(2, 0) < make_sort_key(10, 0));
+    CHECK(make_sort_key(0, 1) < make_sort_key(0.5f, 0));
+    CHECK(make_sort_key(-1, 0) == make_sort_key(0, 0));
+    CHECK(make_sort_key(4, 0) < make_sort_key(4.001f, 1));
+    CHECK(make_sort_key(4.001f, 0) < make_sort_key(4, 1));
+  }
+
+  TEST_CASE("depth") {
+    auto camera = Camera(1);
+    auto box = BoundingBox(Point(-1, -1, 3), Point(1, 1, 5));
+    CHECK(get_depth(box, camera) == doctest::Approx(3));
+    auto straddling = BoundingBox(Point(-1, -1, -2), Point(1, 1, 5));
+    CHECK(get_depth(straddling, camera) == 0);
+  }
+
+  TEST_CASE("sort") {
+    auto red = make_material(Color(255, 0, 0));
+    auto blue = make_material(Color(0, 0, 255));
+    auto red_fragment = Fragment({}, red);
+    auto blue_fragment = Fragment({}, blue);
+    auto other_red_fragment = Fragment({}, red);
+    auto model = Model(Mesh({}, MeshNode(Fragment({}, red))));
+    auto queue = RenderQueue();
+    queue.add(model, red_fragment, Matrix::IDENTITY(), 8, true);
+    queue.add(model, blue_fragment, Matrix::IDENTITY(), 2, false);
+    queue.add(model, other_red_fragment, Matrix::IDENTITY(), 2, false);
+    REQUIRE(queue.get_size() == 3);
+    queue.sort();
+    CHECK(queue.get(0).m_fragment == &other_red_fragment);
+    CHECK(queue.get(1).m_fragment == &blue_fragment);
+    CHECK(queue.get(2).m_fragment == &red_fragment);
+    CHECK(queue.get(2).m_is_clipped);
+    CHECK(queue.get(2).m_depth == 8);
+    CHECK(queue.get(0).m_model == &model);
+    queue.clear();
+    CHECK(queue.get_size() == 0);
+  }
+}
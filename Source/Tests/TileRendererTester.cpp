@@ -0,0 +1,536 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <doctest/doctest.h>
+#include "Ashkal/MeshOptimizer.hpp"
+#include "Ashkal/SolidColorSampler.hpp"
+#include "Ashkal/TileRenderer.hpp"
+#include "CountingSampler.hpp"
+
+using namespace Ashkal;
+
+namespace {
+  class GradientSampler : public ColorSampler {
+    public:
+      Color sample(const TextureCoordinate& uv) const override {
+        return Color(
+          static_cast<std::uint8_t>(std::clamp(255 * uv.m_u, 0.f, 255.f)),
+          static_cast<std::uint8_t>(std::clamp(255 * uv.m_v, 0.f, 255.f)), 0);
+      }
+  };
+
+  Mesh make_quad(std::vector<VertexTriangle> triangles,
+      std::shared_ptr<Material> material) {
+    auto vertices = std::vector<Vertex>();
+    vertices.emplace_back(
+      Point(-1, -1, 0), TextureCoordinate(0, 0), Vector(0, 0, -1));
+    vertices.emplace_back(
+      Point(-1, 1, 0), TextureCoordinate(0, 1), Vector(0, 0, -1));
+    vertices.emplace_back(
+      Point(1, 1, 0), TextureCoordinate(1, 1), Vector(0, 0, -1));
+    vertices.emplace_back(
+      Point(1, -1, 0), TextureCoordinate(1, 0), Vector(0, 0, -1));
+    auto fragment = Fragment(std::move(triangles), std::move(material));
+    return Mesh(std::move(vertices), MeshNode(std::move(fragment)));
+  }
+
+  Mesh make_quad(Color color) {
+    auto triangles = std::vector<VertexTriangle>();
+    triangles.push_back({0, 1, 2});
+    triangles.push_back({0, 2, 3});
+    return make_quad(std::move(triangles),
+      std::make_shared<Material>(std::make_shared<SolidColorSampler>(color)));
+  }
+
+  std::unique_ptr<Scene> make_scene() {
+    auto scene = std::make_unique<Scene>();
+    scene->set(AmbientLight(Color(255, 255, 255), 1));
+    auto near_quad = std::make_unique<Model>(make_quad(Color(255, 0, 0)));
+    near_quad->get_segment(near_quad->get_mesh().m_root).apply(
+      translate(Vector(0.5f, 0.25f, 3)));
+    scene->add(std::move(near_quad));
+    auto far_quad = std::make_unique<Model>(make_quad(Color(0, 0, 255)));
+    auto& far_segment = far_quad->get_segment(far_quad->get_mesh().m_root);
+    far_segment.apply(scale(4));
+    far_segment.apply(translate(Vector(0, 0, 6)));
+    scene->add(std::move(far_quad));
+    return scene;
+  }
+
+  bool is_close(Color left, Color right) {
+    return std::abs(left.get_red() - right.get_red()) <= 4 &&
+      std::abs(left.get_green() - right.get_green()) <= 4 &&
+      std::abs(left.get_blue() - right.get_blue()) <= 4;
+  }
+
+  FrameBuffer render(TileRenderer& renderer, const Scene& scene, int width,
+      int height) {
+    auto camera = Camera(width / static_cast<float>(height));
+    auto frame_buffer = FrameBuffer(width, height);
+    frame_buffer.fill(Color(0));
+    auto depth_buffer = DepthBuffer(width, height);
+    depth_buffer.fill(0);
+    renderer.render(scene, camera, frame_buffer, depth_buffer);
+    return frame_buffer;
+  }
+
+  Mesh make_grid(int size, bool is_facing_camera, Color color) {
+    auto vertices = std::vector<Vertex>();
+    for(auto y = 0; y <= size; ++y) {
+      for(auto x = 0; x <= size; ++x) {
+        vertices.emplace_back(Point(static_cast<float>(x) / size * 2 - 1,
+          static_cast<float>(y) / size * 2 - 1, 0), TextureCoordinate(0, 0),
+          Vector(0, 0, -1));
+      }
+    }
+    auto triangles = std::vector<VertexTriangle>();
+    for(auto y = 0; y != size; ++y) {
+      for(auto x = 0; x != size; ++x) {
+        auto a = x + (size + 1) * y;
+        auto b = a + 1;
+        auto c = a + size + 2;
+        auto d = a + size + 1;
+        if(is_facing_camera) {
+          triangles.push_back({a, c, b});
+          triangles.push_back({a, d, c});
+        } else {
+          triangles.push_back({a, b, c});
+          triangles.push_back({a, c, d});
+        }
+      }
+    }
+    auto fragment = Fragment(std::move(triangles),
+      std::make_shared<Material>(std::make_shared<SolidColorSampler>(color)));
+    return Mesh(std::move(vertices), MeshNode(std::move(fragment)));
+  }
+
+  FrameBuffer render(int thread_count, int width, int height) {
+    auto renderer = TileRenderer(thread_count);
+    return render(renderer, *make_scene(), width, height);
+  }
+}
+
+TEST_SUITE("TileRenderer") {
+  TEST_CASE("thread_count") {
+    CHECK(TileRenderer(1).get_thread_count() == 1);
+    CHECK(TileRenderer(4).get_thread_count() == 4);
+    CHECK(TileRenderer().get_thread_count() >= 1);
+  }
+
+  TEST_CASE("render") {
+    auto frame_buffer = render(1, 200, 150);
+    CHECK(frame_buffer(0, 0) == Color(0));
+    CHECK(is_close(frame_buffer(120, 70), Color(255, 0, 0)));
+    CHECK(is_close(frame_buffer(60, 110), Color(0, 0, 255)));
+  }
+
+  TEST_CASE("guard_band") {
+    auto scene = make_scene();
+    auto& far_quad = scene->get_model(1);
+    far_quad.get_segment(far_quad.get_mesh().m_root).apply(
+      translate(Vector(6, 0, 0)));
+    auto renderer = TileRenderer(1);
+    CHECK(renderer.get_guard_band() == TileRenderer::DEFAULT_GUARD_BAND);
+    auto guarded = render(renderer, *scene, 200, 150);
+    renderer.set_guard_band(1);
+    CHECK(renderer.get_guard_band() == 1);
+    auto clipped = render(renderer, *scene, 200, 150);
+    auto is_identical = true;
+    for(auto y = 0; y != 149; ++y) {
+      for(auto x = 0; x != 199; ++x) {
+        is_identical = is_identical && is_close(guarded(x, y), clipped(x, y));
+      }
+    }
+    CHECK(is_identical);
+    CHECK(is_close(guarded(198, 75), Color(0, 0, 255)));
+    CHECK(is_close(guarded(120, 70), Color(255, 0, 0)));
+  }
+
+  TEST_CASE("back_face_culling") {
+    auto make_flipped_scene = [] (bool is_double_sided) {
+      auto scene = std::make_unique<Scene>();
+      scene->set(AmbientLight(Color(255, 255, 255), 1));
+      auto triangles = std::vector<VertexTriangle>();
+      triangles.push_back({0, 2, 1});
+      triangles.push_back({0, 3, 2});
+      auto model = std::make_unique<Model>(make_quad(std::move(triangles),
+        std::make_shared<Material>(
+          std::make_shared<SolidColorSampler>(Color(255, 0, 0)),
+          is_double_sided)));
+      model->get_segment(model->get_mesh().m_root).apply(
+        translate(Vector(0, 0, 3)));
+      scene->add(std::move(model));
+      return scene;
+    };
+    auto renderer = TileRenderer(1);
+    CHECK(renderer.get_cull_mode() == CullMode::BACK);
+    auto culled = render(renderer, *make_flipped_scene(false), 200, 150);
+    CHECK(culled(100, 75) == Color(0));
+    auto double_sided = render(renderer, *make_flipped_scene(true), 200, 150);
+    CHECK(is_close(double_sided(100, 75), Color(255, 0, 0)));
+    renderer.set_cull_mode(CullMode::NONE);
+    auto unculled = render(renderer, *make_flipped_scene(false), 200, 150);
+    CHECK(is_close(unculled(100, 75), Color(255, 0, 0)));
+  }
+
+  TEST_CASE("multithreaded_render") {
+    auto expected = render(1, 200, 150);
+    for(auto thread_count : {2, 3, 8}) {
+      auto frame_buffer = render(thread_count, 200, 150);
+      auto is_identical = true;
+      for(auto y = 0; y != 150; ++y) {
+        for(auto x = 0; x != 200; ++x) {
+          is_identical = is_identical && frame_buffer(x, y) == expected(x, y);
+        }
+      }
+      CHECK(is_identical);
+    }
+  }
+
+  TEST_CASE("shading_modes") {
+    auto scene = make_scene();
+    auto renderer = TileRenderer(2);
+    CHECK(renderer.get_shading_mode() == ShadingMode::FORWARD);
+    auto forward = render(renderer, *scene, 200, 150);
+    for(auto mode :
+        {ShadingMode::DEPTH_PRE_PASS, ShadingMode::VISIBILITY_BUFFER}) {
+      renderer.set_shading_mode(mode);
+      CHECK(renderer.get_shading_mode() == mode);
+      auto frame_buffer = render(renderer, *scene, 200, 150);
+      auto is_identical = true;
+      for(auto y = 0; y != 150; ++y) {
+        for(auto x = 0; x != 200; ++x) {
+          is_identical =
+            is_identical && is_close(forward(x, y), frame_buffer(x, y));
+        }
+      }
+      CHECK(is_identical);
+      CHECK(frame_buffer(0, 0) == Color(0));
+      CHECK(is_close(frame_buffer(120, 70), Color(255, 0, 0)));
+    }
+  }
+
+  TEST_CASE("back_to_front_depth_pre_pass") {
+    auto vertices = std::vector<Vertex>();
+    auto add_quad = [&] (float x, float y, float size, float left_z,
+        float right_z) {
+      vertices.emplace_back(Point(x - size, y - size, left_z),
+        TextureCoordinate(0, 0), Vector(0, 0, -1));
+      vertices.emplace_back(Point(x - size, y + size, left_z),
+        TextureCoordinate(0, 1), Vector(0, 0, -1));
+      vertices.emplace_back(Point(x + size, y + size, right_z),
+        TextureCoordinate(1, 1), Vector(0, 0, -1));
+      vertices.emplace_back(Point(x + size, y - size, right_z),
+        TextureCoordinate(1, 0), Vector(0, 0, -1));
+    };
+
+    // The nearer quads cover the left ends of the farther quads' rows.
+    add_quad(0.5f, 0, 4, 8, 10);
+    add_quad(-2.5f, 0.2f, 2, 5, 6);
+    add_quad(-3.2f, -0.1f, 1, 3, 3.5f);
+    auto triangles = std::vector<VertexTriangle>();
+    for(auto i = 0; i != 3; ++i) {
+      triangles.push_back({4 * i, 4 * i + 1, 4 * i + 2});
+      triangles.push_back({4 * i, 4 * i + 2, 4 * i + 3});
+    }
+    auto scene = Scene();
+    scene.set(AmbientLight(Color(255, 255, 255), 1));
+    scene.add(std::make_unique<Model>(Mesh(std::move(vertices),
+      MeshNode(Fragment(std::move(triangles), std::make_shared<Material>(
+        std::make_shared<GradientSampler>()))))));
+    auto renderer = TileRenderer(2);
+    auto forward = render(renderer, scene, 200, 150);
+    renderer.set_shading_mode(ShadingMode::DEPTH_PRE_PASS);
+    auto pre_pass = render(renderer, scene, 200, 150);
+    auto difference_count = 0;
+    for(auto y = 0; y != 150; ++y) {
+      for(auto x = 0; x != 200; ++x) {
+        difference_count += pre_pass(x, y) != forward(x, y);
+      }
+    }
+    CHECK(difference_count == 0);
+    CHECK(forward(100, 75) != Color(0));
+  }
+
+  TEST_CASE("out_of_order_depth_pre_pass") {
+    auto vertices = std::vector<Vertex>();
+    auto triangles = std::vector<VertexTriangle>();
+    auto seed = 7u;
+    auto next = [&] (float low, float high) {
+      seed = seed * 1103515245u + 12345u;
+      return low + (high - low) * static_cast<float>(seed >> 8 & 0xFFFF) /
+        0xFFFF;
+    };
+
+    // Slanted triangles at random depths, which overlap and intersect one
+    // another and are submitted in no particular depth order.
+    for(auto i = 0; i != 12; ++i) {
+      auto x = next(-2, 2);
+      auto y = next(-1.5f, 1.5f);
+      auto first = static_cast<int>(vertices.size());
+      for(auto j = 0; j != 3; ++j) {
+        auto angle = 2.1f * j + next(0, 0.5f);
+        vertices.emplace_back(Point(x + 3 * std::cos(angle),
+          y + 3 * std::sin(angle), next(3, 8)),
+          TextureCoordinate(next(0, 1), next(0, 1)), Vector(0, 0, -1));
+      }
+      triangles.push_back({first, first + 2, first + 1});
+    }
+    auto material = std::make_shared<Material>(
+      std::make_shared<GradientSampler>(), true);
+    auto scene = Scene();
+    scene.set(AmbientLight(Color(255, 255, 255), 1));
+    scene.add(std::make_unique<Model>(Mesh(std::move(vertices),
+      MeshNode(Fragment(std::move(triangles), std::move(material))))));
+    auto renderer = TileRenderer(2);
+    auto forward = render(renderer, scene, 200, 150);
+    renderer.set_shading_mode(ShadingMode::DEPTH_PRE_PASS);
+    auto pre_pass = render(renderer, scene, 200, 150);
+    auto difference_count = 0;
+    auto covered_count = 0;
+    for(auto y = 0; y != 150; ++y) {
+      for(auto x = 0; x != 200; ++x) {
+        difference_count += pre_pass(x, y) != forward(x, y);
+        covered_count += forward(x, y) != Color(0);
+      }
+    }
+    CHECK(difference_count == 0);
+    CHECK(covered_count > 200 * 150 / 4);
+  }
+
+  TEST_CASE("occlusion_culling") {
+    auto make_occluded_scene = [] (bool is_occluder) {
+      auto scene = std::make_unique<Scene>();
+      scene->set(AmbientLight(Color(255, 255, 255), 1));
+      auto triangles = std::vector<VertexTriangle>();
+      triangles.push_back({0, 2, 1});
+      triangles.push_back({0, 3, 2});
+      auto occluder = std::make_unique<Model>(make_quad(std::move(triangles),
+        std::make_shared<Material>(
+          std::make_shared<SolidColorSampler>(Color(255, 0, 0)))));
+      occluder->get_segment(occluder->get_mesh().m_root).apply(
+        translate(Vector(0, 0, 3)));
+      occluder->set_occluder(is_occluder);
+      scene->add(std::move(occluder));
+      auto hidden = std::make_unique<Model>(make_quad(Color(0, 0, 255)));
+      hidden->get_segment(hidden->get_mesh().m_root).apply(
+        translate(Vector(0, 0, 6)));
+      scene->add(std::move(hidden));
+      return scene;
+    };
+    auto renderer = TileRenderer(1);
+    auto unoccluded = render(renderer, *make_occluded_scene(false), 200, 150);
+    CHECK(is_close(unoccluded(100, 75), Color(0, 0, 255)));
+    auto occluded = render(renderer, *make_occluded_scene(true), 200, 150);
+    CHECK(occluded(100, 75) == Color(0));
+    auto scene = make_scene();
+    scene->get_model(0).set_occluder(true);
+    auto expected = render(renderer, *make_scene(), 200, 150);
+    auto frame_buffer = render(renderer, *scene, 200, 150);
+    auto is_identical = true;
+    for(auto y = 0; y != 150; ++y) {
+      for(auto x = 0; x != 200; ++x) {
+        is_identical = is_identical && frame_buffer(x, y) == expected(x, y);
+      }
+    }
+    CHECK(is_identical);
+  }
+
+  TEST_CASE("multisampling") {
+    auto scene = make_scene();
+    auto renderer = TileRenderer(2);
+    CHECK(!renderer.is_multisampled());
+    auto expected = render(renderer, *scene, 200, 150);
+    renderer.set_multisampled(true);
+    CHECK(renderer.is_multisampled());
+    auto frame_buffer = render(renderer, *scene, 200, 150);
+    auto is_interior_identical = true;
+    auto blended_count = 0;
+    for(auto y = 1; y != 149; ++y) {
+      for(auto x = 1; x != 199; ++x) {
+        auto is_interior = expected(x - 1, y) == expected(x, y) &&
+          expected(x + 1, y) == expected(x, y) &&
+          expected(x, y - 1) == expected(x, y) &&
+          expected(x, y + 1) == expected(x, y);
+        if(is_interior) {
+          is_interior_identical = is_interior_identical &&
+            is_close(frame_buffer(x, y), expected(x, y));
+        } else if(!is_close(frame_buffer(x, y), expected(x - 1, y)) &&
+            !is_close(frame_buffer(x, y), expected(x + 1, y)) &&
+            !is_close(frame_buffer(x, y), expected(x, y - 1)) &&
+            !is_close(frame_buffer(x, y), expected(x, y + 1))) {
+          ++blended_count;
+        }
+      }
+    }
+    CHECK(is_interior_identical);
+    CHECK(blended_count != 0);
+    CHECK(frame_buffer(0, 0) == Color(0));
+    CHECK(is_close(frame_buffer(120, 70), Color(255, 0, 0)));
+  }
+
+  TEST_CASE("shading_rates") {
+    auto sampler = std::make_shared<CountingSampler>();
+    auto scene = Scene();
+    scene.set(AmbientLight(Color(255, 255, 255), 1));
+    auto triangles = std::vector<VertexTriangle>();
+    triangles.push_back({0, 1, 2});
+    triangles.push_back({0, 2, 3});
+    auto quad = std::make_unique<Model>(
+      make_quad(std::move(triangles), std::make_shared<Material>(sampler)));
+    quad->get_segment(quad->get_mesh().m_root).apply(
+      translate(Vector(0, 0, 3)));
+    scene.add(std::move(quad));
+    auto renderer = TileRenderer(2);
+    CHECK(renderer.get_shading_rates().get_size() == 0);
+    auto expected = render(renderer, scene, 200, 150);
+    for(auto mode : {ShadingMode::FORWARD, ShadingMode::DEPTH_PRE_PASS}) {
+      renderer.set_shading_mode(mode);
+      auto counts = std::array<int, 3>();
+      for(auto rate : {ShadingRate::ONE_BY_ONE, ShadingRate::TWO_BY_TWO,
+          ShadingRate::FOUR_BY_FOUR}) {
+        auto rates = Raster<ShadingRate>(4, 3);
+        rates.fill(rate);
+        renderer.set_shading_rates(std::move(rates));
+        CHECK(renderer.get_shading_rates()(3, 2) == rate);
+        sampler->m_count = 0;
+        auto frame_buffer = render(renderer, scene, 200, 150);
+        counts[static_cast<int>(rate)] = sampler->m_count;
+        auto is_identical = true;
+        for(auto y = 0; y != 150; ++y) {
+          for(auto x = 0; x != 200; ++x) {
+            is_identical = is_identical && frame_buffer(x, y) == expected(x, y);
+          }
+        }
+        CHECK(is_identical);
+      }
+      CHECK(counts[0] != 0);
+      CHECK(3 * counts[1] < counts[0]);
+      CHECK(3 * counts[2] < counts[1]);
+    }
+  }
+
+  TEST_CASE("perspective_correction") {
+    auto scene = Scene();
+    scene.set(AmbientLight(Color(255, 255, 255), 1));
+    auto triangles = std::vector<VertexTriangle>();
+    triangles.push_back({0, 1, 2});
+    triangles.push_back({0, 2, 3});
+    auto quad = std::make_unique<Model>(make_quad(std::move(triangles),
+      std::make_shared<Material>(std::make_shared<GradientSampler>())));
+    auto& segment = quad->get_segment(quad->get_mesh().m_root);
+    segment.apply(scale(2));
+    segment.apply(rotate(Vector(0, 1, 0), 1.f));
+    segment.apply(translate(Vector(0, 0, 3)));
+    scene.add(std::move(quad));
+    auto renderer = TileRenderer(2);
+    CHECK(renderer.get_perspective_correction().m_span == 1);
+    auto expected = render(renderer, scene, 200, 150);
+    auto get_error = [&] (const FrameBuffer& frame_buffer) {
+      auto error = 0;
+      for(auto y = 0; y != 150; ++y) {
+        for(auto x = 0; x != 200; ++x) {
+          error = std::max({error, std::abs(
+            frame_buffer(x, y).get_red() - expected(x, y).get_red()),
+            std::abs(
+              frame_buffer(x, y).get_green() - expected(x, y).get_green())});
+        }
+      }
+      return error;
+    };
+    for(auto mode : {ShadingMode::FORWARD, ShadingMode::DEPTH_PRE_PASS}) {
+      renderer.set_shading_mode(mode);
+      renderer.set_perspective_correction(PerspectiveCorrection(4, 1));
+      auto short_error = get_error(render(renderer, scene, 200, 150));
+      renderer.set_perspective_correction(PerspectiveCorrection(16, 1));
+      CHECK(renderer.get_perspective_correction().m_span == 16);
+      auto long_error = get_error(render(renderer, scene, 200, 150));
+      CHECK(short_error <= 2);
+      CHECK(long_error <= 8);
+      CHECK(long_error > short_error);
+      renderer.set_perspective_correction(PerspectiveCorrection(16, 0.01f));
+      CHECK(get_error(render(renderer, scene, 200, 150)) == 0);
+      renderer.set_perspective_correction(EXACT_PERSPECTIVE_CORRECTION);
+    }
+  }
+
+  TEST_CASE("cleared_buffers") {
+    auto scene = make_scene();
+    auto renderer = TileRenderer(2);
+    auto expected = render(renderer, *scene, 200, 150);
+    auto camera = Camera(200 / 150.f);
+    for(auto is_multisampled : {false, true}) {
+      renderer.set_multisampled(is_multisampled);
+      auto multisampled_expected = render(renderer, *scene, 200, 150);
+      auto frame_buffer = FrameBuffer(200, 150);
+      frame_buffer.fill(Color(1, 2, 3));
+      frame_buffer.clear(Color(0));
+      auto depth_buffer = DepthBuffer(200, 150);
+      depth_buffer.fill(1);
+      depth_buffer.clear(0);
+      renderer.render(*scene, camera, frame_buffer, depth_buffer);
+      frame_buffer.resolve();
+      auto is_identical = true;
+      for(auto y = 0; y != 150; ++y) {
+        for(auto x = 0; x != 200; ++x) {
+          is_identical = is_identical && frame_buffer.data()[y * 200 + x] ==
+            multisampled_expected(x, y);
+        }
+      }
+      CHECK(is_identical);
+    }
+    CHECK(expected(0, 0) == Color(0));
+  }
+
+  TEST_CASE("meshlets") {
+    auto make_grid_scene = [] (bool has_meshlets, bool is_mirrored) {
+      auto scene = std::make_unique<Scene>();
+      scene->set(AmbientLight(Color(255, 255, 255), 1));
+      auto mirror = is_mirrored ? scale_x(-1) : Matrix::IDENTITY();
+      auto add = [&] (Mesh mesh, const Matrix& transformation) {
+        if(has_meshlets) {
+          build_meshlets(mesh);
+          REQUIRE(mesh.m_root.as_fragment().get_meshlets().size() > 1);
+        }
+        auto model = std::make_unique<Model>(std::move(mesh));
+        model->get_segment(model->get_mesh().m_root).apply(
+          transformation * mirror);
+        scene->add(std::move(model));
+      };
+      add(make_grid(16, !is_mirrored, Color(255, 0, 0)),
+        translate(Vector(2, 0, 4)) * scale(4));
+      add(make_grid(16, is_mirrored, Color(0, 0, 255)),
+        translate(Vector(0, 0, 3)));
+      return scene;
+    };
+    auto renderer = TileRenderer(1);
+    for(auto is_mirrored : {false, true}) {
+      for(auto mode : {CullMode::BACK, CullMode::FRONT, CullMode::NONE}) {
+        renderer.set_cull_mode(mode);
+        auto expected =
+          render(renderer, *make_grid_scene(false, is_mirrored), 200, 150);
+        auto expected_count = renderer.get_loaded_triangle_count();
+        auto culled =
+          render(renderer, *make_grid_scene(true, is_mirrored), 200, 150);
+        auto culled_count = renderer.get_loaded_triangle_count();
+        auto is_identical = true;
+        for(auto y = 0; y != 150; ++y) {
+          for(auto x = 0; x != 200; ++x) {
+            is_identical = is_identical && culled(x, y) == expected(x, y);
+          }
+        }
+        CHECK(is_identical);
+        CHECK(culled_count <= expected_count);
+        if(mode == CullMode::BACK) {
+          CHECK(is_close(culled(100, 75), Color(255, 0, 0)));
+          CHECK(2 * culled_count <= expected_count);
+        } else {
+          CHECK(is_close(culled(100, 75), Color(0, 0, 255)));
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,72 @@
+#include <numbers>
+#include <doctest/doctest.h>
+#include "Ashkal/VertexBatch.hpp"
+#include "Ashkal/VertexCache.hpp"
+
+using namespace Ashkal;
+
+namespace {
+  Vertex make_vertex(int i) {
+    auto t = static_cast<float>(i);
+    return Vertex(Point(t - 5, 2 * t - 3, 0.5f * t),
+      TextureCoordinate(0, 0), Vector(1 - t / 4, 1, t / 8 - 1));
+  }
+
+  void check_equal(const Point& left, const Point& right) {
+    CHECK(left.m_x == doctest::Approx(right.m_x).epsilon(1e-4));
+    CHECK(left.m_y == doctest::Approx(right.m_y).epsilon(1e-4));
+    CHECK(left.m_z == doctest::Approx(right.m_z).epsilon(1e-4));
+  }
+}
+
+TEST_SUITE("VertexBatch") {
+  TEST_CASE("resize") {
+    auto batch = VertexBatch();
+    resize(batch, LANE_COUNT + 1);
+    CHECK(batch.m_size == LANE_COUNT + 1);
+    CHECK(batch.m_x.size() == 2 * LANE_COUNT);
+    CHECK(batch.m_intensity.size() == 2 * LANE_COUNT);
+    set(batch, LANE_COUNT, Point(1, 2, 3), Vector(4, 5, 6));
+    CHECK(get_position(batch, LANE_COUNT) == Point(1, 2, 3));
+    CHECK(get_normal(batch, LANE_COUNT) == Vector(4, 5, 6));
+  }
+
+  TEST_CASE("view_transformation") {
+    auto camera = Camera(1);
+    camera.apply(translate(Vector(1, -2, 3)) *
+      yaw(std::numbers::pi_v<float> / 3) * pitch(0.4f));
+    auto view = make_view_transformation(camera);
+    for(auto i = 0; i != 5; ++i) {
+      auto point = make_vertex(i).m_position;
+      check_equal(view * point, world_to_view(point, camera));
+    }
+  }
+
+  TEST_CASE("transform") {
+    const auto COUNT = 2 * LANE_COUNT + 3;
+    auto scene = Scene();
+    scene.set(AmbientLight(Color(40, 40, 40), 0.25f));
+    scene.set(
+      DirectionalLight(normalize(Vector(1, -1, 2)), Color(200, 0, 100), 1));
+    auto camera = Camera(1);
+    camera.apply(translate(Vector(0, 1, -4)) * yaw(0.3f));
+    auto transformation = translate(Vector(2, 0, 5)) *
+      rotate(normalize(Vector(1, 1, 0)), 0.7f) * scale(1.5f);
+    auto batch = VertexBatch();
+    resize(batch, COUNT);
+    for(auto i = 0; i != COUNT; ++i) {
+      auto vertex = make_vertex(i);
+      set(batch, i, vertex.m_position, vertex.m_normal);
+    }
+    transform(batch, transformation, scene, camera);
+    for(auto i = 0; i != COUNT; ++i) {
+      auto expected = shade(make_vertex(i), transformation, scene, camera);
+      check_equal(get_position(batch, i), expected.m_position);
+      CHECK(batch.m_intensity[i] ==
+        doctest::Approx(expected.m_shading.m_intensity).epsilon(1e-4));
+      CHECK(get_light_color(scene) == expected.m_shading.m_color);
+      auto normal = get_normal(batch, i);
+      CHECK(dot(normal, normal) == doctest::Approx(1).epsilon(1e-4));
+    }
+  }
+}
@@ -0,0 +1,90 @@
+#include <vector>
+#include <doctest/doctest.h>
+#include "Ashkal/VertexCache.hpp"
+
+using namespace Ashkal;
+
+namespace {
+  std::vector<Vertex> make_vertices() {
+    auto vertices = std::vector<Vertex>();
+    vertices.emplace_back(
+      Point(-1, -1, 0), TextureCoordinate(0, 0), Vector(0, 0, -1));
+    vertices.emplace_back(
+      Point(-1, 1, 0), TextureCoordinate(0, 1), Vector(0, 0, -1));
+    vertices.emplace_back(
+      Point(1, 1, 0), TextureCoordinate(1, 1), Vector(1, 0, 0));
+    vertices.emplace_back(
+      Point(1, -1, 0), TextureCoordinate(1, 0), Vector(0, 1, 0));
+    vertices.emplace_back(
+      Point(2, 2, 2), TextureCoordinate(0.5f, 0.5f), Vector(0, 0, 1));
+    return vertices;
+  }
+
+  void require_equal(const Point& left, const Point& right) {
+    REQUIRE(left.m_x == doctest::Approx(right.m_x));
+    REQUIRE(left.m_y == doctest::Approx(right.m_y));
+    REQUIRE(left.m_z == doctest::Approx(right.m_z));
+  }
+}
+
+TEST_SUITE("VertexCache") {
+  TEST_CASE("slots") {
+    auto vertices = make_vertices();
+    auto triangles = std::vector<VertexTriangle>();
+    triangles.push_back({3, 1, 2});
+    triangles.push_back({3, 2, 0});
+    triangles.push_back({0, 2, 1});
+    auto cache = VertexCache();
+    cache.load(triangles, vertices, Matrix::IDENTITY(), Camera(1));
+    REQUIRE(cache.get_size() == 4);
+    CHECK(cache.get_index(0) == 3);
+    CHECK(cache.get_index(1) == 1);
+    CHECK(cache.get_index(2) == 2);
+    CHECK(cache.get_index(3) == 0);
+    auto& loaded = cache.get_triangles();
+    REQUIRE(loaded.size() == 3);
+    for(auto i = std::size_t(0); i != triangles.size(); ++i) {
+      CHECK(cache.get_index(loaded[i].m_a) == triangles[i].m_a);
+      CHECK(cache.get_index(loaded[i].m_b) == triangles[i].m_b);
+      CHECK(cache.get_index(loaded[i].m_c) == triangles[i].m_c);
+    }
+    auto other_triangles = std::vector<VertexTriangle>();
+    other_triangles.push_back({4, 0, 4});
+    cache.load(other_triangles, vertices, Matrix::IDENTITY(), Camera(1));
+    REQUIRE(cache.get_size() == 2);
+    CHECK(cache.get_index(0) == 4);
+    CHECK(cache.get_index(1) == 0);
+    REQUIRE(cache.get_triangles().size() == 1);
+    CHECK(cache.get_triangles()[0].m_a == 0);
+    CHECK(cache.get_triangles()[0].m_b == 1);
+    CHECK(cache.get_triangles()[0].m_c == 0);
+  }
+
+  TEST_CASE("shade") {
+    auto vertices = make_vertices();
+    auto triangles = std::vector<VertexTriangle>();
+    triangles.push_back({0, 1, 2});
+    triangles.push_back({2, 3, 4});
+    auto scene = Scene();
+    scene.set(AmbientLight(Color(255, 255, 255), 0.25f));
+    scene.set(DirectionalLight(Vector(0, 0, 1), Color(255, 0, 0), 0.5f));
+    auto camera = Camera(1);
+    auto transformation = translate(Vector(0.5f, 0.25f, 3)) * scale(2);
+    auto cache = VertexCache();
+    cache.load(triangles, vertices, transformation, camera);
+    REQUIRE(cache.get_size() == 5);
+    for(auto slot = 0; slot != cache.get_size(); ++slot) {
+      auto& vertex = vertices[cache.get_index(slot)];
+      auto expected = shade(vertex, transformation, scene, camera);
+      require_equal(cache.get_position(slot), expected.m_position);
+      auto& shaded = cache.get_shaded(slot, scene);
+      require_equal(shaded.m_position, expected.m_position);
+      CHECK(shaded.m_uv.m_u == expected.m_uv.m_u);
+      CHECK(shaded.m_uv.m_v == expected.m_uv.m_v);
+      CHECK(shaded.m_shading.m_color == expected.m_shading.m_color);
+      CHECK(shaded.m_shading.m_intensity ==
+        doctest::Approx(expected.m_shading.m_intensity));
+      CHECK(&cache.get_shaded(slot, scene) == &shaded);
+    }
+  }
+}